@@ -7,6 +7,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <thread>
 
@@ -81,6 +82,8 @@ struct CommandLineOptions {
   static constexpr std::uint32_t c_defaultRecordTimeToLiveInSeconds = 300;
   static constexpr std::uint64_t c_defaultCacheSizeInBytes = 1024 * 1024 * 1024;
   static constexpr bool c_defaultForceTimeBasedEviction = false;
+  static constexpr const char* c_defaultEngine = "chained";
+  static constexpr const char* c_defaultBucketLock = "rwlock";
 
   std::string m_module;
   std::size_t m_dataSetSize = 0;
@@ -92,6 +95,9 @@ struct CommandLineOptions {
   std::uint16_t m_numThreads = 0;
   std::uint32_t m_epochProcessingIntervalInMilli;
   std::uint8_t m_numActionsQueue = 0;
+  std::string m_engine = c_defaultEngine;
+  bool m_hugePages = false;
+  std::string m_bucketLock = c_defaultBucketLock;
 
   // The followings are specific for cache hash tables.
   std::uint32_t m_recordTimeToLiveInSeconds = 0U;
@@ -103,6 +109,42 @@ struct CommandLineOptions {
     return m_module.substr(0, c_cachingModulePrefix.size()) ==
            c_cachingModulePrefix;
   }
+
+  L4::HashTableConfig::Engine GetEngine() const {
+    if (m_engine == "open-addressing") {
+      return L4::HashTableConfig::Engine::OpenAddressing;
+    }
+
+    if (m_engine == "cuckoo") {
+      return L4::HashTableConfig::Engine::Cuckoo;
+    }
+
+    if (m_engine != "chained") {
+      throw std::invalid_argument("Unknown engine: " + m_engine);
+    }
+
+    return L4::HashTableConfig::Engine::Chained;
+  }
+
+  L4::HashTableConfig::BucketLock GetBucketLock() const {
+    if (m_bucketLock == "spin") {
+      return L4::HashTableConfig::BucketLock::Spin;
+    }
+
+    if (m_bucketLock == "ticket") {
+      return L4::HashTableConfig::BucketLock::Ticket;
+    }
+
+    if (m_bucketLock == "adaptive") {
+      return L4::HashTableConfig::BucketLock::Adaptive;
+    }
+
+    if (m_bucketLock != "rwlock") {
+      throw std::invalid_argument("Unknown bucket lock: " + m_bucketLock);
+    }
+
+    return L4::HashTableConfig::BucketLock::ReaderWriter;
+  }
 };
 
 class DataGenerator {
@@ -201,6 +243,9 @@ void PrintOptions(const CommandLineOptions& options) {
          options.m_epochProcessingIntervalInMilli);
   printf("%39s | %10lu |\n", "Number of actions queue",
          options.m_numActionsQueue);
+  printf("%39s | %10s |\n", "Engine", options.m_engine.c_str());
+  printf("%39s | %10lu |\n", "Huge pages", options.m_hugePages);
+  printf("%39s | %10s |\n", "Bucket lock", options.m_bucketLock.c_str());
 
   if (options.IsCachingModule()) {
     printf("%39s | %10lu |\n", "Record time to live (s)",
@@ -227,7 +272,11 @@ void PrintHashTableCounters(const L4::HashTablePerfData& perfData) {
 
 L4::HashTableConfig CreateHashTableConfig(const CommandLineOptions& options) {
   return L4::HashTableConfig(
-      "Table1", L4::HashTableConfig::Setting{options.m_numBuckets},
+      "Table1",
+      L4::HashTableConfig::Setting{options.m_numBuckets, {}, {}, {}, {}, {},
+                                   {}, options.GetEngine(),
+                                   options.m_hugePages,
+                                   options.GetBucketLock()},
       options.IsCachingModule()
           ? boost::optional<
                 L4::HashTableConfig::Cache>{L4::HashTableConfig::Cache{
@@ -573,7 +622,17 @@ CommandLineOptions Parse(int argc, char** argv) {
       "forceTimeBasedEviction",
       po::value<bool>()->default_value(
           CommandLineOptions::c_defaultForceTimeBasedEviction),
-      "force time based eviction");
+      "force time based eviction")(
+      "engine",
+      po::value<std::string>()->default_value(
+          CommandLineOptions::c_defaultEngine),
+      "hash table engine: chained, open-addressing or cuckoo")(
+      "hugePages", "back the bucket array with huge pages if available")(
+      "bucketLock",
+      po::value<std::string>()->default_value(
+          CommandLineOptions::c_defaultBucketLock),
+      "bucket lock for the chained engine: rwlock, spin, ticket or "
+      "adaptive");
 
   po::options_description all("Allowed options");
   all.add(general).add(benchmarkOptions);
@@ -629,6 +688,15 @@ CommandLineOptions Parse(int argc, char** argv) {
       options.m_forceTimeBasedEviction =
           vm["forceTimeBasedEviction"].as<bool>();
     }
+    if (vm.count("engine")) {
+      options.m_engine = vm["engine"].as<std::string>();
+    }
+    if (vm.count("hugePages")) {
+      options.m_hugePages = true;
+    }
+    if (vm.count("bucketLock")) {
+      options.m_bucketLock = vm["bucketLock"].as<std::string>();
+    }
   } else {
     std::cout << all;
   }
@@ -1,6 +1,9 @@
 #include <algorithm>
 #include <boost/test/unit_test.hpp>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 #include "CheckedAllocator.h"
 #include "L4/HashTable/Cache/HashTable.h"
 #include "L4/HashTable/Cache/Metadata.h"
@@ -110,19 +113,22 @@ BOOST_AUTO_TEST_CASE(MetadataTest) {
   for (std::uint16_t i = 0U; i < 8U; ++i) {
     std::uint32_t* metadataBuffer =
         reinterpret_cast<std::uint32_t*>(buffer.data() + i);
-    seconds currentEpochTime{0x7FABCDEF};
+    seconds currentEpochTime{0x0FABCDEF};
 
-    Metadata metadata{metadataBuffer, currentEpochTime};
+    Metadata metadata{metadataBuffer, currentEpochTime, seconds{10U}};
 
-    BOOST_CHECK(currentEpochTime == metadata.GetEpochTime());
+    BOOST_CHECK(currentEpochTime + seconds{10U} ==
+                metadata.GetExpirationTime());
 
-    // 10 seconds have elapsed.
-    currentEpochTime += seconds{10U};
+    // Check the expiration based on the elapsed time.
+    BOOST_CHECK(!metadata.IsExpired(currentEpochTime + seconds{5U}));
+    BOOST_CHECK(!metadata.IsExpired(currentEpochTime + seconds{10U}));
+    BOOST_CHECK(metadata.IsExpired(currentEpochTime + seconds{15U}));
 
-    // Check the expiration based on the time to live value.
-    BOOST_CHECK(!metadata.IsExpired(currentEpochTime, seconds{15}));
-    BOOST_CHECK(!metadata.IsExpired(currentEpochTime, seconds{10}));
-    BOOST_CHECK(metadata.IsExpired(currentEpochTime, seconds{5U}));
+    // The expiration time is capped at the largest epoch time stored.
+    Metadata neverExpired{metadataBuffer, currentEpochTime, seconds::max()};
+    BOOST_CHECK(seconds{0x0FFFFFFF} == neverExpired.GetExpirationTime());
+    BOOST_CHECK(!neverExpired.IsExpired(seconds{0x0FFFFFFF}));
 
     // Test access state.
     BOOST_CHECK(!metadata.IsAccessed());
@@ -132,6 +138,29 @@ BOOST_AUTO_TEST_CASE(MetadataTest) {
 
     metadata.UpdateAccessStatus(false);
     BOOST_CHECK(!metadata.IsAccessed());
+
+    // Test the access count, which saturates.
+    for (std::uint8_t count = 1U; count <= 5U; ++count) {
+      metadata.UpdateAccessStatus(true);
+      BOOST_CHECK_EQUAL(metadata.GetAccessCount(),
+                        (std::min)(count, static_cast<std::uint8_t>(
+                                              Metadata::c_maxAccessCount)));
+    }
+
+    BOOST_CHECK(metadata.DecrementAccessCount());
+    BOOST_CHECK_EQUAL(metadata.GetAccessCount(), 2U);
+
+    // Test the eviction state, which is independent of the other fields.
+    for (std::uint8_t state = 0U; state < Metadata::c_numEvictionStates;
+         ++state) {
+      metadata.SetEvictionState(state);
+      BOOST_CHECK_EQUAL(metadata.GetEvictionState(), state);
+      BOOST_CHECK_EQUAL(metadata.GetAccessCount(), 2U);
+      BOOST_CHECK(seconds{0x0FFFFFFF} == metadata.GetExpirationTime());
+    }
+
+    BOOST_CHECK(metadata.UpdateAccessStatus(false));
+    BOOST_CHECK(!metadata.DecrementAccessCount());
   }
 }
 
@@ -200,6 +229,108 @@ BOOST_FIXTURE_TEST_CASE(ExpirationTest, CacheHashTableTestFixture) {
                            {HashTablePerfCounter::CacheMissCount, 7}});
 }
 
+BOOST_FIXTURE_TEST_CASE(MultiGetTest, CacheHashTableTestFixture) {
+  // Don't care about evict in this test case, so make the cache size big.
+  constexpr std::uint64_t c_maxCacheSizeInBytes = 0xFFFFFFFF;
+  constexpr seconds c_recordTimeToLive{20U};
+
+  CacheHashTable hashTable(m_hashTable, m_epochManager, c_maxCacheSizeInBytes,
+                           c_recordTimeToLive, false);
+
+  const std::vector<std::string> c_keys = {"key1", "key2", "key3", "key4"};
+  const std::vector<std::string> c_vals = {"val1", "val2", "val3", "val4"};
+
+  // key1 is created at 10, key2 at 20 and key3 at 30. key4 is not added.
+  for (std::size_t i = 0; i < 3U; ++i) {
+    MockClock::IncrementEpochTime(seconds{10});
+    Add(hashTable, c_keys[i], c_vals[i]);
+  }
+
+  // The clock becomes 35 and key1 should expire.
+  MockClock::IncrementEpochTime(seconds{5});
+
+  std::vector<IReadOnlyHashTable::Key> keys;
+  for (const auto& key : c_keys) {
+    keys.emplace_back(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(key.c_str()));
+  }
+
+  std::vector<IReadOnlyHashTable::Value> values(keys.size());
+  bool found[4];
+
+  BOOST_CHECK_EQUAL(
+      hashTable.MultiGet(keys.data(), keys.size(), values.data(), found), 2U);
+
+  BOOST_CHECK(!found[0]);
+  BOOST_CHECK(found[1] && AreTheSame(values[1], c_vals[1]));
+  BOOST_CHECK(found[2] && AreTheSame(values[2], c_vals[2]));
+  BOOST_CHECK(!found[3]);
+
+  Utils::ValidateCounters(hashTable.GetPerfData(),
+                          {{HashTablePerfCounter::CacheHitCount, 2},
+                           {HashTablePerfCounter::CacheMissCount, 2}});
+}
+
+BOOST_FIXTURE_TEST_CASE(UpsertTest, CacheHashTableTestFixture) {
+  // Appends the operand to the existing value.
+  struct AppendMergeOperator : public IWritableHashTable::IMergeOperator {
+    IReadOnlyHashTable::Value::size_type GetMergedSize(
+        const IReadOnlyHashTable::Value* existingValue,
+        const IReadOnlyHashTable::Value& operand) const override {
+      return ((existingValue != nullptr) ? existingValue->m_size : 0U) +
+             operand.m_size;
+    }
+
+    void Merge(const IReadOnlyHashTable::Value* existingValue,
+               const IReadOnlyHashTable::Value& operand,
+               std::uint8_t* buffer) const override {
+      if (existingValue != nullptr) {
+        memcpy(buffer, existingValue->m_data, existingValue->m_size);
+        buffer += existingValue->m_size;
+      }
+
+      memcpy(buffer, operand.m_data, operand.m_size);
+    }
+  };
+
+  // Don't care about evict in this test case, so make the cache size big.
+  constexpr std::uint64_t c_maxCacheSizeInBytes = 0xFFFFFFFF;
+  constexpr seconds c_recordTimeToLive{20U};
+
+  CacheHashTable hashTable(m_hashTable, m_epochManager, c_maxCacheSizeInBytes,
+                           c_recordTimeToLive, false);
+
+  const AppendMergeOperator appendMergeOperator;
+  const auto upsert = [&](const std::string& key, const std::string& operand) {
+    hashTable.Upsert(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(key.c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(operand.c_str()),
+        appendMergeOperator);
+  };
+
+  // The merge operator sees the value without the metadata.
+  Add(hashTable, "key1", "val1");
+  upsert("key1", "+a");
+  BOOST_CHECK(CheckRecord(hashTable, "key1", "val1+a"));
+
+  // The merged record is timestamped as a new one.
+  MockClock::IncrementEpochTime(seconds{15});
+  upsert("key1", "+b");
+  MockClock::IncrementEpochTime(seconds{15});
+  BOOST_CHECK(CheckRecord(hashTable, "key1", "val1+a+b"));
+
+  // The expired record is merged as if it does not exist.
+  MockClock::IncrementEpochTime(seconds{30});
+  upsert("key1", "val2");
+  BOOST_CHECK(CheckRecord(hashTable, "key1", "val2"));
+
+  Utils::ValidateCounters(hashTable.GetPerfData(),
+                          {{HashTablePerfCounter::RecordsCount, 1},
+                           {HashTablePerfCounter::TotalKeySize, 4},
+                           {HashTablePerfCounter::TotalValueSize,
+                            4 + Metadata::c_metaDataSize}});
+}
+
 BOOST_FIXTURE_TEST_CASE(CacheHashTableIteratorTest, CacheHashTableTestFixture) {
   // Don't care about evict in this test case, so make the cache size big.
   constexpr std::uint64_t c_maxCacheSizeInBytes = 0xFFFFFFFF;
@@ -255,6 +386,22 @@ BOOST_FIXTURE_TEST_CASE(CacheHashTableIteratorTest, CacheHashTableTestFixture) {
 
   BOOST_CHECK_EQUAL(numRecords, 2);
 
+  // ParallelForEach() also skips the expired records and strips the metadata.
+  std::vector<std::vector<std::pair<std::string, std::string>>> records(2U);
+  hashTable.ParallelForEach(
+      [&records](std::uint16_t threadIndex, const IReadOnlyHashTable::Key& key,
+                 const IReadOnlyHashTable::Value& value) {
+        records[threadIndex].emplace_back(Utils::ConvertToString(key),
+                                          Utils::ConvertToString(value));
+      },
+      2U);
+
+  records[0].insert(records[0].end(), records[1].begin(), records[1].end());
+  std::sort(records[0].begin(), records[0].end());
+  BOOST_CHECK(records[0] ==
+              (std::vector<std::pair<std::string, std::string>>{
+                  {"key4", "val4"}, {"key5", "val5"}}));
+
   // The clock becomes 40 and all records should be expired now.
   MockClock::IncrementEpochTime(seconds{10});
 
@@ -322,6 +469,77 @@ BOOST_FIXTURE_TEST_CASE(TimeBasedEvictionTest, CacheHashTableTestFixture) {
                           });
 }
 
+BOOST_FIXTURE_TEST_CASE(PerRecordTimeToLiveTest, CacheHashTableTestFixture) {
+  constexpr std::uint64_t c_maxCacheSizeInBytes = 0xFFFFFFFF;
+  constexpr seconds c_recordTimeToLive{10U};
+
+  HashTable internalHashTable{HashTable::Setting{1}, m_allocator};
+  CacheHashTable hashTable(internalHashTable, m_epochManager,
+                           c_maxCacheSizeInBytes, c_recordTimeToLive, true);
+
+  // "key1" gets the default time to live of the hash table.
+  Add(hashTable, "key1", "value1");
+  for (const auto timeToLive : {5U, 20U, 30U}) {
+    const auto key = "key" + std::to_string(timeToLive);
+    const auto value = "value" + std::to_string(timeToLive);
+    hashTable.Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(key.c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(value.c_str()),
+        seconds{timeToLive});
+  }
+
+  auto checkRecords = [&](const std::vector<std::string>& expectedKeys) {
+    for (const auto* key : {"key1", "key5", "key20", "key30"}) {
+      const bool isExpected =
+          std::find(expectedKeys.cbegin(), expectedKeys.cend(), key) !=
+          expectedKeys.cend();
+      IReadOnlyHashTable::Value value;
+      BOOST_CHECK_EQUAL(Get(hashTable, key, value), isExpected);
+    }
+
+    std::vector<std::string> iteratedKeys;
+    auto iterator = hashTable.GetIterator();
+    while (iterator->MoveNext()) {
+      const auto& key = iterator->GetKey();
+      iteratedKeys.emplace_back(reinterpret_cast<const char*>(key.m_data),
+                                key.m_size);
+    }
+    std::sort(iteratedKeys.begin(), iteratedKeys.end());
+
+    auto sortedKeys = expectedKeys;
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    BOOST_CHECK(iteratedKeys == sortedKeys);
+  };
+
+  checkRecords({"key1", "key5", "key20", "key30"});
+
+  MockClock::IncrementEpochTime(seconds{6});
+  checkRecords({"key1", "key20", "key30"});
+
+  MockClock::IncrementEpochTime(seconds{5});
+  checkRecords({"key20", "key30"});
+
+  MockClock::IncrementEpochTime(seconds{10});
+  checkRecords({"key30"});
+
+  const auto& perfData = hashTable.GetPerfData();
+  Utils::ValidateCounters(perfData,
+                          {
+                              {HashTablePerfCounter::RecordsCount, 4},
+                              {HashTablePerfCounter::EvictedRecordsCount, 0},
+                          });
+
+  // Adding a record evicts only the records whose own time to live passed.
+  Add(hashTable, "key1", "value1");
+
+  Utils::ValidateCounters(perfData,
+                          {
+                              {HashTablePerfCounter::RecordsCount, 2},
+                              {HashTablePerfCounter::EvictedRecordsCount, 3},
+                          });
+  checkRecords({"key1", "key30"});
+}
+
 BOOST_FIXTURE_TEST_CASE(EvcitAllRecordsTest, CacheHashTableTestFixture) {
   const auto& perfData = m_hashTable.m_perfData;
   const auto initialTotalIndexSize =
@@ -441,8 +659,254 @@ BOOST_FIXTURE_TEST_CASE(EvcitRecordsBasedOnAccessStatusTest,
   BOOST_CHECK(CheckRecord(hashTable, "newkey", c_valStr));
 }
 
+BOOST_FIXTURE_TEST_CASE(EvictionPolicyTest, CacheHashTableTestFixture) {
+  using EvictionPolicy = CacheHashTable::EvictionPolicy;
+
+  const std::string c_valStr(100, 'v');
+  const std::vector<std::string> c_hotKeys = {"hot1", "hot2", "hot3"};
+
+  // Returns the keys in the given hash table without updating the access
+  // counts.
+  auto getKeys = [](const CacheHashTable& hashTable) {
+    std::vector<std::string> keys;
+    auto iterator = hashTable.GetIterator();
+    while (iterator->MoveNext()) {
+      const auto& key = iterator->GetKey();
+      keys.emplace_back(reinterpret_cast<const char*>(key.m_data), key.m_size);
+    }
+    return keys;
+  };
+
+  // The number of the evictions of a single bucket that the frequently
+  // accessed records survive while the other records are scanned.
+  const std::vector<std::pair<EvictionPolicy, std::uint32_t>> c_policies = {
+      {EvictionPolicy::Clock, 1U},
+      {EvictionPolicy::S3Fifo, 4U},
+      {EvictionPolicy::ClockPro, 2U}};
+
+  for (const auto& policy : c_policies) {
+    // With one bucket, each eviction passes all the records once.
+    HashTable internalHashTable{HashTable::Setting{1}, m_allocator};
+    const auto& perfData = internalHashTable.m_perfData;
+    const std::uint64_t c_maxCacheSizeInBytes =
+        1000 + perfData.Get(HashTablePerfCounter::TotalIndexSize);
+
+    CacheHashTable hashTable(internalHashTable, m_epochManager,
+                             c_maxCacheSizeInBytes, seconds{100}, false,
+                             policy.first);
+
+    for (const auto& key : c_hotKeys) {
+      Add(hashTable, key, c_valStr);
+      for (int i = 0; i < 3; ++i) {
+        BOOST_CHECK(CheckRecord(hashTable, key, c_valStr));
+      }
+    }
+
+    std::uint32_t numEvictions = 0U;
+    std::uint32_t scanKey = 0U;
+    while (numEvictions <= policy.second + 1U) {
+      const auto numEvicted =
+          perfData.Get(HashTablePerfCounter::EvictedRecordsCount);
+      Add(hashTable, "scan" + std::to_string(scanKey++), c_valStr);
+
+      if (perfData.Get(HashTablePerfCounter::EvictedRecordsCount) ==
+          numEvicted) {
+        continue;
+      }
+      ++numEvictions;
+
+      const auto keys = getKeys(hashTable);
+      for (const auto& key : c_hotKeys) {
+        BOOST_CHECK_EQUAL(
+            std::find(keys.cbegin(), keys.cend(), key) != keys.cend(),
+            numEvictions <= policy.second);
+      }
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(EvictionPolicyGhostKeyTest,
+                        CacheHashTableTestFixture) {
+  using EvictionPolicy = CacheHashTable::EvictionPolicy;
+
+  // Only two records fit, so that few keys are added to the ghost table.
+  const std::string c_valStr(450, 'v');
+
+  HashTable internalHashTable{HashTable::Setting{1}, m_allocator};
+  const auto& perfData = internalHashTable.m_perfData;
+  const std::uint64_t c_maxCacheSizeInBytes =
+      1000 + perfData.Get(HashTablePerfCounter::TotalIndexSize);
+
+  CacheHashTable hashTable(internalHashTable, m_epochManager,
+                           c_maxCacheSizeInBytes, seconds{100}, false,
+                           EvictionPolicy::ClockPro);
+
+  // Adds the records until the single bucket is evicted.
+  std::uint32_t scanKey = 0U;
+  auto scanUntilEviction = [&]() {
+    const auto numEvicted =
+        perfData.Get(HashTablePerfCounter::EvictedRecordsCount);
+    while (perfData.Get(HashTablePerfCounter::EvictedRecordsCount) ==
+           numEvicted) {
+      Add(hashTable, "scan" + std::to_string(scanKey++), c_valStr);
+    }
+  };
+
+  auto contains = [&](const std::string& key) {
+    auto iterator = hashTable.GetIterator();
+    while (iterator->MoveNext()) {
+      const auto& iteratedKey = iterator->GetKey();
+      if (key == std::string(reinterpret_cast<const char*>(iteratedKey.m_data),
+                             iteratedKey.m_size)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // A new record that is not accessed is evicted in its test period.
+  Add(hashTable, "ghost", c_valStr);
+  scanUntilEviction();
+  BOOST_CHECK(!contains("ghost"));
+
+  // Added again, it is hot, thus it is demoted to cold instead of evicted.
+  Add(hashTable, "ghost", c_valStr);
+  scanUntilEviction();
+  BOOST_CHECK(contains("ghost"));
+
+  scanUntilEviction();
+  BOOST_CHECK(!contains("ghost"));
+}
+
+BOOST_FIXTURE_TEST_CASE(BackgroundEvictionTest, CacheHashTableTestFixture) {
+  const auto& perfData = m_hashTable.m_perfData;
+  // The low watermark should be above the size of the bucket array, which is
+  // counted as TotalIndexSize.
+  const std::uint64_t c_maxCacheSizeInBytes =
+      100000 + perfData.Get(HashTablePerfCounter::TotalIndexSize);
+  const std::uint64_t c_lowWatermarkInBytes = c_maxCacheSizeInBytes / 2;
+  const std::uint64_t c_highWatermarkInBytes = c_maxCacheSizeInBytes * 8 / 10;
+
+  CacheHashTable hashTable(
+      m_hashTable, m_epochManager, c_maxCacheSizeInBytes, seconds{100}, false,
+      CacheHashTable::EvictionPolicy::Clock,
+      CacheHashTable::BackgroundEviction{0.5, 0.8});
+
+  const auto getTotalDataSize = [&perfData]() {
+    return static_cast<std::uint64_t>(
+        perfData.Get(HashTablePerfCounter::TotalKeySize) +
+        perfData.Get(HashTablePerfCounter::TotalValueSize) +
+        perfData.Get(HashTablePerfCounter::TotalIndexSize));
+  };
+
+  const std::string c_valStr(100, 'v');
+  std::uint32_t key = 0U;
+  const auto addUntil = [&](std::uint64_t totalDataSize) {
+    while (getTotalDataSize() < totalDataSize) {
+      Add(hashTable, "key" + std::to_string(key++), c_valStr);
+    }
+  };
+
+  // Nothing is evicted below the high watermark.
+  addUntil(c_highWatermarkInBytes - 200);
+  BOOST_CHECK_EQUAL(hashTable.EvictToWatermark(), 0U);
+
+  // Above the high watermark, it evicts down to the low watermark.
+  addUntil(c_highWatermarkInBytes + 1);
+  const auto numEvicted = hashTable.EvictToWatermark();
+  BOOST_CHECK_GT(numEvicted, 0U);
+  BOOST_CHECK_LE(getTotalDataSize(), c_lowWatermarkInBytes);
+
+  Utils::ValidateCounters(
+      perfData,
+      {{HashTablePerfCounter::EvictedRecordsCount, numEvicted},
+       {HashTablePerfCounter::BackgroundEvictedRecordsCount, numEvicted},
+       {HashTablePerfCounter::InlineEvictionsCount, 0}});
+
+  // The writers still evict inline past the max cache size.
+  addUntil(c_maxCacheSizeInBytes - 200);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::InlineEvictionsCount),
+                    0);
+
+  for (std::uint32_t i = 0U; i < 10U; ++i) {
+    Add(hashTable, "key" + std::to_string(key++), c_valStr);
+  }
+  BOOST_CHECK_GT(perfData.Get(HashTablePerfCounter::InlineEvictionsCount), 0);
+  BOOST_CHECK_LE(getTotalDataSize(), c_maxCacheSizeInBytes);
+
+  // Without the background eviction configured, nothing is evicted.
+  CacheHashTable noBackgroundHashTable(m_hashTable, m_epochManager,
+                                       c_maxCacheSizeInBytes, seconds{100},
+                                       false);
+  BOOST_CHECK_EQUAL(noBackgroundHashTable.EvictToWatermark(), 0U);
+}
+
 // This is similar to the one in ReadWriteHashTableTest, but necessary since
 // cache store adds the meta values.
+BOOST_FIXTURE_TEST_CASE(EvictionShardTest, CacheHashTableTestFixture) {
+  const auto& perfData = m_hashTable.m_perfData;
+  const std::uint64_t c_maxCacheSizeInBytes =
+      10000 + perfData.Get(HashTablePerfCounter::TotalIndexSize);
+  constexpr std::uint16_t c_numEvictionShards = 4U;
+
+  CacheHashTable hashTable(m_hashTable, m_epochManager, c_maxCacheSizeInBytes,
+                           seconds{100}, false,
+                           CacheHashTable::EvictionPolicy::Clock, {},
+                           c_numEvictionShards);
+
+  // Returns the eviction shard of the given key, which is found by looking up
+  // the bucket that has the key. The 100 buckets are split into 4 shards of
+  // 25 buckets.
+  const CacheHashTable::RecordSerializer recordSerializer{
+      0U, 0U, Metadata::c_metaDataSize};
+  const auto getShard = [&](const std::string& key) {
+    const auto& buckets = m_hashTable.GetBuckets();
+    for (std::uint32_t i = 0U; i < buckets.size(); ++i) {
+      for (auto* entry = &buckets[i]; entry != nullptr;
+           entry = entry->m_next.Load()) {
+        for (const auto& data : entry->m_dataList) {
+          if (data.Load() != nullptr &&
+              Exist(recordSerializer.Deserialize(*data.Load()).m_key, {key})) {
+            return static_cast<int>(i / 25U);
+          }
+        }
+      }
+    }
+    return -1;
+  };
+
+  // Add the records until the first inline eviction, remembering the shard of
+  // each record.
+  const std::string c_valStr(50, 'v');
+  std::vector<std::pair<std::string, int>> records;
+  while (perfData.Get(HashTablePerfCounter::InlineEvictionsCount) == 0) {
+    const auto key = "key" + std::to_string(records.size());
+    Add(hashTable, key, c_valStr);
+    records.emplace_back(key, getShard(key));
+    BOOST_REQUIRE_NE(records.back().second, -1);
+  }
+
+  // The records evicted are in the shard of the last key added, and the
+  // other shards are not touched.
+  const auto shard = records.back().second;
+  std::uint32_t numEvicted = 0U;
+  for (const auto& record : records) {
+    IReadOnlyHashTable::Value value;
+    if (!Get(hashTable, record.first, value)) {
+      BOOST_CHECK_EQUAL(record.second, shard);
+      ++numEvicted;
+    }
+  }
+
+  BOOST_CHECK_GT(numEvicted, 0U);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::EvictedRecordsCount),
+                    numEvicted);
+  BOOST_CHECK_LE(perfData.Get(HashTablePerfCounter::TotalKeySize) +
+                     perfData.Get(HashTablePerfCounter::TotalValueSize) +
+                     perfData.Get(HashTablePerfCounter::TotalIndexSize),
+                 c_maxCacheSizeInBytes);
+}
+
 BOOST_FIXTURE_TEST_CASE(FixedKeyValueHashTableTest, CacheHashTableTestFixture) {
   // Fixed 4 byte keys and 6 byte values.
   std::vector<HashTable::Setting> settings = {
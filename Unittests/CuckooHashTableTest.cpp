@@ -0,0 +1,300 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CheckedAllocator.h"
+#include "L4/HashTable/Cuckoo/HashTable.h"
+#include "L4/LocalMemory/HashTableManager.h"
+#include "L4/LocalMemory/Memory.h"
+#include "L4/Log/PerfCounter.h"
+#include "Mocks.h"
+#include "Utils.h"
+
+namespace L4 {
+namespace UnitTests {
+
+using namespace HashTable::Cuckoo;
+
+class CuckooHashTableTestFixture {
+ protected:
+  using Allocator = CheckedAllocator<>;
+  using HashTable = WritableHashTable<Allocator>::HashTable;
+
+  CuckooHashTableTestFixture() : m_allocator{}, m_epochManager{} {}
+
+  static IReadOnlyHashTable::Key ToKey(const std::uint64_t& key) {
+    return IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&key),
+                                   sizeof(key)};
+  }
+
+  static IReadOnlyHashTable::Value ToValue(const std::uint64_t& value) {
+    return IReadOnlyHashTable::Value{
+        reinterpret_cast<const std::uint8_t*>(&value), sizeof(value)};
+  }
+
+  static std::uint64_t FromValue(const IReadOnlyHashTable::Value& value) {
+    BOOST_REQUIRE_EQUAL(value.m_size, sizeof(std::uint64_t));
+
+    std::uint64_t result;
+    memcpy(&result, value.m_data, sizeof(result));
+    return result;
+  }
+
+  Allocator m_allocator;
+  MockEpochManager m_epochManager;
+};
+
+BOOST_FIXTURE_TEST_SUITE(CuckooHashTableTests, CuckooHashTableTestFixture)
+
+BOOST_AUTO_TEST_CASE(CuckooHashTableTest) {
+  HashTable hashTable{HashTable::Setting{16}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  constexpr std::uint64_t c_numKeys = 60U;
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    const std::uint64_t value = key * 10U;
+    writableHashTable.Add(ToKey(key), ToValue(value));
+  }
+
+  const auto& perfData = writableHashTable.GetPerfData();
+
+  Utils::ValidateCounters(perfData,
+                          {{HashTablePerfCounter::RecordsCount, c_numKeys},
+                           {HashTablePerfCounter::BucketsCount, 16},
+                           {HashTablePerfCounter::TotalKeySize, c_numKeys * 8U},
+                           {HashTablePerfCounter::TotalValueSize,
+                            c_numKeys * 8U},
+                           {HashTablePerfCounter::ChainingEntriesCount, 0},
+                           {HashTablePerfCounter::MinKeySize, 8},
+                           {HashTablePerfCounter::MaxKeySize, 8},
+                           {HashTablePerfCounter::MinValueSize, 8},
+                           {HashTablePerfCounter::MaxValueSize, 8}});
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key * 10U);
+  }
+
+  // Replace even keys and remove the keys divisible by 3.
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 2U) {
+    const std::uint64_t value = key * 100U;
+    writableHashTable.Add(ToKey(key), ToValue(value));
+  }
+
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 3U) {
+    BOOST_CHECK(writableHashTable.Remove(ToKey(key)));
+    BOOST_CHECK(!writableHashTable.Remove(ToKey(key)));
+  }
+
+  std::uint64_t numRecords = 0U;
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    const bool found = readOnlyHashTable.Get(ToKey(key), value);
+    BOOST_CHECK_EQUAL(found, key % 3U != 0U);
+
+    if (found) {
+      ++numRecords;
+      BOOST_CHECK_EQUAL(FromValue(value),
+                        key * (key % 2U == 0U ? 100U : 10U));
+    }
+  }
+
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount),
+                    static_cast<std::int64_t>(numRecords));
+
+  // Iterate all the records.
+  auto iterator = readOnlyHashTable.GetIterator();
+  std::uint64_t numIterated = 0U;
+  while (iterator->MoveNext()) {
+    ++numIterated;
+
+    const auto key = iterator->GetKey();
+    BOOST_REQUIRE_EQUAL(key.m_size, sizeof(std::uint64_t));
+
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK(readOnlyHashTable.Get(key, value));
+    BOOST_CHECK_EQUAL(FromValue(iterator->GetValue()), FromValue(value));
+  }
+  BOOST_CHECK_EQUAL(numIterated, numRecords);
+
+  // MultiGet with a missing key.
+  std::vector<std::uint64_t> keys = {1U, 3U, 4U, 1000U};
+  std::vector<IReadOnlyHashTable::Key> keyBlobs;
+  for (const auto& key : keys) {
+    keyBlobs.emplace_back(ToKey(key));
+  }
+
+  std::vector<IReadOnlyHashTable::Value> values(keys.size());
+  std::unique_ptr<bool[]> found{new bool[keys.size()]};
+  BOOST_CHECK_EQUAL(readOnlyHashTable.MultiGet(keyBlobs.data(), keys.size(),
+                                               values.data(), found.get()),
+                    2U);
+  BOOST_CHECK(found[0] && !found[1] && found[2] && !found[3]);
+  BOOST_CHECK_EQUAL(FromValue(values[2]), 400U);
+}
+
+BOOST_AUTO_TEST_CASE(CuckooHashTableHighLoadTest) {
+  // 64 buckets of 8 slots are filled up to 95%, which requires the records to
+  // be moved to their other buckets.
+  constexpr std::uint32_t c_numBuckets = 64U;
+  constexpr std::uint64_t c_numKeys = c_numBuckets * 8U * 95U / 100U;
+
+  HashTable hashTable{HashTable::Setting{c_numBuckets}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    writableHashTable.Add(ToKey(key), ToValue(key));
+  }
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(writableHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key);
+  }
+
+  const auto& perfData = writableHashTable.GetPerfData();
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount),
+                    static_cast<std::int64_t>(c_numKeys));
+  BOOST_CHECK_LE(perfData.Get(HashTablePerfCounter::MaxBucketChainLength), 2);
+}
+
+BOOST_AUTO_TEST_CASE(CuckooHashTableFullTest) {
+  // A single bucket can hold 8 records.
+  HashTable hashTable{HashTable::Setting{1}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  for (std::uint64_t key = 0U; key < 8U; ++key) {
+    writableHashTable.Add(ToKey(key), ToValue(key));
+  }
+
+  const std::uint64_t newKey = 8U;
+  BOOST_CHECK_THROW(writableHashTable.Add(ToKey(newKey), ToValue(newKey)),
+                    RuntimeException);
+
+  // The existing keys can still be replaced.
+  const std::uint64_t key = 3U;
+  const std::uint64_t value = 30U;
+  writableHashTable.Add(ToKey(key), ToValue(value));
+
+  IReadOnlyHashTable::Value actual;
+  BOOST_CHECK(writableHashTable.Get(ToKey(key), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), value);
+
+  BOOST_CHECK(writableHashTable.Remove(ToKey(key)));
+  writableHashTable.Add(ToKey(newKey), ToValue(newKey));
+  BOOST_CHECK(writableHashTable.Get(ToKey(newKey), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), newKey);
+}
+
+BOOST_AUTO_TEST_CASE(CuckooHashTableConcurrentReadTest) {
+  // The readers should always find the keys that are already added while the
+  // writer keeps moving the records to make room.
+  constexpr std::uint32_t c_numBuckets = 128U;
+  constexpr std::uint64_t c_numKeys = c_numBuckets * 8U * 9U / 10U;
+
+  HashTable hashTable{HashTable::Setting{c_numBuckets}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  std::atomic<std::uint64_t> numAdded{0U};
+  std::atomic<std::uint64_t> numMissed{0U};
+
+  std::vector<std::thread> readers;
+  for (std::uint32_t i = 0U; i < 2U; ++i) {
+    readers.emplace_back([&]() {
+      std::uint64_t added = 0U;
+      while ((added = numAdded.load()) < c_numKeys) {
+        for (std::uint64_t key = 0U; key < added; ++key) {
+          IReadOnlyHashTable::Value value;
+          if (!writableHashTable.Get(ToKey(key), value)) {
+            ++numMissed;
+          }
+        }
+      }
+    });
+  }
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    writableHashTable.Add(ToKey(key), ToValue(key));
+    ++numAdded;
+  }
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  BOOST_CHECK_EQUAL(numMissed.load(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(CuckooHashTableSerializerTest) {
+  using Memory = LocalMemory::Memory<Allocator>;
+  Memory memory{m_allocator};
+
+  HashTable hashTable{HashTable::Setting{32}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  constexpr std::uint64_t c_numKeys = 200U;
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    writableHashTable.Add(ToKey(key), ToValue(key * 2U));
+  }
+
+  std::stringstream stream;
+  writableHashTable.GetSerializer()->Serialize(stream, {});
+
+  auto newHashTable =
+      L4::HashTable::ReadWrite::Deserializer<Memory, HashTable,
+                                             WritableHashTable>(
+          L4::Utils::Properties{})
+          .Deserialize(memory, stream);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(*newHashTable);
+
+  BOOST_CHECK_EQUAL(
+      readOnlyHashTable.GetPerfData().Get(HashTablePerfCounter::RecordsCount),
+      c_numKeys);
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key * 2U);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CuckooHashTableManagerTest) {
+  LocalMemory::HashTableManager htManager;
+  std::allocator<void> allocator;
+
+  const HashTableConfig::Setting setting{
+      100U, {}, {}, {}, {}, {}, {}, HashTableConfig::Engine::Cuckoo};
+
+  const auto index = htManager.Add(HashTableConfig("HashTable1", setting),
+                                   m_epochManager, allocator);
+
+  auto& hashTable = htManager.GetHashTable(index);
+
+  const std::uint64_t key = 5U;
+  const std::uint64_t value = 50U;
+  hashTable.Add(ToKey(key), ToValue(value));
+
+  IReadOnlyHashTable::Value actual;
+  BOOST_CHECK(hashTable.Get(ToKey(key), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), value);
+
+  // Cuckoo is not supported for the cache hash table.
+  BOOST_CHECK_THROW(
+      htManager.Add(
+          HashTableConfig(
+              "HashTable2", setting,
+              HashTableConfig::Cache{1024U, std::chrono::seconds{1}, false}),
+          m_epochManager, allocator),
+      RuntimeException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace UnitTests
+}  // namespace L4
@@ -1,4 +1,7 @@
 #include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
 #include "L4/HashTable/Config.h"
 #include "L4/HashTable/IHashTable.h"
 #include "L4/LocalMemory/HashTableManager.h"
@@ -105,6 +108,308 @@ BOOST_AUTO_TEST_CASE(HashTableManagerTestForSerialzation) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(HashTableManagerHugePagesTest) {
+  HashTableConfig::Setting setting{1U << 15U};
+  setting.m_hugePages = true;
+  HashTableConfig htConfig{"HashTable1", setting};
+  std::ostringstream outStream;
+
+  // The huge pages are used only if available, thus only the upper bound of
+  // HugePageBytes is checked.
+  {
+    LocalMemory::HashTableManager htManager;
+    auto& hashTable1 = htManager.GetHashTable(
+        htManager.Add(htConfig, m_epochManager, m_allocator));
+
+    hashTable1.Add(Utils::ConvertFromString<IReadOnlyHashTable::Key>("key"),
+                   Utils::ConvertFromString<IReadOnlyHashTable::Value>("val"));
+
+    const auto& perfData = hashTable1.GetPerfData();
+    BOOST_CHECK_LE(perfData.Get(HashTablePerfCounter::HugePageBytes),
+                   perfData.Get(HashTablePerfCounter::TotalIndexSize));
+
+    hashTable1.GetSerializer()->Serialize(outStream, {});
+  }
+
+  // The huge pages are not persisted, but requested again by the setting.
+  using Setting = HashTable::SharedHashTable<HashTable::RecordBuffer,
+                                             std::allocator<void>>::Setting;
+  BOOST_CHECK_EQUAL(outStream.str()[1U + offsetof(Setting, m_hugePages)], 0);
+
+  htConfig.m_serializer.emplace(
+      std::make_shared<std::istringstream>(outStream.str()));
+
+  LocalMemory::HashTableManager htManager;
+  auto& hashTable1 = htManager.GetHashTable(
+      htManager.Add(htConfig, m_epochManager, m_allocator));
+  ValidateRecord(hashTable1, "key", "val");
+
+  const auto& perfData = hashTable1.GetPerfData();
+  BOOST_CHECK_LE(perfData.Get(HashTablePerfCounter::HugePageBytes),
+                 perfData.Get(HashTablePerfCounter::TotalIndexSize));
+}
+
+BOOST_AUTO_TEST_CASE(HashTableManagerInPlaceUpdatesTest) {
+  HashTableConfig::Setting setting{100U};
+  setting.m_inPlaceUpdates = true;
+  HashTableConfig htConfig{"HashTable1", setting};
+  std::ostringstream outStream;
+
+  const auto key = Utils::ConvertFromString<IReadOnlyHashTable::Key>("key");
+  std::vector<std::uint8_t> value;
+
+  {
+    LocalMemory::HashTableManager htManager;
+    auto& hashTable1 = htManager.GetHashTable(
+        htManager.Add(htConfig, m_epochManager, m_allocator));
+
+    hashTable1.Add(key,
+                   Utils::ConvertFromString<IReadOnlyHashTable::Value>("val1"));
+    hashTable1.Add(key,
+                   Utils::ConvertFromString<IReadOnlyHashTable::Value>("val2"));
+
+    // The value is overwritten in place, thus nothing is retired.
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 0U);
+    BOOST_CHECK(hashTable1.GetCopy(key, value));
+    BOOST_CHECK(std::string(value.begin(), value.end()) == "val2");
+
+    hashTable1.GetSerializer()->Serialize(outStream, {});
+  }
+
+  // The in-place updates are not persisted, but requested again by the
+  // setting.
+  using Setting = HashTable::SharedHashTable<HashTable::RecordBuffer,
+                                             std::allocator<void>>::Setting;
+  BOOST_CHECK_EQUAL(outStream.str()[1U + offsetof(Setting, m_inPlaceUpdates)],
+                    0);
+
+  htConfig.m_serializer.emplace(
+      std::make_shared<std::istringstream>(outStream.str()));
+
+  {
+    LocalMemory::HashTableManager htManager;
+    auto& hashTable1 = htManager.GetHashTable(
+        htManager.Add(htConfig, m_epochManager, m_allocator));
+    ValidateRecord(hashTable1, "key", "val2");
+
+    hashTable1.Add(key,
+                   Utils::ConvertFromString<IReadOnlyHashTable::Value>("val3"));
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 0U);
+    BOOST_CHECK(hashTable1.GetCopy(key, value));
+    BOOST_CHECK(std::string(value.begin(), value.end()) == "val3");
+  }
+
+  LocalMemory::HashTableManager htManager;
+  BOOST_CHECK_THROW(
+      htManager.Add(HashTableConfig("HashTable2", setting,
+                                    HashTableConfig::Cache{
+                                        1024U, std::chrono::seconds{0}, false}),
+                    m_epochManager, m_allocator),
+      RuntimeException);
+}
+
+BOOST_AUTO_TEST_CASE(HashTableManagerNumaReplicasTest) {
+  HashTableConfig htConfig{"HashTable1", HashTableConfig::Setting(100U)};
+  std::ostringstream outStream;
+
+  {
+    LocalMemory::HashTableManager htManager;
+    auto& hashTable1 = htManager.GetHashTable(
+        htManager.Add(htConfig, m_epochManager, m_allocator));
+    hashTable1.Add(Utils::ConvertFromString<IReadOnlyHashTable::Key>("key"),
+                   Utils::ConvertFromString<IReadOnlyHashTable::Value>("val"));
+    hashTable1.GetSerializer()->Serialize(outStream, {});
+  }
+
+  // Every replica is loaded from the serialized hash table.
+  htConfig.m_serializer.emplace(
+      std::make_shared<std::istringstream>(outStream.str()));
+  htConfig.m_numaReplicas = true;
+
+  LocalMemory::HashTableManager htManager{
+      std::make_shared<MockNumaTopology>(3U)};
+  const auto index = htManager.Add(htConfig, m_epochManager, m_allocator);
+
+  for (std::uint32_t node = 0U; node < 3U; ++node) {
+    ValidateRecord(htManager.GetHashTable(index, node), "key", "val");
+  }
+
+  // The cache hash table cannot be replicated.
+  BOOST_CHECK_EXCEPTION(
+      htManager.Add(
+          HashTableConfig(
+              "HashTable2", HashTableConfig::Setting(100U),
+              HashTableConfig::Cache{1024U, std::chrono::seconds{1U}, false},
+              {}, {}, true),
+          m_epochManager, m_allocator),
+      RuntimeException, [](const RuntimeException& ex) {
+        return ex.what() ==
+               std::string(
+                   "NUMA replicas are not supported for cache hash table.");
+      });
+}
+
+BOOST_AUTO_TEST_CASE(HashTableManagerFixedRecordTest) {
+  // 8 byte keys and values are served by the FixedRecord<8, 8> instantiation
+  // and 8 byte keys with 10 byte values by VarRecord.
+  HashTableConfig htConfig{"HashTable1",
+                           HashTableConfig::Setting{100U, {}, 8U, 8U}};
+  std::ostringstream outStream;
+
+  {
+    LocalMemory::HashTableManager htManager;
+    htManager.Add(htConfig, m_epochManager, m_allocator);
+    htManager.Add(
+        HashTableConfig("HashTable2",
+                        HashTableConfig::Setting{100U, {}, 8U, 8U},
+                        HashTableConfig::Cache{1024U, std::chrono::seconds{0},
+                                               false}),
+        m_epochManager, m_allocator);
+    htManager.Add(
+        HashTableConfig("HashTable3",
+                        HashTableConfig::Setting{100U, {}, 8U, 10U}),
+        m_epochManager, m_allocator);
+
+    for (const auto* name : {"HashTable1", "HashTable2"}) {
+      auto& hashTable = htManager.GetHashTable(name);
+      hashTable.Add(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>("Key00001"),
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>("Value001"));
+      ValidateRecord(hashTable, "Key00001", "Value001");
+
+      BOOST_CHECK_THROW(
+          hashTable.Add(
+              Utils::ConvertFromString<IReadOnlyHashTable::Key>("Key1"),
+              Utils::ConvertFromString<IReadOnlyHashTable::Value>("Value001")),
+          RuntimeException);
+    }
+
+    auto& hashTable3 = htManager.GetHashTable("HashTable3");
+    hashTable3.Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>("Key00001"),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>("Value00001"));
+    ValidateRecord(hashTable3, "Key00001", "Value00001");
+
+    htManager.GetHashTable("HashTable1")
+        .GetSerializer()
+        ->Serialize(outStream, {});
+  }
+
+  // The fixed sizes of the deserialized hash table select the record format.
+  htConfig.m_serializer.emplace(
+      std::make_shared<std::istringstream>(outStream.str()));
+
+  LocalMemory::HashTableManager htManager;
+  htManager.Add(htConfig, m_epochManager, m_allocator);
+
+  ValidateRecord(htManager.GetHashTable("HashTable1"), "Key00001", "Value001");
+}
+
+BOOST_AUTO_TEST_CASE(HashTableManagerBucketLockTest) {
+  using BucketLock = HashTableConfig::BucketLock;
+
+  for (const auto bucketLock : {BucketLock::ReaderWriter, BucketLock::Spin,
+                                BucketLock::Ticket, BucketLock::Adaptive}) {
+    HashTableConfig::Setting setting{100U, {}, {}, {}, {}, {}, {}, {}, {},
+                                     bucketLock};
+    std::ostringstream outStream;
+
+    {
+      LocalMemory::HashTableManager htManager;
+      auto& hashTable1 = htManager.GetHashTable(htManager.Add(
+          HashTableConfig("HashTable1", setting), m_epochManager, m_allocator));
+      hashTable1.Add(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>("key"),
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>("val"));
+      ValidateRecord(hashTable1, "key", "val");
+      hashTable1.GetSerializer()->Serialize(outStream, {});
+
+      auto& hashTable2 = htManager.GetHashTable(htManager.Add(
+          HashTableConfig("HashTable2", setting,
+                          HashTableConfig::Cache{1024U, std::chrono::seconds{0},
+                                                 false}),
+          m_epochManager, m_allocator));
+      hashTable2.Add(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>("key"),
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>("val"));
+      ValidateRecord(hashTable2, "key", "val");
+    }
+
+    // The lock type is not persisted, thus the hash table can be loaded with
+    // any lock type.
+    HashTableConfig htConfig{
+        "HashTable1", HashTableConfig::Setting{100U, {}, {}, {}, {}, {}, {}, {},
+                                               {}, BucketLock::Spin}};
+    htConfig.m_serializer.emplace(
+        std::make_shared<std::istringstream>(outStream.str()));
+
+    LocalMemory::HashTableManager htManager;
+    htManager.Add(htConfig, m_epochManager, m_allocator);
+    ValidateRecord(htManager.GetHashTable("HashTable1"), "key", "val");
+  }
+
+  LocalMemory::HashTableManager htManager;
+  BOOST_CHECK_THROW(
+      htManager.Add(
+          HashTableConfig("HashTable1",
+                          HashTableConfig::Setting{
+                              100U, {}, {}, {}, {}, {}, {},
+                              HashTableConfig::Engine::OpenAddressing, {},
+                              BucketLock::Spin}),
+          m_epochManager, m_allocator),
+      RuntimeException);
+}
+
+BOOST_AUTO_TEST_CASE(HashTableManagerBulkLoadTest) {
+  LocalMemory::HashTableManager htManager{
+      std::make_shared<MockNumaTopology>(2U)};
+  htManager.Add(HashTableConfig("HashTable1", HashTableConfig::Setting(100U)),
+                m_epochManager, m_allocator);
+  htManager.Add(
+      HashTableConfig("HashTable2", HashTableConfig::Setting(100U),
+                      HashTableConfig::Cache{1024U * 1024U,
+                                             std::chrono::seconds{0}, false}),
+      m_epochManager, m_allocator);
+  const auto ht3Index = htManager.Add(
+      HashTableConfig("HashTable3", HashTableConfig::Setting(100U), {}, {}, {},
+                      true),
+      m_epochManager, m_allocator);
+
+  std::vector<std::string> keyStrs;
+  for (auto i = 0U; i < 100U; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+  }
+
+  // The records are read from a stream in batches of 7 records.
+  for (const auto* name : {"HashTable1", "HashTable2", "HashTable3"}) {
+    std::size_t numRecordsRead = 0U;
+    htManager.BulkLoad(
+        name,
+        [&](IWritableHashTable::KeyValue* records, std::size_t maxNumRecords) {
+          std::size_t numRecords = 0U;
+          for (; numRecords < maxNumRecords && numRecordsRead < keyStrs.size();
+               ++numRecords, ++numRecordsRead) {
+            const auto* keyStr = keyStrs[numRecordsRead].c_str();
+            records[numRecords] = IWritableHashTable::KeyValue{
+                Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr),
+                Utils::ConvertFromString<IReadOnlyHashTable::Value>(keyStr)};
+          }
+          return numRecords;
+        },
+        IWritableHashTable::BulkLoadOptions{2U}, 7U);
+
+    const auto& hashTable = htManager.GetHashTable(name);
+    BOOST_CHECK_EQUAL(
+        hashTable.GetPerfData().Get(HashTablePerfCounter::RecordsCount), 100);
+    for (const auto& keyStr : keyStrs) {
+      ValidateRecord(hashTable, keyStr.c_str(), keyStr.c_str());
+    }
+  }
+
+  // Every replica is loaded.
+  ValidateRecord(htManager.GetHashTable(ht3Index, 1U), "key99", "key99");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace UnitTests
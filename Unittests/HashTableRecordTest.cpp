@@ -155,6 +155,71 @@ BOOST_AUTO_TEST_CASE(InvalidSizeTest) {
       "Invalid meta value size is given.");
 }
 
+BOOST_AUTO_TEST_CASE(FixedRecordSerializerTest) {
+  const auto key = Utils::ConvertFromString<Record::Key>("1234");
+  const auto value = Utils::ConvertFromString<Record::Value>("12345");
+  const auto otherKey = Utils::ConvertFromString<Record::Key>("1235");
+
+  std::uint16_t metadata = 7U;
+  const Record::Value metaValue{reinterpret_cast<std::uint8_t*>(&metadata),
+                                sizeof(metadata)};
+
+  // FixedRecordSerializer should produce the same layout as RecordSerializer
+  // with the same fixed sizes.
+  for (std::uint32_t metadataSize : {0U, 2U}) {
+    RecordSerializer serializer{4, 5, metadataSize};
+    FixedRecordSerializer<4, 5> fixedSerializer{4, 5, metadataSize};
+
+    BOOST_CHECK_EQUAL(fixedSerializer.CalculateRecordOverhead(), 0U);
+    BOOST_REQUIRE_EQUAL(fixedSerializer.CalculateBufferSize(key, value),
+                        serializer.CalculateBufferSize(key, value));
+
+    std::vector<std::uint8_t> buffer(
+        serializer.CalculateBufferSize(key, value));
+    std::vector<std::uint8_t> fixedBuffer(buffer.size());
+
+    const auto* fixedRecordBuffer =
+        (metadataSize != 0U)
+            ? fixedSerializer.Serialize(key, value, metaValue,
+                                        fixedBuffer.data(), fixedBuffer.size())
+            : fixedSerializer.Serialize(key, value, fixedBuffer.data(),
+                                        fixedBuffer.size());
+    if (metadataSize != 0U) {
+      serializer.Serialize(key, value, metaValue, buffer.data(), buffer.size());
+    } else {
+      serializer.Serialize(key, value, buffer.data(), buffer.size());
+    }
+
+    BOOST_CHECK(buffer == fixedBuffer);
+
+    const auto record = fixedSerializer.Deserialize(*fixedRecordBuffer);
+    const auto expected = serializer.Deserialize(*fixedRecordBuffer);
+    BOOST_CHECK(record.m_key == expected.m_key);
+    BOOST_CHECK(record.m_value == expected.m_value);
+
+    BOOST_CHECK(fixedSerializer.IsKeyEqual(key, *fixedRecordBuffer));
+    BOOST_CHECK(!fixedSerializer.IsKeyEqual(otherKey, *fixedRecordBuffer));
+    BOOST_CHECK(!fixedSerializer.IsKeyEqual(
+        Utils::ConvertFromString<Record::Key>("123"), *fixedRecordBuffer));
+  }
+
+  CHECK_EXCEPTION_THROWN_WITH_MESSAGE(
+      (FixedRecordSerializer<4, 5>{4, 6}),
+      "Fixed key and value sizes do not match the record format.");
+
+  std::vector<std::uint8_t> buffer(100U);
+  FixedRecordSerializer<4, 5> fixedSerializer{4, 5};
+  CHECK_EXCEPTION_THROWN_WITH_MESSAGE(
+      fixedSerializer.Serialize(key,
+                                Utils::ConvertFromString<Record::Value>("1"),
+                                buffer.data(), buffer.size()),
+      "Invalid key or value sizes are given.");
+
+  BOOST_CHECK((FixedRecord<4, 5>::IsMatch(4, 5)));
+  BOOST_CHECK(!(FixedRecord<4, 5>::IsMatch(4, 0)));
+  BOOST_CHECK(VarRecord::IsMatch(0, 0));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace UnitTests
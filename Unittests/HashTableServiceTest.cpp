@@ -1,4 +1,7 @@
+#include <atomic>
 #include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <thread>
 #include <utility>
 #include <vector>
 #include "L4/LocalMemory/HashTableService.h"
@@ -42,5 +45,211 @@ BOOST_AUTO_TEST_CASE(HashTableServiceTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(HashTableServiceNumaReplicasTest) {
+  auto numaTopology = std::make_shared<MockNumaTopology>(2U);
+  LocalMemory::HashTableService htService{EpochManagerConfig(), numaTopology};
+
+  const auto index = htService.AddHashTable(
+      HashTableConfig("Table1", HashTableConfig::Setting{100U}, {}, {}, {},
+                      true));
+  htService.AddHashTable(
+      HashTableConfig("Table2", HashTableConfig::Setting{100U}));
+
+  // Each replica is created on its node.
+  BOOST_CHECK(numaTopology->m_nodesRunOn == std::vector<std::uint32_t>({0, 1}));
+
+  const auto key = Utils::ConvertFromString<IReadOnlyHashTable::Key>("key");
+  const auto value =
+      Utils::ConvertFromString<IReadOnlyHashTable::Value>("value");
+
+  htService.GetContext()[index].Add(key, value);
+
+  // The contexts on different nodes read different replicas, which are both
+  // updated by the write.
+  const auto context0 = htService.GetContext();
+  numaTopology->m_currentNode = 1U;
+  const auto context1 = htService.GetContext();
+
+  BOOST_CHECK(&context0["Table1"] != &context1["Table1"]);
+  BOOST_CHECK(&context0["Table2"] == &context1["Table2"]);
+
+  for (const auto* context : {&context0, &context1}) {
+    IReadOnlyHashTable::Value val;
+    BOOST_CHECK((*context)[index].Get(key, val));
+    BOOST_CHECK(Utils::ConvertToString(val) == "value");
+    BOOST_CHECK_EQUAL(
+        (*context)[index].GetPerfData().Get(HashTablePerfCounter::RecordsCount),
+        1);
+  }
+
+  BOOST_CHECK(htService.GetContext()[index].Remove(key));
+
+  for (const auto* context : {&context0, &context1}) {
+    IReadOnlyHashTable::Value val;
+    BOOST_CHECK(!(*context)[index].Get(key, val));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(HashTableServiceCompactionTest) {
+  LocalMemory::HashTableService htService;
+  const auto index = htService.AddHashTable(
+      HashTableConfig("Table1", HashTableConfig::Setting{4U}, {}, {}, {}, {},
+                      HashTableConfig::Compaction{std::chrono::milliseconds{1},
+                                                  2U}));
+
+  const auto toKey = [](const std::string& str) {
+    return Utils::ConvertFromString<IReadOnlyHashTable::Key>(str.c_str());
+  };
+
+  // About 200 records per bucket, which span 13 entries.
+  constexpr std::uint16_t c_numKeys = 800U;
+
+  std::vector<std::string> keyStrs;
+  for (std::uint16_t i = 0U; i < c_numKeys; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+  }
+
+  const auto value =
+      Utils::ConvertFromString<IReadOnlyHashTable::Value>("value");
+
+  for (std::uint16_t i = 0U; i < c_numKeys; ++i) {
+    htService.GetContext()[index].Add(toKey(keyStrs[i]), value);
+  }
+
+  const auto& perfData = htService.GetContext()[index].GetPerfData();
+  BOOST_CHECK_GT(perfData.Get(HashTablePerfCounter::ChainingEntriesCount), 29);
+
+  // The readers look up the even keys, which are never removed, while the
+  // odd keys are removed and added back and the records are moved by the
+  // compaction.
+  std::atomic<bool> isDone{false};
+  std::atomic<std::uint32_t> numMissed{0U};
+
+  std::vector<std::thread> readers;
+  for (std::uint16_t i = 0U; i < 2; ++i) {
+    readers.emplace_back([&]() {
+      while (!isDone) {
+        auto context = htService.GetContext();
+        for (std::uint16_t j = 0U; j < c_numKeys; j += 2) {
+          IReadOnlyHashTable::Value val;
+          if (!context[index].Get(toKey(keyStrs[j]), val)) {
+            ++numMissed;
+          }
+        }
+      }
+    });
+  }
+
+  for (std::uint16_t round = 0U; round < 20; ++round) {
+    for (std::uint16_t i = 1U; i < c_numKeys; i += 2) {
+      htService.GetContext()[index].Remove(toKey(keyStrs[i]));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+
+    for (std::uint16_t i = 1U; i < c_numKeys; i += 2) {
+      htService.GetContext()[index].Add(toKey(keyStrs[i]), value);
+    }
+  }
+
+  for (std::uint16_t i = 1U; i < c_numKeys; i += 2) {
+    htService.GetContext()[index].Remove(toKey(keyStrs[i]));
+  }
+
+  // Wait until the chains are compacted: the 400 records left need at most
+  // ceil(r / 16) chained entries for the r records of each bucket, which add
+  // up to at most 400 / 16 + 4 = 29.
+  for (std::uint16_t i = 0U;
+       i < 1000 &&
+       perfData.Get(HashTablePerfCounter::ChainingEntriesCount) > 29;
+       ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+
+  isDone = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  BOOST_CHECK_EQUAL(numMissed.load(), 0U);
+  BOOST_CHECK_LE(perfData.Get(HashTablePerfCounter::ChainingEntriesCount),
+                 29);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount), 400);
+}
+
+BOOST_AUTO_TEST_CASE(HashTableServiceBackgroundEvictionTest) {
+  using BackgroundEviction = HashTableConfig::Cache::BackgroundEviction;
+
+  constexpr std::uint64_t c_maxCacheSizeInBytes = 100000U;
+
+  LocalMemory::HashTableService htService;
+  const auto index = htService.AddHashTable(HashTableConfig(
+      "Table1", HashTableConfig::Setting{100U},
+      HashTableConfig::Cache{
+          c_maxCacheSizeInBytes, std::chrono::seconds{100U}, false,
+          HashTableConfig::Cache::EvictionPolicy::Clock,
+          BackgroundEviction{0.5, 0.8, std::chrono::milliseconds{1}}}));
+
+  const auto& perfData = htService.GetContext()[index].GetPerfData();
+  const auto getTotalDataSize = [&perfData]() {
+    return perfData.Get(HashTablePerfCounter::TotalKeySize) +
+           perfData.Get(HashTablePerfCounter::TotalValueSize) +
+           perfData.Get(HashTablePerfCounter::TotalIndexSize);
+  };
+
+  // Fill the cache up to 90% of the max size, which is above the high
+  // watermark but leaves the room for the writes not to evict inline.
+  const std::string valueStr(100, 'v');
+  const auto value =
+      Utils::ConvertFromString<IReadOnlyHashTable::Value>(valueStr.c_str());
+
+  for (std::uint32_t i = 0U;
+       getTotalDataSize() < c_maxCacheSizeInBytes * 9 / 10; ++i) {
+    const auto keyStr = "key" + std::to_string(i);
+    htService.GetContext()[index].Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+        value);
+  }
+
+  // Wait until the background eviction brings the cache down to the low
+  // watermark.
+  for (std::uint16_t i = 0U;
+       i < 1000 && getTotalDataSize() > c_maxCacheSizeInBytes / 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+
+  BOOST_CHECK_LE(getTotalDataSize(), c_maxCacheSizeInBytes / 2);
+  BOOST_CHECK_GT(
+      perfData.Get(HashTablePerfCounter::BackgroundEvictedRecordsCount), 0);
+  BOOST_CHECK_EQUAL(
+      perfData.Get(HashTablePerfCounter::BackgroundEvictedRecordsCount),
+      perfData.Get(HashTablePerfCounter::EvictedRecordsCount));
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::InlineEvictionsCount),
+                    0);
+
+  // The watermarks are validated.
+  BOOST_CHECK_THROW(
+      htService.AddHashTable(HashTableConfig(
+          "Table2", HashTableConfig::Setting{100U},
+          HashTableConfig::Cache{
+              c_maxCacheSizeInBytes, std::chrono::seconds{100U}, false,
+              HashTableConfig::Cache::EvictionPolicy::Clock,
+              BackgroundEviction{0.9, 0.8}})),
+      RuntimeException);
+
+  // The number of eviction shards is validated against the number of
+  // buckets.
+  for (const std::uint16_t numEvictionShards : {0U, 101U}) {
+    BOOST_CHECK_THROW(
+        htService.AddHashTable(HashTableConfig(
+            "Table2", HashTableConfig::Setting{100U},
+            HashTableConfig::Cache{
+                c_maxCacheSizeInBytes, std::chrono::seconds{100U}, false,
+                HashTableConfig::Cache::EvictionPolicy::Clock,
+                BackgroundEviction{}, numEvictionShards})),
+        RuntimeException);
+  }
+}
+
 }  // namespace UnitTests
 }  // namespace L4
@@ -0,0 +1,192 @@
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CheckedAllocator.h"
+#include "L4/HashTable/Inline/HashTable.h"
+#include "L4/LocalMemory/HashTableManager.h"
+#include "L4/Log/PerfCounter.h"
+#include "Mocks.h"
+#include "Utils.h"
+
+namespace L4 {
+namespace UnitTests {
+
+using namespace HashTable::Inline;
+
+class InlineHashTableTestFixture {
+ protected:
+  using Allocator = CheckedAllocator<>;
+  using HashTable = WritableHashTable<Allocator>::HashTable;
+
+  InlineHashTableTestFixture() : m_allocator{}, m_epochManager{} {}
+
+  static IReadOnlyHashTable::Key ToKey(const std::uint64_t& key) {
+    return IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&key),
+                                   sizeof(key)};
+  }
+
+  static IReadOnlyHashTable::Value ToValue(const std::uint64_t& value) {
+    return IReadOnlyHashTable::Value{
+        reinterpret_cast<const std::uint8_t*>(&value), sizeof(value)};
+  }
+
+  static std::uint64_t FromValue(const IReadOnlyHashTable::Value& value) {
+    BOOST_REQUIRE_EQUAL(value.m_size, sizeof(std::uint64_t));
+
+    std::uint64_t result;
+    memcpy(&result, value.m_data, sizeof(result));
+    return result;
+  }
+
+  Allocator m_allocator;
+  MockEpochManager m_epochManager;
+};
+
+BOOST_FIXTURE_TEST_SUITE(InlineHashTableTests, InlineHashTableTestFixture)
+
+BOOST_AUTO_TEST_CASE(InlineHashTableTest) {
+  // Use a single bucket so that the records are chained.
+  HashTable hashTable{HashTable::Setting{1, 1, 8, 8}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  constexpr std::uint64_t c_numKeys = 40U;
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    const std::uint64_t value = key * 10U;
+    writableHashTable.Add(ToKey(key), ToValue(value));
+  }
+
+  const auto& perfData = writableHashTable.GetPerfData();
+
+  Utils::ValidateCounters(
+      perfData,
+      {{HashTablePerfCounter::RecordsCount, c_numKeys},
+       {HashTablePerfCounter::BucketsCount, 1},
+       {HashTablePerfCounter::TotalKeySize, c_numKeys * 8U},
+       {HashTablePerfCounter::TotalValueSize, c_numKeys * 8U},
+       {HashTablePerfCounter::ChainingEntriesCount, 2},
+       {HashTablePerfCounter::MaxBucketChainLength, 3},
+       {HashTablePerfCounter::MinKeySize, 8},
+       {HashTablePerfCounter::MaxKeySize, 8},
+       {HashTablePerfCounter::MinValueSize, 8},
+       {HashTablePerfCounter::MaxValueSize, 8}});
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key * 10U);
+  }
+
+  // Replace even keys and remove the keys divisible by 3.
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 2U) {
+    const std::uint64_t value = key * 100U;
+    writableHashTable.Add(ToKey(key), ToValue(value));
+  }
+
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 3U) {
+    BOOST_CHECK(writableHashTable.Remove(ToKey(key)));
+    BOOST_CHECK(!writableHashTable.Remove(ToKey(key)));
+  }
+
+  // The retired slots are reused once the epoch actions are performed, so no
+  // more entries are chained.
+  BOOST_CHECK_EQUAL(
+      perfData.Get(HashTablePerfCounter::ChainingEntriesCount), 2);
+
+  std::uint64_t numRecords = 0U;
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    const bool found = readOnlyHashTable.Get(ToKey(key), value);
+    BOOST_CHECK_EQUAL(found, key % 3U != 0U);
+
+    if (found) {
+      ++numRecords;
+      BOOST_CHECK_EQUAL(FromValue(value),
+                        key * (key % 2U == 0U ? 100U : 10U));
+    }
+  }
+
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount),
+                    static_cast<std::int64_t>(numRecords));
+
+  // Iterate all the records.
+  auto iterator = readOnlyHashTable.GetIterator();
+  std::uint64_t numIterated = 0U;
+  while (iterator->MoveNext()) {
+    ++numIterated;
+
+    const auto key = iterator->GetKey();
+    BOOST_REQUIRE_EQUAL(key.m_size, sizeof(std::uint64_t));
+
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK(readOnlyHashTable.Get(key, value));
+    BOOST_CHECK_EQUAL(FromValue(iterator->GetValue()), FromValue(value));
+  }
+  BOOST_CHECK_EQUAL(numIterated, numRecords);
+
+  // MultiGet with a missing key and a key of a wrong size.
+  std::vector<std::uint64_t> keys = {1U, 3U, 4U, 1000U};
+  std::vector<IReadOnlyHashTable::Key> keyBlobs;
+  for (const auto& key : keys) {
+    keyBlobs.emplace_back(ToKey(key));
+  }
+  keyBlobs.back().m_size = 4U;
+
+  std::vector<IReadOnlyHashTable::Value> values(keys.size());
+  std::unique_ptr<bool[]> found{new bool[keys.size()]};
+  BOOST_CHECK_EQUAL(readOnlyHashTable.MultiGet(keyBlobs.data(), keys.size(),
+                                               values.data(), found.get()),
+                    2U);
+  BOOST_CHECK(found[0] && !found[1] && found[2] && !found[3]);
+  BOOST_CHECK_EQUAL(FromValue(values[2]), 400U);
+}
+
+BOOST_AUTO_TEST_CASE(InlineHashTableInvalidSizeTest) {
+  // The record doesn't fit in a slot.
+  BOOST_CHECK_THROW((HashTable{HashTable::Setting{1, 1, 8, 16}, m_allocator}),
+                    RuntimeException);
+
+  HashTable hashTable{HashTable::Setting{1, 1, 4, 8}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  const std::uint64_t key = 1U;
+  BOOST_CHECK_THROW(writableHashTable.Add(ToKey(key), ToValue(key)),
+                    RuntimeException);
+}
+
+BOOST_AUTO_TEST_CASE(InlineHashTableManagerTest) {
+  LocalMemory::HashTableManager htManager;
+  std::allocator<void> allocator;
+
+  const auto index = htManager.Add(
+      HashTableConfig("HashTable1",
+                      HashTableConfig::Setting{100U, {}, 8U, 8U, {}, {}, true}),
+      m_epochManager, allocator);
+
+  auto& hashTable = htManager.GetHashTable(index);
+
+  const std::uint64_t key = 5U;
+  const std::uint64_t value = 50U;
+  hashTable.Add(ToKey(key), ToValue(value));
+
+  IReadOnlyHashTable::Value actual;
+  BOOST_CHECK(hashTable.Get(ToKey(key), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), value);
+
+  // Inline records are not supported for the cache hash table.
+  BOOST_CHECK_THROW(
+      htManager.Add(
+          HashTableConfig(
+              "HashTable2",
+              HashTableConfig::Setting{100U, {}, 8U, 8U, {}, {}, true},
+              HashTableConfig::Cache{1024U, std::chrono::seconds{1}, false}),
+          m_epochManager, allocator),
+      RuntimeException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace UnitTests
+}  // namespace L4
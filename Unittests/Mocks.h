@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
 #include "L4/Epoch/IEpochActionManager.h"
 #include "L4/Log/PerfLogger.h"
+#include "L4/Utils/NumaTopology.h"
 
 namespace L4 {
 namespace UnitTests {
@@ -21,5 +25,27 @@ struct MockEpochManager : public IEpochActionManager {
   std::uint16_t m_numRegisterActionsCalled;
 };
 
+// MockNumaTopology simulates the given number of NUMA nodes. The current node
+// is set by the test, and RunOnNode() records the nodes it is called for.
+struct MockNumaTopology : public Utils::INumaTopology {
+  explicit MockNumaTopology(std::uint32_t numNodes) : m_numNodes{numNodes} {}
+
+  virtual std::uint32_t GetNumNodes() const override { return m_numNodes; }
+
+  virtual std::uint32_t GetCurrentNode() const override {
+    return m_currentNode.load();
+  }
+
+  virtual void RunOnNode(std::uint32_t node,
+                         const std::function<void()>& func) const override {
+    m_nodesRunOn.push_back(node);
+    func();
+  }
+
+  std::uint32_t m_numNodes;
+  std::atomic<std::uint32_t> m_currentNode{0U};
+  mutable std::vector<std::uint32_t> m_nodesRunOn;
+};
+
 }  // namespace UnitTests
 }  // namespace L4
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CheckedAllocator.h"
+#include "L4/HashTable/OpenAddressing/HashTable.h"
+#include "L4/HashTable/ReadWrite/HashTable.h"
+#include "L4/LocalMemory/HashTableManager.h"
+#include "L4/LocalMemory/Memory.h"
+#include "L4/Log/PerfCounter.h"
+#include "Mocks.h"
+#include "Utils.h"
+
+namespace L4 {
+namespace UnitTests {
+
+using namespace HashTable::OpenAddressing;
+
+class OpenAddressingHashTableTestFixture {
+ protected:
+  using Allocator = CheckedAllocator<>;
+  using HashTable = WritableHashTable<Allocator>::HashTable;
+
+  OpenAddressingHashTableTestFixture() : m_allocator{}, m_epochManager{} {}
+
+  static IReadOnlyHashTable::Key ToKey(const std::uint64_t& key) {
+    return IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&key),
+                                   sizeof(key)};
+  }
+
+  static IReadOnlyHashTable::Value ToValue(const std::uint64_t& value) {
+    return IReadOnlyHashTable::Value{
+        reinterpret_cast<const std::uint8_t*>(&value), sizeof(value)};
+  }
+
+  static std::uint64_t FromValue(const IReadOnlyHashTable::Value& value) {
+    BOOST_REQUIRE_EQUAL(value.m_size, sizeof(std::uint64_t));
+
+    std::uint64_t result;
+    memcpy(&result, value.m_data, sizeof(result));
+    return result;
+  }
+
+  Allocator m_allocator;
+  MockEpochManager m_epochManager;
+};
+
+BOOST_FIXTURE_TEST_SUITE(OpenAddressingHashTableTests,
+                         OpenAddressingHashTableTestFixture)
+
+BOOST_AUTO_TEST_CASE(OpenAddressingHashTableTest) {
+  // Use a few groups so that the keys are probed across the groups.
+  HashTable hashTable{HashTable::Setting{4}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  constexpr std::uint64_t c_numKeys = 40U;
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    const std::uint64_t value = key * 10U;
+    writableHashTable.Add(ToKey(key), ToValue(value));
+  }
+
+  const auto& perfData = writableHashTable.GetPerfData();
+
+  Utils::ValidateCounters(perfData,
+                          {{HashTablePerfCounter::RecordsCount, c_numKeys},
+                           {HashTablePerfCounter::BucketsCount, 4},
+                           {HashTablePerfCounter::TotalKeySize, c_numKeys * 8U},
+                           {HashTablePerfCounter::TotalValueSize,
+                            c_numKeys * 8U},
+                           {HashTablePerfCounter::ChainingEntriesCount, 0},
+                           {HashTablePerfCounter::MinKeySize, 8},
+                           {HashTablePerfCounter::MaxKeySize, 8},
+                           {HashTablePerfCounter::MinValueSize, 8},
+                           {HashTablePerfCounter::MaxValueSize, 8}});
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key * 10U);
+  }
+
+  // Replace even keys and remove the keys divisible by 3.
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 2U) {
+    const std::uint64_t value = key * 100U;
+    writableHashTable.Add(ToKey(key), ToValue(value));
+  }
+
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 3U) {
+    BOOST_CHECK(writableHashTable.Remove(ToKey(key)));
+    BOOST_CHECK(!writableHashTable.Remove(ToKey(key)));
+  }
+
+  std::uint64_t numRecords = 0U;
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    const bool found = readOnlyHashTable.Get(ToKey(key), value);
+    BOOST_CHECK_EQUAL(found, key % 3U != 0U);
+
+    if (found) {
+      ++numRecords;
+      BOOST_CHECK_EQUAL(FromValue(value),
+                        key * (key % 2U == 0U ? 100U : 10U));
+    }
+  }
+
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount),
+                    static_cast<std::int64_t>(numRecords));
+
+  // Add the removed keys back, which reuses the deleted slots.
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 3U) {
+    writableHashTable.Add(ToKey(key), ToValue(key));
+    ++numRecords;
+  }
+
+  for (std::uint64_t key = 0U; key < c_numKeys; key += 3U) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key);
+  }
+
+  // Iterate all the records.
+  auto iterator = readOnlyHashTable.GetIterator();
+  std::uint64_t numIterated = 0U;
+  while (iterator->MoveNext()) {
+    ++numIterated;
+
+    const auto key = iterator->GetKey();
+    BOOST_REQUIRE_EQUAL(key.m_size, sizeof(std::uint64_t));
+
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK(readOnlyHashTable.Get(key, value));
+    BOOST_CHECK_EQUAL(FromValue(iterator->GetValue()), FromValue(value));
+  }
+  BOOST_CHECK_EQUAL(numIterated, numRecords);
+
+  // MultiGet with a missing key.
+  std::vector<std::uint64_t> keys = {1U, 3U, 4U, 1000U};
+  std::vector<IReadOnlyHashTable::Key> keyBlobs;
+  for (const auto& key : keys) {
+    keyBlobs.emplace_back(ToKey(key));
+  }
+
+  std::vector<IReadOnlyHashTable::Value> values(keys.size());
+  std::unique_ptr<bool[]> found{new bool[keys.size()]};
+  BOOST_CHECK_EQUAL(readOnlyHashTable.MultiGet(keyBlobs.data(), keys.size(),
+                                               values.data(), found.get()),
+                    3U);
+  BOOST_CHECK(found[0] && found[1] && found[2] && !found[3]);
+  BOOST_CHECK_EQUAL(FromValue(values[1]), 3U);
+  BOOST_CHECK_EQUAL(FromValue(values[2]), 400U);
+}
+
+BOOST_AUTO_TEST_CASE(OpenAddressingHashTableFullTest) {
+  // A single group can hold 14 (7/8 of 16) records.
+  HashTable hashTable{HashTable::Setting{1}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  for (std::uint64_t key = 0U; key < 14U; ++key) {
+    writableHashTable.Add(ToKey(key), ToValue(key));
+  }
+
+  const std::uint64_t newKey = 14U;
+  BOOST_CHECK_THROW(writableHashTable.Add(ToKey(newKey), ToValue(newKey)),
+                    RuntimeException);
+
+  // The existing keys can still be replaced.
+  const std::uint64_t key = 3U;
+  const std::uint64_t value = 30U;
+  writableHashTable.Add(ToKey(key), ToValue(value));
+
+  IReadOnlyHashTable::Value actual;
+  BOOST_CHECK(writableHashTable.Get(ToKey(key), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), value);
+
+  // Removing a record from a group with an empty slot frees up the slot.
+  BOOST_CHECK(writableHashTable.Remove(ToKey(key)));
+  writableHashTable.Add(ToKey(newKey), ToValue(newKey));
+  BOOST_CHECK(writableHashTable.Get(ToKey(newKey), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), newKey);
+
+  BOOST_CHECK_EQUAL(
+      writableHashTable.GetPerfData().Get(HashTablePerfCounter::RecordsCount),
+      14);
+}
+
+BOOST_AUTO_TEST_CASE(OpenAddressingHashTableSerializerTest) {
+  using Memory = LocalMemory::Memory<Allocator>;
+  Memory memory{m_allocator};
+
+  // Serialize a chained hash table and deserialize it as an open addressing
+  // hash table.
+  using ChainedHashTable =
+      L4::HashTable::ReadWrite::WritableHashTable<Allocator>::HashTable;
+  ChainedHashTable chainedHashTable{ChainedHashTable::Setting{10},
+                                    m_allocator};
+  L4::HashTable::ReadWrite::WritableHashTable<Allocator> chained(
+      chainedHashTable, m_epochManager);
+
+  constexpr std::uint64_t c_numKeys = 50U;
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    chained.Add(ToKey(key), ToValue(key * 2U));
+  }
+
+  std::stringstream chainedStream;
+  chained.GetSerializer()->Serialize(chainedStream, {});
+
+  auto hashTable =
+      L4::HashTable::ReadWrite::Deserializer<Memory, HashTable,
+                                             WritableHashTable>(
+          L4::Utils::Properties{})
+          .Deserialize(memory, chainedStream);
+
+  WritableHashTable<Allocator> writableHashTable(*hashTable, m_epochManager);
+  BOOST_CHECK_EQUAL(
+      writableHashTable.GetPerfData().Get(HashTablePerfCounter::RecordsCount),
+      c_numKeys);
+
+  // Serialize it back and deserialize it as a chained hash table.
+  std::stringstream stream;
+  writableHashTable.GetSerializer()->Serialize(stream, {});
+
+  auto newChainedHashTable =
+      L4::HashTable::ReadWrite::Deserializer<
+          Memory, ChainedHashTable,
+          L4::HashTable::ReadWrite::WritableHashTable>(L4::Utils::Properties{})
+          .Deserialize(memory, stream);
+  L4::HashTable::ReadWrite::ReadOnlyHashTable<Allocator> readOnlyHashTable(
+      *newChainedHashTable);
+
+  for (std::uint64_t key = 0U; key < c_numKeys; ++key) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(writableHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key * 2U);
+
+    BOOST_REQUIRE(readOnlyHashTable.Get(ToKey(key), value));
+    BOOST_CHECK_EQUAL(FromValue(value), key * 2U);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(OpenAddressingHashTableManagerTest) {
+  LocalMemory::HashTableManager htManager;
+  std::allocator<void> allocator;
+
+  const HashTableConfig::Setting setting{
+      100U, {}, {}, {}, {}, {}, {}, HashTableConfig::Engine::OpenAddressing};
+
+  const auto index = htManager.Add(HashTableConfig("HashTable1", setting),
+                                   m_epochManager, allocator);
+
+  auto& hashTable = htManager.GetHashTable(index);
+
+  const std::uint64_t key = 5U;
+  const std::uint64_t value = 50U;
+  hashTable.Add(ToKey(key), ToValue(value));
+
+  IReadOnlyHashTable::Value actual;
+  BOOST_CHECK(hashTable.Get(ToKey(key), actual));
+  BOOST_CHECK_EQUAL(FromValue(actual), value);
+
+  // Open addressing is not supported for the cache hash table.
+  BOOST_CHECK_THROW(
+      htManager.Add(
+          HashTableConfig(
+              "HashTable2", setting,
+              HashTableConfig::Cache{1024U, std::chrono::seconds{1}, false}),
+          m_epochManager, allocator),
+      RuntimeException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace UnitTests
+}  // namespace L4
@@ -1,6 +1,9 @@
 #include <boost/test/unit_test.hpp>
 #include <limits>
+#include <thread>
+#include <vector>
 #include "L4/Log/PerfLogger.h"
+#include "L4/Utils/Exception.h"
 
 namespace L4 {
 namespace UnitTests {
@@ -48,6 +51,68 @@ BOOST_AUTO_TEST_CASE(PerfCountersTest) {
   BOOST_CHECK_EQUAL(perfCounters.Get(TestCounter::Counter), 1);
 }
 
+BOOST_AUTO_TEST_CASE(ShardedPerfCountersTest) {
+  enum class TestCounter { Counter = 0, Count };
+
+  ShardedPerfCounters<TestCounter> perfCounters;
+
+  BOOST_CHECK_EQUAL(perfCounters.Get(TestCounter::Counter), 0);
+
+  // Each thread updates the shard assigned to it, and the shards are summed.
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0U; i < 20U; ++i) {
+    threads.emplace_back([&perfCounters]() {
+      for (std::uint32_t j = 0U; j < 1000U; ++j) {
+        perfCounters.Add(TestCounter::Counter, 3);
+        perfCounters.Increment(TestCounter::Counter);
+        perfCounters.Subtract(TestCounter::Counter, 2);
+        perfCounters.Decrement(TestCounter::Counter);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(perfCounters.Get(TestCounter::Counter), 20000);
+
+  perfCounters.Set(TestCounter::Counter, 10);
+  BOOST_CHECK_EQUAL(perfCounters.Get(TestCounter::Counter), 10);
+
+  perfCounters.Decrement(TestCounter::Counter);
+  BOOST_CHECK_EQUAL(perfCounters.Get(TestCounter::Counter), 9);
+}
+
+BOOST_AUTO_TEST_CASE(HashTablePerfDataTest) {
+  HashTablePerfData perfData;
+
+  // Both the sharded and the non-sharded counters are updated through
+  // HashTablePerfData.
+  BOOST_CHECK(HashTablePerfData::IsSharded(HashTablePerfCounter::RecordsCount));
+  BOOST_CHECK(
+      !HashTablePerfData::IsSharded(HashTablePerfCounter::MaxKeySize));
+
+  perfData.Set(HashTablePerfCounter::RecordsCount, 5);
+  perfData.Increment(HashTablePerfCounter::RecordsCount);
+  perfData.Add(HashTablePerfCounter::RecordsCount, 4);
+  perfData.Decrement(HashTablePerfCounter::RecordsCount);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount), 9);
+
+  perfData.Set(HashTablePerfCounter::BucketsCount, 16);
+  perfData.Add(HashTablePerfCounter::BucketsCount, 16);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::BucketsCount), 32);
+
+  perfData.Max(HashTablePerfCounter::MaxKeySize, 10);
+  perfData.Min(HashTablePerfCounter::MinKeySize, 10);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::MaxKeySize), 10);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::MinKeySize), 10);
+
+  perfData.Increment(HashTablePerfCounter::CacheHitCount);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::CacheHitCount),
+                    c_readPathPerfCountersEnabled ? 1 : 0);
+}
+
 BOOST_AUTO_TEST_CASE(PerfDataTest) {
   PerfData testPerfData;
 
@@ -94,5 +159,44 @@ BOOST_AUTO_TEST_CASE(PerfDataTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(HashTableStatsTest) {
+  HashTableStats stats1;
+  stats1.AddBucket(1U, true);
+  stats1.AddEntry(0U);
+  stats1.AddBucket(2U, false);
+  stats1.AddEntry(16U);
+  stats1.AddEntry(1U);
+  stats1.AddRecord(0U);
+  stats1.AddRecord(7U);
+  stats1.AddRecord(8U);
+  stats1.m_numTagFalsePositives = 1U;
+
+  HashTableStats stats2;
+  stats2.AddBucket(3U, false);
+  stats2.AddRecord(1U);
+
+  stats1.Merge(stats2);
+
+  BOOST_CHECK_EQUAL(stats1.m_numBuckets, 3U);
+  BOOST_CHECK_EQUAL(stats1.GetEmptyBucketRatio(), 1.0 / 3);
+  BOOST_CHECK_EQUAL(stats1.m_numRecords, 4U);
+  BOOST_CHECK_EQUAL(stats1.GetTagFalsePositiveRate(), 0.25);
+  BOOST_CHECK(stats1.m_chainLengthHistogram ==
+              std::vector<std::uint64_t>({0U, 1U, 1U, 1U}));
+  BOOST_CHECK_EQUAL(stats1.m_slotOccupancyHistogram.size(), 17U);
+  BOOST_CHECK(stats1.m_recordSizeHistogram ==
+              std::vector<std::uint64_t>({2U, 0U, 1U, 1U}));
+
+  // The stats are reported along with the perf data.
+  PerfData testPerfData;
+  testPerfData.AddHashTableStats("HT1", stats1);
+  BOOST_CHECK_EQUAL(testPerfData.GetHashTablesStats().size(), 1U);
+  BOOST_CHECK_EQUAL(
+      &testPerfData.GetHashTablesStats().at("HT1").get().m_numRecords,
+      &stats1.m_numRecords);
+  BOOST_CHECK_THROW(testPerfData.AddHashTableStats("HT1", stats2),
+                    RuntimeException);
+}
+
 }  // namespace UnitTests
 }  // namespace L4
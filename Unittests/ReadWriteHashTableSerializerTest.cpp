@@ -150,6 +150,91 @@ BOOST_AUTO_TEST_CASE(HashTableSerializeTest) {
        {HashTablePerfCounter::RecordsCountSavedFromSerializer, 0}});
 }
 
+BOOST_AUTO_TEST_CASE(CurrentSerializerPersistsHashFunctionTest) {
+  Memory memory;
+  MockEpochManager epochManager;
+
+  auto hashTableHolder{memory.MakeUnique<HashTable>(
+      HashTable::Setting{5, 1, 0, 0, L4::HashTable::HashFunction::WyHash,
+                         L4::HashTable::RangeReduction::MultiplyShift},
+      memory.GetAllocator())};
+
+  WritableHashTable<Allocator> writableHashTable(*hashTableHolder,
+                                                 epochManager);
+  writableHashTable.Add(
+      Utils::ConvertFromString<IReadOnlyHashTable::Key>("hello"),
+      Utils::ConvertFromString<IReadOnlyHashTable::Value>("world"));
+
+  std::ostringstream outStream;
+  Serializer<HashTable, ReadOnlyHashTable>{}.Serialize(*hashTableHolder,
+                                                       outStream);
+
+  std::istringstream inStream(outStream.str());
+  auto newHashTableHolder =
+      Deserializer<Memory, HashTable, WritableHashTable>{
+          L4::Utils::Properties{}}
+          .Deserialize(memory, inStream);
+
+  const auto& setting = newHashTableHolder->m_setting;
+  BOOST_CHECK(setting.m_hashFunction == L4::HashTable::HashFunction::WyHash);
+  BOOST_CHECK(setting.m_rangeReduction ==
+              L4::HashTable::RangeReduction::MultiplyShift);
+
+  IReadOnlyHashTable::Value val;
+  BOOST_CHECK(ReadOnlyHashTable<Allocator>{*newHashTableHolder}.Get(
+      Utils::ConvertFromString<IReadOnlyHashTable::Key>("hello"), val));
+  BOOST_CHECK(Utils::ConvertToString(val) == "world");
+}
+
+BOOST_AUTO_TEST_CASE(DeprecatedV1DeserializerTest) {
+  // Build a stream in the version 1 format by hand.
+  std::ostringstream outStream;
+  SerializerHelper helper(outStream);
+
+  helper.Serialize(Deprecated::V1::c_version);
+  helper.Serialize(Deprecated::V1::Setting<HashTable>{5U, 1U, 0U, 0U});
+
+  const KeyValuePairs keyValuePairs = {{"hello1", " world1"},
+                                       {"hello2", " world2"}};
+  for (const auto& pair : keyValuePairs) {
+    helper.Serialize(true);
+
+    const auto key =
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(pair.first.c_str());
+    const auto value = Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+        pair.second.c_str());
+
+    helper.Serialize(key.m_size);
+    helper.Serialize(key.m_data, key.m_size);
+    helper.Serialize(value.m_size);
+    helper.Serialize(value.m_data, value.m_size);
+  }
+  helper.Serialize(false);
+
+  Memory memory;
+  std::istringstream inStream(outStream.str());
+  auto hashTableHolder =
+      Deserializer<Memory, HashTable, WritableHashTable>{
+          L4::Utils::Properties{}}
+          .Deserialize(memory, inStream);
+
+  const auto& setting = hashTableHolder->m_setting;
+  BOOST_CHECK_EQUAL(setting.m_numBuckets, 5U);
+  BOOST_CHECK(setting.m_hashFunction ==
+              L4::HashTable::HashFunction::MurmurHash3);
+  BOOST_CHECK(setting.m_rangeReduction ==
+              L4::HashTable::RangeReduction::Modulo);
+
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(*hashTableHolder);
+  for (const auto& pair : keyValuePairs) {
+    IReadOnlyHashTable::Value val;
+    BOOST_CHECK(readOnlyHashTable.Get(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(pair.first.c_str()),
+        val));
+    BOOST_CHECK(Utils::ConvertToString(val) == pair.second);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace UnitTests
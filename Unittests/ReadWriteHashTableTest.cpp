@@ -1,4 +1,10 @@
+#include <atomic>
 #include <boost/test/unit_test.hpp>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 #include "CheckedAllocator.h"
 #include "L4/HashTable/ReadWrite/HashTable.h"
 #include "L4/Log/PerfCounter.h"
@@ -505,6 +511,93 @@ BOOST_AUTO_TEST_CASE(FixedKeyValueHashTableTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(FixedRecordHashTableTest) {
+  using RecordFormat = L4::HashTable::FixedRecord<8, 8>;
+
+  HashTable hashTable{HashTable::Setting{1, 1, 8, 8}, m_allocator};
+  WritableHashTable<Allocator, RecordFormat> writableHashTable(hashTable,
+                                                               m_epochManager);
+  ReadOnlyHashTable<Allocator, RecordFormat> readOnlyHashTable(hashTable);
+
+  // The hash table with VarRecord format reads the same records.
+  ReadOnlyHashTable<Allocator> varReadOnlyHashTable(hashTable);
+
+  constexpr std::uint64_t c_numRecords = 40U;
+
+  for (std::uint64_t i = 0U; i < c_numRecords; ++i) {
+    const std::uint64_t value = i * 10U;
+    writableHashTable.Add(
+        IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&i),
+                                sizeof(i)},
+        IReadOnlyHashTable::Value{
+            reinterpret_cast<const std::uint8_t*>(&value), sizeof(value)});
+  }
+
+  // Replace the first half of the records.
+  for (std::uint64_t i = 0U; i < c_numRecords / 2U; ++i) {
+    const std::uint64_t value = i * 100U;
+    writableHashTable.Add(
+        IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&i),
+                                sizeof(i)},
+        IReadOnlyHashTable::Value{
+            reinterpret_cast<const std::uint8_t*>(&value), sizeof(value)});
+  }
+
+  Utils::ValidateCounters(
+      writableHashTable.GetPerfData(),
+      {{HashTablePerfCounter::RecordsCount, c_numRecords},
+       {HashTablePerfCounter::TotalKeySize, c_numRecords * 8U},
+       {HashTablePerfCounter::TotalValueSize, c_numRecords * 8U}});
+
+  for (std::uint64_t i = 0U; i < c_numRecords; ++i) {
+    const IReadOnlyHashTable::Key key{reinterpret_cast<const std::uint8_t*>(&i),
+                                      sizeof(i)};
+    const std::uint64_t expected = i * (i < c_numRecords / 2U ? 100U : 10U);
+
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(key, value));
+    BOOST_REQUIRE_EQUAL(value.m_size, sizeof(expected));
+    BOOST_CHECK_EQUAL(*reinterpret_cast<const std::uint64_t*>(value.m_data),
+                      expected);
+
+    IReadOnlyHashTable::Value varValue;
+    BOOST_REQUIRE(varReadOnlyHashTable.Get(key, varValue));
+    BOOST_CHECK(value == varValue);
+  }
+
+  // A key of a different size never matches.
+  const std::uint32_t shortKey = 1U;
+  IReadOnlyHashTable::Value value;
+  BOOST_CHECK(!readOnlyHashTable.Get(
+      IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&shortKey),
+                              sizeof(shortKey)},
+      value));
+
+  std::uint64_t numIterated = 0U;
+  auto iterator = readOnlyHashTable.GetIterator();
+  while (iterator->MoveNext()) {
+    BOOST_CHECK_EQUAL(iterator->GetKey().m_size, 8U);
+    BOOST_CHECK_EQUAL(iterator->GetValue().m_size, 8U);
+    ++numIterated;
+  }
+  BOOST_CHECK_EQUAL(numIterated, c_numRecords);
+
+  for (std::uint64_t i = 0U; i < c_numRecords; i += 2U) {
+    BOOST_CHECK(writableHashTable.Remove(IReadOnlyHashTable::Key{
+        reinterpret_cast<const std::uint8_t*>(&i), sizeof(i)}));
+  }
+
+  BOOST_CHECK_EQUAL(
+      writableHashTable.GetPerfData().Get(HashTablePerfCounter::RecordsCount),
+      static_cast<std::int64_t>(c_numRecords / 2U));
+
+  // The record format must match the fixed sizes of the hash table.
+  HashTable varHashTable{HashTable::Setting{1, 1, 8, 0}, m_allocator};
+  BOOST_CHECK_THROW(
+      (ReadOnlyHashTable<Allocator, RecordFormat>{varHashTable}),
+      RuntimeException);
+}
+
 BOOST_AUTO_TEST_CASE(HashTableIteratorTest) {
   Allocator allocator;
   constexpr std::uint32_t c_numBuckets = 10;
@@ -620,6 +713,1050 @@ BOOST_AUTO_TEST_CASE(HashTableIteratorTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(TagMatcherTest) {
+  using L4::HashTable::TagMatcher;
+
+  TagMatcher::Tags tags{0U};
+  BOOST_CHECK_EQUAL(TagMatcher::MatchEmpty(tags), 0xFFFFU);
+  BOOST_CHECK_EQUAL(TagMatcher::Match(tags, 1U), 0U);
+
+  tags[0] = 1U;
+  tags[5] = 0xFFU;
+  tags[15] = 1U;
+
+  BOOST_CHECK_EQUAL(TagMatcher::Match(tags, 1U), (1U << 0) | (1U << 15));
+  BOOST_CHECK_EQUAL(TagMatcher::Match(tags, 0xFFU), 1U << 5);
+  BOOST_CHECK_EQUAL(TagMatcher::MatchEmpty(tags),
+                    0xFFFFU & ~((1U << 0) | (1U << 5) | (1U << 15)));
+
+  // The two-byte tags only match when both bytes are equal, including the
+  // values whose signed comparison would differ.
+  TagMatcher::WideTags wideTags{0U};
+  wideTags[0] = 0x0101U;
+  wideTags[7] = 0xFFFFU;
+  wideTags[8] = 0x8000U;
+  wideTags[15] = 0x0101U;
+
+  BOOST_CHECK_EQUAL(TagMatcher::Match(wideTags, 0x0101U),
+                    (1U << 0) | (1U << 15));
+  BOOST_CHECK_EQUAL(TagMatcher::Match(wideTags, 0x0001U), 0U);
+  BOOST_CHECK_EQUAL(TagMatcher::Match(wideTags, 0xFFFFU), 1U << 7);
+  BOOST_CHECK_EQUAL(TagMatcher::Match(wideTags, 0x8000U), 1U << 8);
+  BOOST_CHECK_EQUAL(
+      TagMatcher::Match(wideTags, 0U),
+      0xFFFFU & ~((1U << 0) | (1U << 7) | (1U << 8) | (1U << 15)));
+
+  // Eight two-byte tags give an eight-bit mask.
+  TagMatcher::HalfWideTags halfWideTags{0U};
+  halfWideTags[1] = 0x8001U;
+  halfWideTags[7] = 0x8001U;
+
+  BOOST_CHECK_EQUAL(TagMatcher::Match(halfWideTags, 0x8001U),
+                    (1U << 1) | (1U << 7));
+  BOOST_CHECK_EQUAL(TagMatcher::Match(halfWideTags, 0U),
+                    0xFFU & ~((1U << 1) | (1U << 7)));
+
+  // The occupancy bitmap of an entry filters out the empty slots, so a tag 0
+  // does not match an empty slot.
+  HashTable::Entry entry;
+  BOOST_CHECK_EQUAL(entry.MatchTag(0U), 0U);
+  BOOST_CHECK_EQUAL(entry.MatchEmpty(), 0xFFFFU);
+
+  entry.SetOccupied(3U, true);
+  BOOST_CHECK_EQUAL(entry.MatchTag(0U), 1U << 3);
+  BOOST_CHECK_EQUAL(entry.MatchEmpty(), 0xFFFFU & ~(1U << 3));
+
+  entry.SetOccupied(3U, false);
+  BOOST_CHECK_EQUAL(entry.MatchTag(0U), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(TagFalsePositiveTest) {
+  // Use a single bucket so that all the keys share the same chain.
+  HashTable hashTable{HashTable::Setting{1}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  constexpr std::uint32_t c_numKeys = 2000U;
+
+  for (std::uint32_t i = 0U; i < c_numKeys; ++i) {
+    writableHashTable.Add(
+        IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&i),
+                                sizeof(i)},
+        IReadOnlyHashTable::Value{reinterpret_cast<const std::uint8_t*>(&i),
+                                  sizeof(i)});
+  }
+
+  const auto& perfData = writableHashTable.GetPerfData();
+  const auto falsePositivesFromAdd =
+      perfData.Get(HashTablePerfCounter::TagFalsePositiveCount);
+
+  for (std::uint32_t i = c_numKeys; i < 2U * c_numKeys; ++i) {
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK(!writableHashTable.Get(
+        IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&i),
+                                sizeof(i)},
+        value));
+  }
+
+  // Each missing key is compared against the 2000 tags, so about
+  // 2000 * 2000 / 65536 (~61) false positives are expected with 16-bit tags
+  // whereas about 15600 with 8-bit tags.
+  const auto falsePositives =
+      perfData.Get(HashTablePerfCounter::TagFalsePositiveCount) -
+      falsePositivesFromAdd;
+  BOOST_CHECK_GT(falsePositives, 0);
+  BOOST_CHECK_LT(falsePositives, 500);
+}
+
+BOOST_AUTO_TEST_CASE(MultiGetTest) {
+  HashTable hashTable{HashTable::Setting{10}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  // Use more keys than the number of keys processed in a group and leave every
+  // third key out of the table.
+  constexpr std::uint32_t c_numKeys = 50U;
+
+  std::vector<std::string> keyStrs;
+  std::vector<std::string> valStrs;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+    valStrs.emplace_back("value" + std::to_string(i));
+
+    if (i % 3 != 0U) {
+      writableHashTable.Add(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>(
+              keyStrs.back().c_str()),
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+              valStrs.back().c_str()));
+    }
+  }
+
+  std::vector<IReadOnlyHashTable::Key> keys;
+  for (const auto& keyStr : keyStrs) {
+    keys.emplace_back(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()));
+  }
+
+  std::vector<IReadOnlyHashTable::Value> values(c_numKeys);
+  std::unique_ptr<bool[]> found{new bool[c_numKeys]};
+
+  BOOST_CHECK_EQUAL(readOnlyHashTable.MultiGet(keys.data(), c_numKeys,
+                                               values.data(), found.get()),
+                    c_numKeys - 17U);
+
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    BOOST_CHECK_EQUAL(found[i], i % 3 != 0U);
+    if (found[i]) {
+      BOOST_CHECK(Utils::ConvertToString(values[i]) == valStrs[i]);
+    }
+  }
+
+  // Empty batch.
+  BOOST_CHECK_EQUAL(
+      readOnlyHashTable.MultiGet(keys.data(), 0U, values.data(), found.get()),
+      0U);
+}
+
+BOOST_AUTO_TEST_CASE(ResizeTest) {
+  HashTable hashTable{HashTable::Setting{4, 2}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(
+      hashTable, m_epochManager, HashTableConfig::Resize{2.0, 0U, 1U});
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  constexpr std::uint32_t c_numKeys = 500U;
+
+  const auto getKeyStr = [](std::uint32_t i) {
+    return "key" + std::to_string(i);
+  };
+  const auto getValStr = [](std::uint32_t i) {
+    return "value" + std::to_string(i);
+  };
+
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    const auto keyStr = getKeyStr(i);
+    const auto valStr = getValStr(i);
+    writableHashTable.Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(valStr.c_str()));
+  }
+
+  // Complete the resize in progress if any.
+  writableHashTable.MigrateBuckets((std::numeric_limits<std::uint32_t>::max)());
+
+  const auto& perfData = hashTable.m_perfData;
+
+  // The bucket array grows by doubling, so the number of buckets stays a
+  // multiple of the initial number of buckets.
+  const auto numBuckets = hashTable.GetBuckets().size();
+  BOOST_CHECK_GT(numBuckets, 4U);
+  BOOST_CHECK_EQUAL(numBuckets % 4U, 0U);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::BucketsCount),
+                    static_cast<std::int64_t>(numBuckets));
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount),
+                    c_numKeys);
+  BOOST_CHECK_GT(m_epochManager.m_numRegisterActionsCalled, 0U);
+
+  // Start a resize explicitly and remove/update records in the middle of the
+  // migration. The writes go through a hash table without the resize config so
+  // that they don't migrate any buckets.
+  WritableHashTable<Allocator> nonResizingHashTable(hashTable, m_epochManager);
+
+  BOOST_CHECK(writableHashTable.StartResize());
+  BOOST_CHECK(hashTable.IsResizing());
+  BOOST_CHECK(writableHashTable.MigrateBuckets(
+      static_cast<std::uint32_t>(numBuckets / 2U)));
+
+  for (auto i = 0U; i < c_numKeys; i += 2U) {
+    const auto keyStr = getKeyStr(i);
+    BOOST_CHECK(nonResizingHashTable.Remove(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str())));
+  }
+
+  for (auto i = 1U; i < c_numKeys; i += 4U) {
+    const auto keyStr = getKeyStr(i);
+    const auto valStr = getValStr(i + 1U);
+    nonResizingHashTable.Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(valStr.c_str()));
+  }
+
+  // Lookups still go to the current bucket array during the migration.
+  const auto verify = [&]() {
+    for (auto i = 0U; i < c_numKeys; ++i) {
+      const auto keyStr = getKeyStr(i);
+      IReadOnlyHashTable::Value value;
+      const bool found = readOnlyHashTable.Get(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+          value);
+
+      BOOST_CHECK_EQUAL(found, i % 2U != 0U);
+      if (found) {
+        BOOST_CHECK(Utils::ConvertToString(value) ==
+                    getValStr(i % 4U == 1U ? i + 1U : i));
+      }
+    }
+
+    std::uint32_t numRecords = 0U;
+    auto iterator = readOnlyHashTable.GetIterator();
+    while (iterator->MoveNext()) {
+      ++numRecords;
+    }
+    BOOST_CHECK_EQUAL(numRecords, c_numKeys / 2U);
+  };
+
+  verify();
+
+  BOOST_CHECK(!writableHashTable.MigrateBuckets(
+      static_cast<std::uint32_t>(numBuckets)));
+  BOOST_CHECK(!hashTable.IsResizing());
+  BOOST_CHECK_EQUAL(hashTable.GetBuckets().size(), numBuckets * 2U);
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::BucketsCount),
+                    static_cast<std::int64_t>(numBuckets * 2U));
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::RecordsCount),
+                    c_numKeys / 2U);
+
+  verify();
+}
+
+BOOST_AUTO_TEST_CASE(BulkLoadTest) {
+  // CheckedAllocator is not thread-safe, thus std::allocator is used for the
+  // bulk load with multiple threads.
+  using Allocator = std::allocator<void>;
+  using HashTable = WritableHashTable<Allocator>::HashTable;
+
+  constexpr std::uint32_t c_numKeys = 2000U;
+
+  std::vector<std::string> keyStrs;
+  std::vector<std::string> valStrs;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+    valStrs.emplace_back("value" + std::to_string(i % 37U));
+  }
+
+  std::vector<IWritableHashTable::KeyValue> records;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    records.emplace_back(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStrs[i].c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+            valStrs[i].c_str()));
+  }
+
+  // The hash table populated by Add() is the reference for the perf counters.
+  HashTable expected{HashTable::Setting{100, 7}, Allocator{}};
+  WritableHashTable<Allocator> expectedWritable(expected, m_epochManager);
+  for (const auto& record : records) {
+    expectedWritable.Add(record.m_key, record.m_value);
+  }
+
+  const auto verify = [&](HashTable& hashTable) {
+    ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+    for (auto i = 0U; i < c_numKeys; ++i) {
+      IReadOnlyHashTable::Value value;
+      BOOST_REQUIRE(readOnlyHashTable.Get(records[i].m_key, value));
+      BOOST_CHECK(Utils::ConvertToString(value) == valStrs[i]);
+    }
+
+    for (const auto counter : {HashTablePerfCounter::RecordsCount,
+                               HashTablePerfCounter::ChainingEntriesCount,
+                               HashTablePerfCounter::TotalKeySize,
+                               HashTablePerfCounter::TotalValueSize,
+                               HashTablePerfCounter::TotalIndexSize,
+                               HashTablePerfCounter::MinKeySize,
+                               HashTablePerfCounter::MaxKeySize,
+                               HashTablePerfCounter::MinValueSize,
+                               HashTablePerfCounter::MaxValueSize,
+                               HashTablePerfCounter::MaxBucketChainLength}) {
+      BOOST_CHECK_EQUAL(hashTable.m_perfData.Get(counter),
+                        expected.m_perfData.Get(counter));
+    }
+  };
+
+  for (const bool skipDuplicateCheck : {false, true}) {
+    for (const std::uint16_t numThreads : {1U, 4U}) {
+      HashTable hashTable{HashTable::Setting{100, 7}, Allocator{}};
+      WritableHashTable<Allocator> writableHashTable(hashTable,
+                                                     m_epochManager);
+
+      writableHashTable.BulkLoad(
+          records.data(), records.size(),
+          IWritableHashTable::BulkLoadOptions{numThreads, skipDuplicateCheck});
+
+      verify(hashTable);
+    }
+  }
+
+  // The duplicate keys are replaced where the last one in the batch wins, and
+  // the replaced records are released by a single epoch action.
+  HashTable hashTable{HashTable::Setting{100, 7}, Allocator{}};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  std::vector<IWritableHashTable::KeyValue> duplicates;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    duplicates.emplace_back(records[i].m_key,
+                            records[(i + 1U) % c_numKeys].m_value);
+  }
+  duplicates.insert(duplicates.end(), records.begin(), records.end());
+
+  const auto numRegisterActionsCalled =
+      m_epochManager.m_numRegisterActionsCalled;
+
+  writableHashTable.BulkLoad(duplicates.data(), duplicates.size(),
+                             IWritableHashTable::BulkLoadOptions{4U});
+
+  BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled,
+                    numRegisterActionsCalled + 1U);
+  BOOST_CHECK_EQUAL(
+      hashTable.m_perfData.Get(HashTablePerfCounter::RecordsCount), c_numKeys);
+
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(records[i].m_key, value));
+    BOOST_CHECK(Utils::ConvertToString(value) == valStrs[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BulkLoadResizeTest) {
+  HashTable hashTable{HashTable::Setting{4, 2}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(
+      hashTable, m_epochManager, HashTableConfig::Resize{2.0, 0U, 1U});
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  constexpr std::uint32_t c_numKeys = 500U;
+
+  std::vector<std::string> keyStrs;
+  std::vector<IWritableHashTable::KeyValue> records;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+  }
+  for (const auto& keyStr : keyStrs) {
+    records.emplace_back(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(keyStr.c_str()));
+  }
+
+  writableHashTable.BulkLoad(records.data(), records.size(),
+                             IWritableHashTable::BulkLoadOptions{});
+
+  // The bucket array is grown up front for the load factor.
+  BOOST_CHECK(!hashTable.IsResizing());
+  BOOST_CHECK_GE(hashTable.GetBuckets().size() * 2U, c_numKeys);
+  BOOST_CHECK_EQUAL(
+      hashTable.m_perfData.Get(HashTablePerfCounter::RecordsCount), c_numKeys);
+
+  for (const auto& record : records) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(record.m_key, value));
+    BOOST_CHECK(Utils::ConvertToString(value) ==
+                Utils::ConvertToString(record.m_key));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AddRemoveBatchTest) {
+  constexpr std::uint32_t c_numKeys = 300U;
+
+  std::vector<std::string> keyStrs;
+  std::vector<std::string> valStrs;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+    valStrs.emplace_back("value" + std::to_string(i));
+  }
+
+  std::vector<IWritableHashTable::KeyValue> records;
+  std::vector<IReadOnlyHashTable::Key> keys;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    keys.emplace_back(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStrs[i].c_str()));
+    records.emplace_back(keys.back(),
+                         Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+                             valStrs[i].c_str()));
+  }
+
+  // The hash table updated by Add()/Remove() is the reference for the perf
+  // counters.
+  HashTable expected{HashTable::Setting{50, 5}, m_allocator};
+  WritableHashTable<Allocator> expectedWritable(expected, m_epochManager);
+
+  HashTable hashTable{HashTable::Setting{50, 5}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  const auto verifyPerfData = [&]() {
+    for (const auto counter : {HashTablePerfCounter::RecordsCount,
+                               HashTablePerfCounter::ChainingEntriesCount,
+                               HashTablePerfCounter::TotalKeySize,
+                               HashTablePerfCounter::TotalValueSize,
+                               HashTablePerfCounter::TotalIndexSize,
+                               HashTablePerfCounter::MinKeySize,
+                               HashTablePerfCounter::MaxKeySize,
+                               HashTablePerfCounter::MinValueSize,
+                               HashTablePerfCounter::MaxValueSize,
+                               HashTablePerfCounter::MaxBucketChainLength}) {
+      BOOST_CHECK_EQUAL(hashTable.m_perfData.Get(counter),
+                        expected.m_perfData.Get(counter));
+    }
+  };
+
+  // Add the first half twice in the batch with different values, where the
+  // last one wins.
+  std::vector<IWritableHashTable::KeyValue> batch;
+  for (auto i = 0U; i < c_numKeys / 2U; ++i) {
+    batch.emplace_back(records[i].m_key, records[c_numKeys - 1U - i].m_value);
+  }
+  batch.insert(batch.end(), records.begin(), records.end());
+
+  for (const auto& record : batch) {
+    expectedWritable.Add(record.m_key, record.m_value);
+  }
+
+  auto numRegisterActionsCalled = m_epochManager.m_numRegisterActionsCalled;
+  writableHashTable.AddBatch(batch.data(), batch.size());
+
+  // The replaced records are released by a single epoch action.
+  BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled,
+                    numRegisterActionsCalled + 1U);
+  verifyPerfData();
+
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(readOnlyHashTable.Get(keys[i], value));
+    BOOST_CHECK(Utils::ConvertToString(value) == valStrs[i]);
+  }
+
+  // Remove every other key twice, where only the first one is removed.
+  std::vector<IReadOnlyHashTable::Key> keysToRemove;
+  for (auto i = 0U; i < c_numKeys; i += 2U) {
+    keysToRemove.push_back(keys[i]);
+    keysToRemove.push_back(keys[i]);
+    expectedWritable.Remove(keys[i]);
+  }
+
+  std::unique_ptr<bool[]> removed{new bool[keysToRemove.size()]};
+  numRegisterActionsCalled = m_epochManager.m_numRegisterActionsCalled;
+
+  BOOST_CHECK_EQUAL(
+      writableHashTable.RemoveBatch(keysToRemove.data(), keysToRemove.size(),
+                                    removed.get()),
+      c_numKeys / 2U);
+  BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled,
+                    numRegisterActionsCalled + 1U);
+  verifyPerfData();
+
+  for (std::size_t i = 0U; i < keysToRemove.size(); ++i) {
+    BOOST_CHECK_EQUAL(removed[i], i % 2U == 0U);
+  }
+
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK_EQUAL(readOnlyHashTable.Get(keys[i], value), i % 2U != 0U);
+  }
+
+  // Nothing is released for an empty batch.
+  numRegisterActionsCalled = m_epochManager.m_numRegisterActionsCalled;
+  BOOST_CHECK_EQUAL(writableHashTable.RemoveBatch(keys.data(), 0U, nullptr),
+                    0U);
+  BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled,
+                    numRegisterActionsCalled);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelForEachTest) {
+  HashTable hashTable{HashTable::Setting{10}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+  // Use enough keys to chain the entries in each bucket.
+  constexpr std::uint32_t c_numKeys = 200U;
+
+  std::map<std::string, std::string> expected;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    const auto keyStr = "key" + std::to_string(i);
+    const auto valStr = "value" + std::to_string(i);
+    writableHashTable.Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(valStr.c_str()));
+    expected.emplace(keyStr, valStr);
+  }
+
+  for (const std::uint16_t numThreads : {1U, 3U, 16U}) {
+    std::vector<std::map<std::string, std::string>> records(numThreads);
+    writableHashTable.ParallelForEach(
+        [&records](std::uint16_t threadIndex,
+                   const IReadOnlyHashTable::Key& key,
+                   const IReadOnlyHashTable::Value& value) {
+          records[threadIndex].emplace(Utils::ConvertToString(key),
+                                       Utils::ConvertToString(value));
+        },
+        numThreads);
+
+    // Each record is visited by exactly one thread.
+    std::size_t numRecords = 0U;
+    std::map<std::string, std::string> actual;
+    for (const auto& threadRecords : records) {
+      numRecords += threadRecords.size();
+      actual.insert(threadRecords.begin(), threadRecords.end());
+    }
+
+    BOOST_CHECK_EQUAL(numRecords, c_numKeys);
+    BOOST_CHECK(actual == expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CompactTest) {
+  HashTable hashTable{HashTable::Setting{1}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  ReadOnlyHashTable<Allocator> readOnlyHashTable(hashTable);
+
+  const auto& perfData = writableHashTable.GetPerfData();
+
+  // The records fill the head entry and then 6 chained entries in order.
+  constexpr std::uint32_t c_numKeys = 100U;
+
+  std::vector<std::string> keyStrs;
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    keyStrs.emplace_back("key" + std::to_string(i));
+    writableHashTable.Add(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(
+            keyStrs.back().c_str()),
+        Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+            ("value" + std::to_string(i)).c_str()));
+  }
+
+  Utils::ValidateCounters(perfData,
+                          {{HashTablePerfCounter::ChainingEntriesCount, 6},
+                           {HashTablePerfCounter::MaxBucketChainLength, 7}});
+
+  // Keep every 5th record: 4 in the head entry and 16 in the chained ones.
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    if (i % 5U != 0U) {
+      BOOST_CHECK(writableHashTable.Remove(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>(
+              keyStrs[i].c_str())));
+    }
+  }
+
+  // Removing the records does not release the chained entries.
+  BOOST_CHECK_EQUAL(perfData.Get(HashTablePerfCounter::ChainingEntriesCount),
+                    6);
+
+  const auto totalIndexSize =
+      perfData.Get(HashTablePerfCounter::TotalIndexSize);
+  const auto numRegisterActionsCalled =
+      m_epochManager.m_numRegisterActionsCalled;
+
+  // The 16 chained records are packed into one entry, and the 5 entries left
+  // empty are released by a single epoch action.
+  BOOST_CHECK_EQUAL(writableHashTable.Compact(1U), 5U);
+  BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled,
+                    numRegisterActionsCalled + 1U);
+
+  Utils::ValidateCounters(
+      perfData,
+      {{HashTablePerfCounter::RecordsCount, 20},
+       {HashTablePerfCounter::ChainingEntriesCount, 1},
+       {HashTablePerfCounter::MaxBucketChainLength, 2},
+       {HashTablePerfCounter::TotalIndexSize,
+        totalIndexSize - 5 * sizeof(HashTable::Entry)}});
+
+  BOOST_CHECK_EQUAL(writableHashTable.Compact(1U), 0U);
+
+  // The records are still found after the compaction, and the removed ones
+  // are added back to the empty slots.
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    const auto key =
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStrs[i].c_str());
+    const auto valStr = "value" + std::to_string(i);
+
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK_EQUAL(readOnlyHashTable.Get(key, value), i % 5U == 0U);
+    if (i % 5U == 0U) {
+      BOOST_CHECK(Utils::ConvertToString(value) == valStr);
+    } else {
+      writableHashTable.Add(
+          key,
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>(valStr.c_str()));
+    }
+  }
+
+  for (auto i = 0U; i < c_numKeys; ++i) {
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK(readOnlyHashTable.Get(
+        Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStrs[i].c_str()),
+        value));
+  }
+
+  Utils::ValidateCounters(perfData,
+                          {{HashTablePerfCounter::RecordsCount, c_numKeys},
+                           {HashTablePerfCounter::ChainingEntriesCount, 6}});
+}
+
+BOOST_AUTO_TEST_CASE(UpsertTest) {
+  // Adds the 8-byte operand to the 8-byte counter.
+  struct CounterMergeOperator : public IWritableHashTable::IMergeOperator {
+    IReadOnlyHashTable::Value::size_type GetMergedSize(
+        const IReadOnlyHashTable::Value*,
+        const IReadOnlyHashTable::Value&) const override {
+      return sizeof(std::uint64_t);
+    }
+
+    void Merge(const IReadOnlyHashTable::Value* existingValue,
+               const IReadOnlyHashTable::Value& operand,
+               std::uint8_t* buffer) const override {
+      std::uint64_t counter = 0U;
+      if (existingValue != nullptr) {
+        memcpy(&counter, existingValue->m_data, sizeof(counter));
+      }
+
+      std::uint64_t delta = 0U;
+      memcpy(&delta, operand.m_data, sizeof(delta));
+
+      counter += delta;
+      memcpy(buffer, &counter, sizeof(counter));
+    }
+  };
+
+  // Appends the operand to the list.
+  struct AppendMergeOperator : public IWritableHashTable::IMergeOperator {
+    IReadOnlyHashTable::Value::size_type GetMergedSize(
+        const IReadOnlyHashTable::Value* existingValue,
+        const IReadOnlyHashTable::Value& operand) const override {
+      return ((existingValue != nullptr) ? existingValue->m_size : 0U) +
+             operand.m_size;
+    }
+
+    void Merge(const IReadOnlyHashTable::Value* existingValue,
+               const IReadOnlyHashTable::Value& operand,
+               std::uint8_t* buffer) const override {
+      if (existingValue != nullptr) {
+        memcpy(buffer, existingValue->m_data, existingValue->m_size);
+        buffer += existingValue->m_size;
+      }
+
+      memcpy(buffer, operand.m_data, operand.m_size);
+    }
+  };
+
+  HashTable hashTable{HashTable::Setting{100, 5}, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  const auto& perfData = writableHashTable.GetPerfData();
+
+  {
+    const auto key = Utils::ConvertFromString<IReadOnlyHashTable::Key>("list");
+    const AppendMergeOperator appendMergeOperator;
+
+    // The key is added with the operand as is.
+    writableHashTable.Upsert(
+        key, Utils::ConvertFromString<IReadOnlyHashTable::Value>("a"),
+        appendMergeOperator);
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 0U);
+
+    writableHashTable.Upsert(
+        key, Utils::ConvertFromString<IReadOnlyHashTable::Value>("bc"),
+        appendMergeOperator);
+
+    // The replaced record is released through the epoch manager.
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 1U);
+
+    IReadOnlyHashTable::Value value;
+    BOOST_REQUIRE(writableHashTable.Get(key, value));
+    BOOST_CHECK(value ==
+                Utils::ConvertFromString<IReadOnlyHashTable::Value>("abc"));
+
+    Utils::ValidateCounters(perfData,
+                            {{HashTablePerfCounter::RecordsCount, 1},
+                             {HashTablePerfCounter::TotalKeySize, 4},
+                             {HashTablePerfCounter::TotalValueSize, 3},
+                             {HashTablePerfCounter::MinValueSize, 1},
+                             {HashTablePerfCounter::MaxValueSize, 3}});
+
+    writableHashTable.Remove(key);
+  }
+
+  {
+    // The concurrent increments of the same counters are not lost. The table
+    // uses std::allocator since CheckedAllocator is not thread safe.
+    using ConcurrentHashTable = WritableHashTable<std::allocator<void>>;
+    std::allocator<void> allocator;
+    ConcurrentHashTable::HashTable concurrentHashTable{
+        ConcurrentHashTable::HashTable::Setting{100, 5}, allocator};
+    ConcurrentHashTable concurrentWritableHashTable(concurrentHashTable,
+                                                    m_epochManager);
+
+    const CounterMergeOperator counterMergeOperator;
+    constexpr std::uint16_t c_numThreads = 4U;
+    constexpr std::uint64_t c_numIncrements = 1000U;
+    constexpr std::uint64_t c_numKeys = 3U;
+
+    L4::Utils::RunInParallel(c_numThreads, [&](std::uint16_t) {
+      const std::uint64_t delta = 1U;
+      for (std::uint64_t i = 0U; i < c_numIncrements; ++i) {
+        const auto keyIndex = i % c_numKeys;
+        concurrentWritableHashTable.Upsert(
+            IReadOnlyHashTable::Key{
+                reinterpret_cast<const std::uint8_t*>(&keyIndex),
+                sizeof(keyIndex)},
+            IReadOnlyHashTable::Value{
+                reinterpret_cast<const std::uint8_t*>(&delta), sizeof(delta)},
+            counterMergeOperator);
+      }
+    });
+
+    std::uint64_t total = 0U;
+    for (std::uint64_t keyIndex = 0U; keyIndex < c_numKeys; ++keyIndex) {
+      IReadOnlyHashTable::Value value;
+      BOOST_REQUIRE(concurrentWritableHashTable.Get(
+          IReadOnlyHashTable::Key{
+              reinterpret_cast<const std::uint8_t*>(&keyIndex),
+              sizeof(keyIndex)},
+          value));
+      BOOST_REQUIRE_EQUAL(value.m_size, sizeof(std::uint64_t));
+
+      std::uint64_t counter = 0U;
+      memcpy(&counter, value.m_data, sizeof(counter));
+      total += counter;
+    }
+
+    BOOST_CHECK_EQUAL(total, c_numThreads * c_numIncrements);
+    Utils::ValidateCounters(
+        concurrentWritableHashTable.GetPerfData(),
+        {{HashTablePerfCounter::RecordsCount, c_numKeys},
+         {HashTablePerfCounter::TotalValueSize, c_numKeys * 8}});
+  }
+
+  {
+    // A merged value of a wrong size for the fixed value size throws without
+    // changing the hash table.
+    HashTable fixedHashTable{HashTable::Setting{1, 1, 8, 4}, m_allocator};
+    WritableHashTable<Allocator> fixedWritableHashTable(fixedHashTable,
+                                                        m_epochManager);
+
+    const std::uint64_t keyIndex = 0U;
+    const std::uint64_t delta = 1U;
+    const IReadOnlyHashTable::Key key{
+        reinterpret_cast<const std::uint8_t*>(&keyIndex), sizeof(keyIndex)};
+    const IReadOnlyHashTable::Value operand{
+        reinterpret_cast<const std::uint8_t*>(&delta), sizeof(delta)};
+
+    BOOST_CHECK_THROW(
+        fixedWritableHashTable.Upsert(key, operand, CounterMergeOperator{}),
+        RuntimeException);
+
+    IReadOnlyHashTable::Value value;
+    BOOST_CHECK(!fixedWritableHashTable.Get(key, value));
+    Utils::ValidateCounters(
+        fixedWritableHashTable.GetPerfData(),
+        {{HashTablePerfCounter::RecordsCount, 0},
+         {HashTablePerfCounter::ChainingEntriesCount, 0}});
+  }
+}
+
+BOOST_AUTO_TEST_CASE(InPlaceUpdateTest) {
+  HashTable::Setting setting{100, 5};
+  setting.m_inPlaceUpdates = true;
+  HashTable hashTable{setting, m_allocator};
+  WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+  const auto& perfData = writableHashTable.GetPerfData();
+
+  const auto key = Utils::ConvertFromString<IReadOnlyHashTable::Key>("key");
+  std::vector<std::uint8_t> copiedValue;
+  BOOST_CHECK(!writableHashTable.GetCopy(key, copiedValue));
+
+  writableHashTable.Add(
+      key, Utils::ConvertFromString<IReadOnlyHashTable::Value>("value1"));
+
+  IReadOnlyHashTable::Value value;
+  BOOST_REQUIRE(writableHashTable.Get(key, value));
+  const auto* data = value.m_data;
+
+  {
+    // The value of the same size is overwritten in the existing record.
+    writableHashTable.Add(
+        key, Utils::ConvertFromString<IReadOnlyHashTable::Value>("value2"));
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 0U);
+
+    BOOST_REQUIRE(writableHashTable.Get(key, value));
+    BOOST_CHECK_EQUAL(value.m_data, data);
+    BOOST_CHECK(writableHashTable.GetCopy(key, copiedValue));
+    BOOST_CHECK(std::string(copiedValue.begin(), copiedValue.end()) ==
+                "value2");
+
+    Utils::ValidateCounters(perfData,
+                            {{HashTablePerfCounter::RecordsCount, 1},
+                             {HashTablePerfCounter::TotalValueSize, 6}});
+  }
+
+  {
+    // The value of a different size replaces the record.
+    writableHashTable.Add(
+        key, Utils::ConvertFromString<IReadOnlyHashTable::Value>("value33"));
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 1U);
+
+    BOOST_CHECK(writableHashTable.GetCopy(key, copiedValue));
+    BOOST_CHECK(std::string(copiedValue.begin(), copiedValue.end()) ==
+                "value33");
+
+    // The new record is updated in place again.
+    writableHashTable.Add(
+        key, Utils::ConvertFromString<IReadOnlyHashTable::Value>("value44"));
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 1U);
+    BOOST_CHECK(writableHashTable.GetCopy(key, copiedValue));
+    BOOST_CHECK(std::string(copiedValue.begin(), copiedValue.end()) ==
+                "value44");
+
+    Utils::ValidateCounters(perfData,
+                            {{HashTablePerfCounter::RecordsCount, 1},
+                             {HashTablePerfCounter::TotalValueSize, 7}});
+  }
+
+  {
+    // The reader never sees a value being overwritten, which is all 'a's or
+    // all 'b's.
+    const std::string c_values[] = {std::string(256U, 'a'),
+                                    std::string(256U, 'b')};
+    writableHashTable.Add(key,
+                          Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+                              c_values[0].c_str()));
+
+    std::atomic<bool> isDone{false};
+    std::thread writer{[&]() {
+      for (std::uint32_t i = 0U; i < 10000U; ++i) {
+        writableHashTable.Add(
+            key, Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+                     c_values[i % 2U].c_str()));
+      }
+
+      isDone = true;
+    }};
+
+    std::uint32_t numTornValues = 0U;
+    do {
+      BOOST_REQUIRE(writableHashTable.GetCopy(key, copiedValue));
+      const std::string copied(copiedValue.begin(), copiedValue.end());
+      numTornValues += (copied != c_values[0] && copied != c_values[1]);
+    } while (!isDone);
+
+    writer.join();
+
+    BOOST_CHECK_EQUAL(numTornValues, 0U);
+    BOOST_CHECK_EQUAL(m_epochManager.m_numRegisterActionsCalled, 2U);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(StatsTest) {
+  {
+    // Use a single bucket so that all the keys share the same chain: 2000
+    // records span 125 full entries.
+    HashTable hashTable{HashTable::Setting{1}, m_allocator};
+    WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+    constexpr std::uint32_t c_numKeys = 2000U;
+
+    for (std::uint32_t i = 0U; i < c_numKeys; ++i) {
+      writableHashTable.Add(
+          IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&i),
+                                  sizeof(i)},
+          IReadOnlyHashTable::Value{reinterpret_cast<const std::uint8_t*>(&i),
+                                    sizeof(i)});
+    }
+
+    const auto stats = writableHashTable.GetStats(HashTableStatsOptions{});
+
+    BOOST_CHECK_EQUAL(stats.m_numBuckets, 1U);
+    BOOST_CHECK_EQUAL(stats.m_numEmptyBuckets, 0U);
+    BOOST_CHECK_EQUAL(stats.m_numRecords, c_numKeys);
+    BOOST_CHECK_EQUAL(stats.m_chainLengthHistogram.size(), 126U);
+    BOOST_CHECK_EQUAL(stats.m_chainLengthHistogram[125], 1U);
+    BOOST_CHECK_EQUAL(stats.m_slotOccupancyHistogram.size(), 17U);
+    BOOST_CHECK_EQUAL(stats.m_slotOccupancyHistogram[16], 125U);
+
+    // Each record is 8 bytes.
+    BOOST_CHECK_EQUAL(stats.m_recordSizeHistogram.size(), 4U);
+    BOOST_CHECK_EQUAL(stats.m_recordSizeHistogram[3], c_numKeys);
+
+    // The tag false positives match the ones counted by looking up each key.
+    const auto& perfData = writableHashTable.GetPerfData();
+    const auto falsePositivesFromAdd =
+        perfData.Get(HashTablePerfCounter::TagFalsePositiveCount);
+
+    for (std::uint32_t i = 0U; i < c_numKeys; ++i) {
+      IReadOnlyHashTable::Value value;
+      BOOST_CHECK(writableHashTable.Get(
+          IReadOnlyHashTable::Key{reinterpret_cast<const std::uint8_t*>(&i),
+                                  sizeof(i)},
+          value));
+    }
+
+    BOOST_CHECK_GT(stats.m_numTagFalsePositives, 0U);
+    BOOST_CHECK_EQUAL(
+        static_cast<std::int64_t>(stats.m_numTagFalsePositives),
+        perfData.Get(HashTablePerfCounter::TagFalsePositiveCount) -
+            falsePositivesFromAdd);
+  }
+
+  {
+    HashTable hashTable{HashTable::Setting{100}, m_allocator};
+    WritableHashTable<Allocator> writableHashTable(hashTable, m_epochManager);
+
+    for (auto i = 0U; i < 50U; ++i) {
+      const auto keyStr = "key" + std::to_string(i);
+      writableHashTable.Add(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>(keyStr.c_str()),
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>("value"));
+    }
+
+    const auto stats = writableHashTable.GetStats(HashTableStatsOptions{});
+    BOOST_CHECK_EQUAL(stats.m_numBuckets, 100U);
+    BOOST_CHECK_EQUAL(stats.m_numRecords, 50U);
+    BOOST_CHECK_GE(stats.GetEmptyBucketRatio(), 0.5);
+    BOOST_CHECK_EQUAL(stats.m_chainLengthHistogram[1], 100U);
+    BOOST_CHECK_EQUAL(stats.m_slotOccupancyHistogram[0],
+                      static_cast<std::uint64_t>(stats.m_numEmptyBuckets));
+
+    // The parallel pass collects the same stats.
+    const auto parallelStats =
+        writableHashTable.GetStats(HashTableStatsOptions{1.0, 7U});
+    BOOST_CHECK_EQUAL(parallelStats.m_numBuckets, stats.m_numBuckets);
+    BOOST_CHECK_EQUAL(parallelStats.m_numEmptyBuckets,
+                      stats.m_numEmptyBuckets);
+    BOOST_CHECK_EQUAL(parallelStats.m_numRecords, stats.m_numRecords);
+    BOOST_CHECK(parallelStats.m_slotOccupancyHistogram ==
+                stats.m_slotOccupancyHistogram);
+    BOOST_CHECK(parallelStats.m_recordSizeHistogram ==
+                stats.m_recordSizeHistogram);
+
+    // Every 10th bucket is visited.
+    const auto sampledStats =
+        writableHashTable.GetStats(HashTableStatsOptions{0.1, 2U});
+    BOOST_CHECK_EQUAL(sampledStats.m_numBuckets, 10U);
+    BOOST_CHECK_LE(sampledStats.m_numRecords, stats.m_numRecords);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(HasherTest) {
+  using L4::HashTable::Crc32cHasher;
+  using L4::HashTable::Hasher;
+  using L4::HashTable::RangeReduction;
+
+  // The check value of CRC32C.
+  const std::string checkStr = "123456789";
+  BOOST_CHECK_EQUAL(Crc32cHasher::Crc32c(checkStr.data(), checkStr.size()),
+                    0xe3069283U);
+
+  std::mt19937_64 random{0U};
+  for (std::uint32_t i = 0U; i < 1000U; ++i) {
+    const auto hash = random();
+    for (const std::uint64_t numBuckets : {1U, 7U, 100U, 1024U}) {
+      // Doubling the number of buckets splits a bucket j into 2j and 2j + 1
+      // with the multiply-shift range reduction.
+      const auto index = Hasher::GetBucketIndex(RangeReduction::MultiplyShift,
+                                                hash, numBuckets);
+      BOOST_CHECK_LT(index, numBuckets);
+      BOOST_CHECK_EQUAL(Hasher::GetBucketIndex(RangeReduction::MultiplyShift,
+                                               hash, numBuckets * 2U) /
+                            2U,
+                        index);
+      BOOST_CHECK_EQUAL(
+          Hasher::GetBucketIndex(RangeReduction::Modulo, hash, numBuckets),
+          hash % numBuckets);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(HashFunctionTest) {
+  using L4::HashTable::HashFunction;
+  using L4::HashTable::RangeReduction;
+
+  constexpr std::uint32_t c_numKeys = 300U;
+
+  for (const auto hashFunction :
+       {HashFunction::MurmurHash3, HashFunction::WyHash, HashFunction::Crc32c}) {
+    for (const auto rangeReduction :
+         {RangeReduction::Modulo, RangeReduction::MultiplyShift}) {
+      HashTable hashTable{
+          HashTable::Setting{10, 2, 0, 0, hashFunction, rangeReduction},
+          m_allocator};
+      WritableHashTable<Allocator> writableHashTable(
+          hashTable, m_epochManager, HashTableConfig::Resize{4.0, 0U, 2U});
+
+      // Use keys of various lengths to cover all the code paths.
+      std::vector<std::string> keyStrs;
+      for (auto i = 0U; i < c_numKeys; ++i) {
+        keyStrs.emplace_back(std::string(i % 40U, 'k') + std::to_string(i));
+        const auto valStr = "value" + std::to_string(i);
+        writableHashTable.Add(
+            Utils::ConvertFromString<IReadOnlyHashTable::Key>(
+                keyStrs.back().c_str()),
+            Utils::ConvertFromString<IReadOnlyHashTable::Value>(
+                valStr.c_str()));
+      }
+
+      BOOST_CHECK_GT(hashTable.GetBuckets().size(), 10U);
+
+      for (auto i = 0U; i < c_numKeys; i += 2U) {
+        BOOST_CHECK(writableHashTable.Remove(
+            Utils::ConvertFromString<IReadOnlyHashTable::Key>(
+                keyStrs[i].c_str())));
+      }
+
+      for (auto i = 0U; i < c_numKeys; ++i) {
+        IReadOnlyHashTable::Value value;
+        const bool found = writableHashTable.Get(
+            Utils::ConvertFromString<IReadOnlyHashTable::Key>(
+                keyStrs[i].c_str()),
+            value);
+
+        BOOST_CHECK_EQUAL(found, i % 2U != 0U);
+        if (found) {
+          BOOST_CHECK(Utils::ConvertToString(value) ==
+                      "value" + std::to_string(i));
+        }
+      }
+
+      BOOST_CHECK_EQUAL(
+          hashTable.m_perfData.Get(HashTablePerfCounter::RecordsCount),
+          c_numKeys / 2U);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace UnitTests
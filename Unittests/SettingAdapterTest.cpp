@@ -19,16 +19,19 @@ BOOST_AUTO_TEST_CASE(SettingAdapterTestWithDefaultValues) {
   BOOST_CHECK_EQUAL(to.m_numBucketsPerMutex, 1U);
   BOOST_CHECK_EQUAL(to.m_fixedKeySize, 0U);
   BOOST_CHECK_EQUAL(to.m_fixedValueSize, 0U);
+  BOOST_CHECK(!to.m_hugePages);
 }
 
 BOOST_AUTO_TEST_CASE(SettingAdapterTestWithNonDefaultValues) {
   HashTableConfig::Setting from{100U, 10U, 5U, 20U};
+  from.m_hugePages = true;
   const auto to = HashTable::SettingAdapter{}.Convert<SharedHashTable>(from);
 
   BOOST_CHECK_EQUAL(to.m_numBuckets, 100U);
   BOOST_CHECK_EQUAL(to.m_numBucketsPerMutex, 10U);
   BOOST_CHECK_EQUAL(to.m_fixedKeySize, 5U);
   BOOST_CHECK_EQUAL(to.m_fixedValueSize, 20U);
+  BOOST_CHECK(to.m_hugePages);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,186 @@
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "L4/LocalMemory/HashTableManager.h"
+#include "L4/LocalMemory/SlabAllocator.h"
+#include "L4/Log/PerfCounter.h"
+#include "Mocks.h"
+#include "Utils.h"
+
+namespace L4 {
+namespace UnitTests {
+
+using LocalMemory::SlabAllocator;
+using LocalMemory::SlabPool;
+
+BOOST_AUTO_TEST_SUITE(SlabAllocatorTests)
+
+BOOST_AUTO_TEST_CASE(SlabSizeClassTest) {
+  BOOST_CHECK_EQUAL(SlabPool::GetSizeClass(1U), 0U);
+  BOOST_CHECK_EQUAL(SlabPool::GetSizeClass(16U), 0U);
+  BOOST_CHECK_EQUAL(SlabPool::GetSizeClass(17U), 1U);
+  BOOST_CHECK_EQUAL(SlabPool::GetSizeClass(256U), 15U);
+  BOOST_CHECK_EQUAL(SlabPool::GetSizeClass(257U), 16U);
+  BOOST_CHECK_EQUAL(SlabPool::GetSizeClass(SlabPool::c_maxBlockSize),
+                    SlabPool::c_numSizeClasses - 1U);
+
+  for (std::size_t size = 1U; size <= SlabPool::c_maxBlockSize; ++size) {
+    const auto sizeClass = SlabPool::GetSizeClass(size);
+    BOOST_REQUIRE_GE(SlabPool::GetBlockSize(sizeClass), size);
+    BOOST_REQUIRE(sizeClass == 0U ||
+                  SlabPool::GetBlockSize(sizeClass - 1U) < size);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SlabAllocateDeallocateTest) {
+  auto pool = std::make_shared<SlabPool>();
+  SlabAllocator<std::uint8_t> allocator{pool};
+
+  const auto& perfData = pool->GetPerfData();
+
+  // Allocate enough blocks of 48 bytes to span two slabs.
+  const std::size_t numBlocks =
+      (SlabPool::c_slabSize / 48U) + SlabPool::c_magazineSize;
+  std::vector<std::uint8_t*> blocks;
+  for (std::size_t i = 0U; i < numBlocks; ++i) {
+    blocks.push_back(allocator.allocate(40U));
+    std::memset(blocks.back(), static_cast<int>(i), 40U);
+  }
+
+  for (std::size_t i = 0U; i < numBlocks; ++i) {
+    BOOST_REQUIRE_EQUAL(blocks[i][39], static_cast<std::uint8_t>(i));
+  }
+
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabsCount), 2);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabBytes),
+                    2 * SlabPool::c_slabSize);
+  BOOST_CHECK_GE(perfData.Get(AllocatorPerfCounter::SlabBytesInUse),
+                 static_cast<std::int64_t>(numBlocks * 48U));
+
+  // The large allocation is not from the slabs.
+  auto* large = allocator.allocate(SlabPool::c_maxBlockSize + 1U);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::LargeAllocationsCount),
+                    1);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::LargeAllocationBytes),
+                    SlabPool::c_maxBlockSize + 1U);
+  allocator.deallocate(large, SlabPool::c_maxBlockSize + 1U);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::LargeAllocationsCount),
+                    0);
+
+  for (auto* block : blocks) {
+    allocator.deallocate(block, 40U);
+  }
+
+  BOOST_CHECK_GT(perfData.Get(AllocatorPerfCounter::MagazineFlushesCount), 0);
+
+  // The blocks cached in the magazine are flushed before the release.
+  BOOST_CHECK_EQUAL(pool->ReleaseEmptySlabs(), 2U);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabsCount), 0);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::EmptySlabsCount), 0);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabBytes), 0);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabBytesInUse), 0);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::ReleasedSlabsCount), 2);
+
+  // A slab with a block in use is not released.
+  auto* block = allocator.allocate(40U);
+  BOOST_CHECK_EQUAL(pool->ReleaseEmptySlabs(), 0U);
+  allocator.deallocate(block, 40U);
+  BOOST_CHECK_EQUAL(pool->ReleaseEmptySlabs(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(SlabMultiThreadedTest) {
+  auto pool = std::make_shared<SlabPool>();
+  std::atomic<std::uint32_t> numCorrupted{0U};
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0U; i < 4U; ++i) {
+    threads.emplace_back([pool, i, &numCorrupted]() {
+      SlabAllocator<std::uint64_t> allocator{pool};
+
+      std::vector<std::uint64_t*> blocks;
+      for (std::uint32_t round = 0U; round < 10U; ++round) {
+        for (std::uint64_t j = 0U; j < 1000U; ++j) {
+          blocks.push_back(allocator.allocate(1U + (j % 8U)));
+          *blocks.back() = (static_cast<std::uint64_t>(i) << 32U) | j;
+        }
+
+        for (std::uint64_t j = 0U; j < blocks.size(); ++j) {
+          if (*blocks[j] != ((static_cast<std::uint64_t>(i) << 32U) | j)) {
+            ++numCorrupted;
+          }
+          allocator.deallocate(blocks[j], 1U + (j % 8U));
+        }
+        blocks.clear();
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(numCorrupted.load(), 0U);
+
+  pool->ReleaseEmptySlabs();
+  BOOST_CHECK_EQUAL(pool->GetPerfData().Get(AllocatorPerfCounter::SlabsCount),
+                    0);
+}
+
+BOOST_AUTO_TEST_CASE(SlabAllocatorHashTableTest) {
+  auto pool = std::make_shared<SlabPool>();
+  MockEpochManager epochManager;
+
+  {
+    LocalMemory::HashTableManager htManager;
+    auto& hashTable = htManager.GetHashTable(
+        htManager.Add(HashTableConfig("Table1", HashTableConfig::Setting{16U}),
+                      epochManager, SlabAllocator<>{pool}));
+
+    for (std::uint16_t i = 0U; i < 1000; ++i) {
+      const auto key = "key" + std::to_string(i);
+      const auto value = "value" + std::to_string(i);
+      hashTable.Add(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>(key.c_str()),
+          Utils::ConvertFromString<IReadOnlyHashTable::Value>(value.c_str()));
+    }
+
+    // The removed records are freed by the epoch actions.
+    for (std::uint16_t i = 0U; i < 1000; i += 2) {
+      const auto key = "key" + std::to_string(i);
+      BOOST_CHECK(hashTable.Remove(
+          Utils::ConvertFromString<IReadOnlyHashTable::Key>(key.c_str())));
+    }
+
+    for (std::uint16_t i = 0U; i < 1000; ++i) {
+      const auto key = "key" + std::to_string(i);
+      IReadOnlyHashTable::Value value;
+      BOOST_CHECK_EQUAL(
+          hashTable.Get(
+              Utils::ConvertFromString<IReadOnlyHashTable::Key>(key.c_str()),
+              value),
+          i % 2 != 0);
+    }
+
+    BOOST_CHECK_GT(
+        pool->GetPerfData().Get(AllocatorPerfCounter::SlabBytesInUse), 0);
+  }
+
+  // All the slabs become empty once the hash table is destroyed.
+  pool->ReleaseEmptySlabs();
+
+  const auto& perfData = pool->GetPerfData();
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabsCount), 0);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::SlabBytesInUse), 0);
+  BOOST_CHECK_EQUAL(perfData.Get(AllocatorPerfCounter::LargeAllocationsCount),
+                    0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace UnitTests
+}  // namespace L4
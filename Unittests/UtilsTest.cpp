@@ -1,5 +1,13 @@
 #include <array>
 #include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "L4/Utils/HugePages.h"
+#include "L4/Utils/Lock.h"
 #include "L4/Utils/Math.h"
 
 namespace L4 {
@@ -49,5 +57,76 @@ BOOST_AUTO_TEST_CASE(PointerArithmeticTest) {
               sizeof(int) * 2U);
 }
 
+BOOST_AUTO_TEST_CASE(HugePagesTest) {
+  // The huge pages may not be available, in which case the memory is backed by
+  // the regular pages.
+  const std::size_t size = HugePages::c_hugePageSize + 100U;
+  auto* memory = static_cast<std::uint8_t*>(HugePages::Allocate(size));
+
+  BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(memory) % 64U, 0U);
+  std::memset(memory, 1, size);
+  BOOST_CHECK_EQUAL(memory[size - 1U], 1U);
+  BOOST_CHECK_LE(HugePages::GetHugePageBytes(memory),
+                 Math::RoundUp(size, 4096U));
+
+  HugePages::Free(memory);
+
+  HugePageAllocator<std::allocator<std::uint64_t>> allocator{
+      std::allocator<std::uint64_t>{}, true};
+  auto* data = allocator.allocate(1000U);
+  data[999] = 1U;
+  BOOST_CHECK_LE(allocator.GetHugePageBytes(data), 8192U);
+  allocator.deallocate(data, 1000U);
+
+  // The wrapped allocator is used when the huge pages are disabled.
+  HugePageAllocator<std::allocator<std::uint64_t>> regularAllocator{
+      std::allocator<std::uint64_t>{}, false};
+  data = regularAllocator.allocate(1000U);
+  BOOST_CHECK_EQUAL(regularAllocator.GetHugePageBytes(data), 0U);
+  regularAllocator.deallocate(data, 1000U);
+
+  BOOST_CHECK(allocator != regularAllocator);
+}
+
+template <typename Lock>
+void CheckLock() {
+  static_assert(sizeof(Lock) == c_cacheLineSize,
+                "The lock should be padded to a cache line.");
+
+  Lock lock;
+  BOOST_CHECK(lock.try_lock());
+  BOOST_CHECK(!lock.try_lock());
+  lock.unlock();
+
+  // The non-atomic increments are protected by the lock.
+  constexpr std::uint32_t c_numThreads = 4U;
+  constexpr std::uint32_t c_numIncrements = 10000U;
+  std::uint64_t counter = 0U;
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0U; i < c_numThreads; ++i) {
+    threads.emplace_back([&lock, &counter]() {
+      for (std::uint32_t j = 0U; j < c_numIncrements; ++j) {
+        std::lock_guard<Lock> guard{lock};
+        ++counter;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(counter, c_numThreads * c_numIncrements);
+  BOOST_CHECK(lock.try_lock());
+  lock.unlock();
+}
+
+BOOST_AUTO_TEST_CASE(LockTest) {
+  CheckLock<SpinLock>();
+  CheckLock<TicketLock>();
+  CheckLock<AdaptiveLock>();
+}
+
 }  // namespace UnitTests
 }  // namespace L4
@@ -1,14 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <boost/optional.hpp>
+#include <cassert>
 #include <chrono>
 #include <cstdint>
 #include <mutex>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 #include "Epoch/IEpochActionManager.h"
 #include "HashTable/Cache/Metadata.h"
 #include "HashTable/IHashTable.h"
 #include "HashTable/ReadWrite/HashTable.h"
 #include "Utils/Clock.h"
+#include "Utils/Prefetch.h"
 #include "detail/ToRawPointer.h"
 
 namespace L4 {
@@ -17,26 +24,39 @@ namespace Cache {
 
 // ReadOnlyHashTable class implements IReadOnlyHashTable interface and provides
 // the functionality to read data given a key.
-template <typename Allocator, typename Clock = Utils::EpochClock>
+template <typename Allocator,
+          typename Clock = Utils::EpochClock,
+          typename RecordFormat = VarRecord,
+          typename BucketMutex = Utils::ReaderWriterLockSlim>
 class ReadOnlyHashTable
-    : public virtual ReadWrite::ReadOnlyHashTable<Allocator>,
+    : public virtual ReadWrite::
+          ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex>,
       protected Clock {
  public:
-  using Base = ReadWrite::ReadOnlyHashTable<Allocator>;
+  using Base =
+      ReadWrite::ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex>;
   using HashTable = typename Base::HashTable;
+  using RecordSerializer = typename Base::RecordSerializer;
 
   using Key = typename Base::Key;
   using Value = typename Base::Value;
+  using ForEachCallback = typename Base::ForEachCallback;
   using IIteratorPtr = typename Base::IIteratorPtr;
 
   class Iterator;
 
+  // The given time to live is the default for the records added without one
+  // (see WritableHashTable::Add()); each record stores when it expires,
+  // relative to the time this is constructed (see GetMetadataEpochTime()).
+  // Thus, a read only hash table should be constructed along with the
+  // writable one of the same hash table.
   ReadOnlyHashTable(HashTable& hashTable, std::chrono::seconds recordTimeToLive)
       : Base(hashTable,
              RecordSerializer{hashTable.m_setting.m_fixedKeySize,
                               hashTable.m_setting.m_fixedValueSize,
                               Metadata::c_metaDataSize}),
-        m_recordTimeToLive{recordTimeToLive} {}
+        m_recordTimeToLive{recordTimeToLive},
+        m_epochTimeBase{this->GetCurrentEpochTime()} {}
 
   virtual bool Get(const Key& key, Value& value) const override {
     const auto status = GetInternal(key, value);
@@ -50,10 +70,66 @@ class ReadOnlyHashTable
     return status;
   }
 
+  virtual std::size_t MultiGet(const Key* keys,
+                               std::size_t numKeys,
+                               Value* values,
+                               bool* found) const override {
+    Base::MultiGet(keys, numKeys, values, found);
+
+    const auto curEpochTime = this->GetMetadataEpochTime();
+    std::size_t numFound = 0U;
+
+    for (std::size_t i = 0U; i < numKeys; ++i) {
+      found[i] = found[i] && ResolveValue(values[i], curEpochTime);
+      numFound += found[i] ? 1U : 0U;
+    }
+
+    // Update the cache hit information once per batch.
+    auto& perfData = const_cast<HashTablePerfData&>(this->GetPerfData());
+    perfData.Add(HashTablePerfCounter::CacheHitCount, numFound);
+    perfData.Add(HashTablePerfCounter::CacheMissCount, numKeys - numFound);
+
+    return numFound;
+  }
+
   virtual IIteratorPtr GetIterator() const override {
-    return std::make_unique<Iterator>(
-        this->m_hashTable, this->m_recordSerializer, m_recordTimeToLive,
-        this->GetCurrentEpochTime());
+    return std::make_unique<Iterator>(this->m_hashTable,
+                                      this->m_recordSerializer,
+                                      this->GetMetadataEpochTime());
+  }
+
+  // Skips the expired records and strips the metadata from the values as the
+  // iterator does.
+  virtual void ForEachRecord(ForEachCallback callback,
+                             void* context,
+                             std::uint16_t numThreads) const override {
+    const auto curEpochTime = this->GetMetadataEpochTime();
+
+    const auto func = [&](std::uint16_t threadIndex, const Key& key,
+                          const Value& value) {
+      const Metadata metaData{const_cast<std::uint32_t*>(
+          reinterpret_cast<const std::uint32_t*>(value.m_data))};
+      if (metaData.IsExpired(curEpochTime)) {
+        return;
+      }
+
+      auto strippedValue = value;
+      strippedValue.m_data += Metadata::c_metaDataSize;
+      strippedValue.m_size -= Metadata::c_metaDataSize;
+
+      callback(context, threadIndex, key, strippedValue);
+    };
+
+    Base::ForEachRecord(&Base::template InvokeForEachCallback<decltype(func)>,
+                        const_cast<void*>(static_cast<const void*>(&func)),
+                        numThreads);
+  }
+
+  // Excludes the metadata from the record sizes. Note that the expired records
+  // are counted since they still occupy the slots.
+  virtual HashTableStats GetStats(
+      const HashTableStatsOptions& options) const override {
+    return this->CollectStats(options, Metadata::c_metaDataSize);
   }
 
   ReadOnlyHashTable(const ReadOnlyHashTable&) = delete;
@@ -61,10 +137,14 @@ class ReadOnlyHashTable
 
  protected:
   bool GetInternal(const Key& key, Value& value) const {
-    if (!Base::Get(key, value)) {
-      return false;
-    }
+    return Base::Get(key, value) &&
+           ResolveValue(value, this->GetMetadataEpochTime());
+  }
 
+  // Given the value of a found record, returns false if the record is expired.
+  // Otherwise, marks the record as accessed, strips the metadata from the value
+  // and returns true.
+  bool ResolveValue(Value& value, std::chrono::seconds curEpochTime) const {
     assert(value.m_size > Metadata::c_metaDataSize);
 
     // If the record with the given key is found, check if the record is expired
@@ -72,7 +152,7 @@ class ReadOnlyHashTable
     // update the access status.
     Metadata metaData{const_cast<std::uint32_t*>(
         reinterpret_cast<const std::uint32_t*>(value.m_data))};
-    if (metaData.IsExpired(this->GetCurrentEpochTime(), m_recordTimeToLive)) {
+    if (metaData.IsExpired(curEpochTime)) {
       return false;
     }
 
@@ -84,25 +164,40 @@ class ReadOnlyHashTable
     return true;
   }
 
+  // Returns the current epoch time relative to m_epochTimeBase, which is what
+  // the metadata stores. It stays at Metadata::c_maxEpochTime once reached,
+  // after which the records added no longer expire.
+  std::chrono::seconds GetMetadataEpochTime() const {
+    const auto epochTime = this->GetCurrentEpochTime() - m_epochTimeBase;
+
+    return (std::min)(
+        (std::max)(epochTime, std::chrono::seconds{0}),
+        std::chrono::seconds{
+            static_cast<std::int64_t>(Metadata::c_maxEpochTime)});
+  }
+
   std::chrono::seconds m_recordTimeToLive;
+
+  const std::chrono::seconds m_epochTimeBase;
 };
 
-template <typename Allocator, typename Clock>
-class ReadOnlyHashTable<Allocator, Clock>::Iterator : public Base::Iterator {
+template <typename Allocator,
+          typename Clock,
+          typename RecordFormat,
+          typename BucketMutex>
+class ReadOnlyHashTable<Allocator, Clock, RecordFormat, BucketMutex>::Iterator
+    : public Base::Iterator {
  public:
   using BaseIterator = typename Base::Iterator;
 
   Iterator(const HashTable& hashTable,
            const RecordSerializer& recordDeserializer,
-           std::chrono::seconds recordTimeToLive,
            std::chrono::seconds currentEpochTime)
       : BaseIterator(hashTable, recordDeserializer),
-        m_recordTimeToLive{recordTimeToLive},
         m_currentEpochTime{currentEpochTime} {}
 
   Iterator(Iterator&& other)
       : BaseIterator(std::move(other)),
-        m_recordTimeToLive{std::move(other.m_recordTimeToLive)},
         m_currentEpochTime{std::move(other.m_currentEpochTime)} {}
 
   bool MoveNext() override {
@@ -115,7 +210,7 @@ class ReadOnlyHashTable<Allocator, Clock>::Iterator : public Base::Iterator {
           const_cast<std::uint32_t*>(reinterpret_cast<const std::uint32_t*>(
               BaseIterator::GetValue().m_data))};
 
-      if (!metaData.IsExpired(m_currentEpochTime, m_recordTimeToLive)) {
+      if (!metaData.IsExpired(m_currentEpochTime)) {
         return true;
       }
     } while (BaseIterator::MoveNext());
@@ -132,7 +227,6 @@ class ReadOnlyHashTable<Allocator, Clock>::Iterator : public Base::Iterator {
   }
 
  private:
-  std::chrono::seconds m_recordTimeToLive;
   std::chrono::seconds m_currentEpochTime;
 };
 
@@ -143,23 +237,39 @@ class ReadOnlyHashTable<Allocator, Clock>::Iterator : public Base::Iterator {
 
 // WritableHashTable class implements IWritableHashTable interface and also
 // provides the read only access (Get()) to the hash table.
-template <typename Allocator, typename Clock = Utils::EpochClock>
-class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
-                          public ReadWrite::WritableHashTable<Allocator> {
+template <typename Allocator,
+          typename Clock = Utils::EpochClock,
+          typename RecordFormat = VarRecord,
+          typename BucketMutex = Utils::ReaderWriterLockSlim>
+class WritableHashTable
+    : public ReadOnlyHashTable<Allocator, Clock, RecordFormat, BucketMutex>,
+      public ReadWrite::
+          WritableHashTable<Allocator, RecordFormat, BucketMutex> {
  public:
-  using ReadOnlyBase = ReadOnlyHashTable<Allocator, Clock>;
-  using WritableBase = typename ReadWrite::WritableHashTable<Allocator>;
+  using ReadOnlyBase =
+      ReadOnlyHashTable<Allocator, Clock, RecordFormat, BucketMutex>;
+  using WritableBase =
+      ReadWrite::WritableHashTable<Allocator, RecordFormat, BucketMutex>;
   using HashTable = typename ReadOnlyBase::HashTable;
+  using RecordSerializer = typename ReadOnlyBase::RecordSerializer;
 
   using Key = typename ReadOnlyBase::Key;
   using Value = typename ReadOnlyBase::Value;
   using ISerializerPtr = typename WritableBase::ISerializerPtr;
+  using KeyValue = typename WritableBase::KeyValue;
+  using IMergeOperator = typename WritableBase::IMergeOperator;
+  using BulkLoadOptions = typename WritableBase::BulkLoadOptions;
+  using EvictionPolicy = HashTableConfig::Cache::EvictionPolicy;
+  using BackgroundEviction = HashTableConfig::Cache::BackgroundEviction;
 
   WritableHashTable(HashTable& hashTable,
                     IEpochActionManager& epochManager,
                     std::uint64_t maxCacheSizeInBytes,
                     std::chrono::seconds recordTimeToLive,
-                    bool forceTimeBasedEviction)
+                    bool forceTimeBasedEviction,
+                    EvictionPolicy evictionPolicy = EvictionPolicy::Clock,
+                    boost::optional<BackgroundEviction> backgroundEviction = {},
+                    std::uint16_t numEvictionShards = 1U)
       : ReadOnlyBase::Base(
             hashTable,
             RecordSerializer{hashTable.m_setting.m_fixedKeySize,
@@ -169,19 +279,147 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
         WritableBase(hashTable, epochManager),
         m_maxCacheSizeInBytes{maxCacheSizeInBytes},
         m_forceTimeBasedEviction{forceTimeBasedEviction},
-        m_currentEvictBucketIndex{0U} {}
+        m_evictionPolicy{evictionPolicy},
+        m_isBackgroundEvictionEnabled{!!backgroundEviction},
+        m_lowWatermarkInBytes{
+            backgroundEviction
+                ? static_cast<std::uint64_t>(
+                      backgroundEviction->m_lowWatermark * maxCacheSizeInBytes)
+                : 0U},
+        m_highWatermarkInBytes{
+            backgroundEviction
+                ? static_cast<std::uint64_t>(
+                      backgroundEviction->m_highWatermark * maxCacheSizeInBytes)
+                : 0U},
+        m_shardCacheSizeInBytes{maxCacheSizeInBytes / numEvictionShards},
+        m_evictionShards(numEvictionShards),
+        m_ghostKeys((evictionPolicy != EvictionPolicy::Clock)
+                        ? hashTable.GetBuckets().size() *
+                              c_numGhostKeysPerBucket
+                        : 0U) {
+    const std::uint64_t numBuckets = hashTable.GetBuckets().size();
+    assert(numEvictionShards != 0U && numEvictionShards <= numBuckets);
+
+    // Shard i owns the buckets in [ceil(i * n / k), ceil((i + 1) * n / k)),
+    // which are the buckets whose index times k divided by n is i (see
+    // GetEvictionShard()).
+    for (std::uint64_t i = 0U; i < numEvictionShards; ++i) {
+      auto& shard = m_evictionShards[i];
+      shard.m_beginBucketIndex =
+          (i * numBuckets + numEvictionShards - 1U) / numEvictionShards;
+      shard.m_numBuckets =
+          ((i + 1U) * numBuckets + numEvictionShards - 1U) /
+              numEvictionShards -
+          shard.m_beginBucketIndex;
+    }
+  }
 
   using ReadOnlyBase::Get;
   using ReadOnlyBase::GetPerfData;
+  using ReadOnlyBase::MultiGet;
 
+  // Adds the record with the time to live given to the constructor.
   virtual void Add(const Key& key, const Value& value) override {
+    Add(key, value, this->m_recordTimeToLive);
+  }
+
+  // Adds the record that expires after the given time to live, so that the
+  // records with different time to live can share the hash table.
+  void Add(const Key& key,
+           const Value& value,
+           std::chrono::seconds timeToLive) {
+    if (m_forceTimeBasedEviction) {
+      EvictBasedOnTime(key);
+    }
+
+    Evict(key, key.m_size + value.m_size + Metadata::c_metaDataSize);
+
+    WritableBase::Add(CreateRecordBuffer(key, value, timeToLive));
+  }
+
+  // The merge operator sees an expired record as nonexistent, and the merged
+  // record expires after the time to live given to the constructor. Since the
+  // size of the merged record is not known before the lock is taken, the
+  // eviction makes room for the key and the operand.
+  virtual void Upsert(const Key& key,
+                      const Value& operand,
+                      const IMergeOperator& mergeOperator) override {
     if (m_forceTimeBasedEviction) {
       EvictBasedOnTime(key);
     }
 
-    Evict(key.m_size + value.m_size + Metadata::c_metaDataSize);
+    Evict(key, key.m_size + operand.m_size + Metadata::c_metaDataSize);
+
+    const auto curEpochTime = this->GetMetadataEpochTime();
+
+    this->UpsertRecord(key, [&](const RecordBuffer* existingRecord) {
+      auto existingValue =
+          (existingRecord != nullptr)
+              ? this->m_recordSerializer.Deserialize(*existingRecord).m_value
+              : Value{};
+      const bool isFound = (existingRecord != nullptr) &&
+                           this->ResolveValue(existingValue, curEpochTime);
+
+      auto* record = this->CreateMergedRecordBuffer(
+          key, isFound ? &existingValue : nullptr, operand, mergeOperator,
+          Metadata::c_metaDataSize);
+
+      const auto value = this->m_recordSerializer.Deserialize(*record).m_value;
+      auto* metadataBuffer = const_cast<std::uint32_t*>(
+          reinterpret_cast<const std::uint32_t*>(value.m_data));
+      Metadata metadata{metadataBuffer, curEpochTime, this->m_recordTimeToLive};
+      InitializeEvictionState(metadata, key);
+
+      return record;
+    });
+  }
+
+  // The records in BulkLoad() and AddBatch() are added one by one since each
+  // of them may evict others.
+  virtual void BulkLoad(const KeyValue* records,
+                        std::size_t numRecords,
+                        const BulkLoadOptions& options) override {
+    IWritableHashTable::BulkLoad(records, numRecords, options);
+  }
+
+  virtual void AddBatch(const KeyValue* records,
+                        std::size_t numRecords) override {
+    IWritableHashTable::AddBatch(records, numRecords);
+  }
+
+  // Once the cache size goes above the high watermark, evicts the records
+  // until it goes down to the low watermark. Each eviction shard frees an
+  // equal share of the bytes in turn. This does nothing if the background
+  // eviction is not configured.
+  virtual std::size_t EvictToWatermark() override {
+    if (!m_isBackgroundEvictionEnabled ||
+        GetTotalDataSize() <= m_highWatermarkInBytes) {
+      return 0U;
+    }
+
+    std::size_t numRecordsEvicted = 0U;
+
+    for (std::size_t i = 0U; i < m_evictionShards.size(); ++i) {
+      auto& shard = m_evictionShards[i];
+      Lock evictLock{shard.m_mutex};
+
+      // Recheck since the writers may have evicted in the meantime.
+      const auto totalDataSize = GetTotalDataSize();
+      if (totalDataSize <= m_lowWatermarkInBytes) {
+        break;
+      }
+
+      const std::uint64_t numShardsRemaining = m_evictionShards.size() - i;
+      numRecordsEvicted += EvictRecords(
+          shard, (totalDataSize - m_lowWatermarkInBytes + numShardsRemaining -
+                  1U) / numShardsRemaining);
+    }
+
+    this->m_hashTable.m_perfData.Add(
+        HashTablePerfCounter::BackgroundEvictedRecordsCount,
+        numRecordsEvicted);
 
-    WritableBase::Add(CreateRecordBuffer(key, value));
+    return numRecordsEvicted;
   }
 
   virtual ISerializerPtr GetSerializer() const override {
@@ -192,14 +430,46 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
   using Mutex = std::mutex;
   using Lock = std::lock_guard<Mutex>;
 
+  // EvictionShard struct is the CLOCK hand over a contiguous range of the
+  // buckets and the lock that serializes the eviction in the range, so that
+  // the writers evicting in different shards do not wait on each other.
+  struct EvictionShard {
+    Mutex m_mutex;
+    std::uint64_t m_currentEvictBucketIndex = 0U;
+    std::uint64_t m_beginBucketIndex = 0U;
+    std::uint64_t m_numBuckets = 0U;
+
+    // Keeps the shards on separate cache lines.
+    char m_padding[Utils::c_cacheLineSize -
+                   (sizeof(Mutex) + 3U * sizeof(std::uint64_t)) %
+                       Utils::c_cacheLineSize];
+  };
+
+  // The eviction states kept in the metadata (see EvictionPolicy).
+  enum EvictionState : std::uint8_t {
+    // S3Fifo.
+    c_smallQueue = 0U,
+    c_mainQueue = 1U,
+
+    // ClockPro.
+    c_cold = 0U,
+    c_coldInTest = 1U,
+    c_hot = 2U
+  };
+
+  // The number of the keys that the ghost table can remember per bucket,
+  // which is the number of the records in a bucket without chaining.
+  static constexpr std::size_t c_numGhostKeysPerBucket =
+      HashTable::Entry::c_numDataPerEntry;
+
   void EvictBasedOnTime(const Key& key) {
-    const auto bucketIndex = this->GetBucketInfo(key).first;
+    const auto hash = this->GetBucketInfo(key).first;
 
-    auto* entry = &(this->m_hashTable.m_buckets[bucketIndex]);
+    auto* entry = &(this->m_hashTable.GetBucket(hash));
 
-    const auto curEpochTime = this->GetCurrentEpochTime();
+    const auto curEpochTime = this->GetMetadataEpochTime();
 
-    typename HashTable::Lock lock{this->m_hashTable.GetMutex(bucketIndex)};
+    typename HashTable::Lock lock{this->m_hashTable.GetMutex(hash)};
 
     while (entry != nullptr) {
       for (std::uint8_t i = 0; i < HashTable::Entry::c_numDataPerEntry; ++i) {
@@ -210,7 +480,7 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
               const_cast<std::uint32_t*>(reinterpret_cast<const std::uint32_t*>(
                   this->m_recordSerializer.Deserialize(*data).m_value.m_data))};
 
-          if (metadata.IsExpired(curEpochTime, this->m_recordTimeToLive)) {
+          if (metadata.IsExpired(curEpochTime)) {
             WritableBase::Remove(*entry, i);
             this->m_hashTable.m_perfData.Increment(
                 HashTablePerfCounter::EvictedRecordsCount);
@@ -222,44 +492,66 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
     }
   }
 
-  // Evict uses CLOCK algorithm to evict records based on expiration and access
-  // status until the number of bytes freed match the given number of bytes
-  // needed.
-  void Evict(std::uint64_t bytesNeeded) {
-    std::uint64_t numBytesToFree = CalculateNumBytesToFree(bytesNeeded);
-    if (numBytesToFree == 0U) {
+  // Evict makes room for the given number of bytes needed if the cache is
+  // full, which stalls the writer. The records are evicted only in the shard
+  // that the given key belongs to.
+  void Evict(const Key& key, std::uint64_t bytesNeeded) {
+    if (CalculateNumBytesToFree(bytesNeeded) == 0U) {
       return;
     }
 
-    // Start evicting records with a lock.
-    Lock evictLock{m_evictMutex};
+    const auto startTime = std::chrono::steady_clock::now();
 
-    // Recalculate the number of bytes to free since other thread may have
-    // already evicted.
-    numBytesToFree = CalculateNumBytesToFree(bytesNeeded);
-    if (numBytesToFree == 0U) {
-      return;
+    {
+      // Start evicting records with a lock.
+      auto& shard = GetEvictionShard(key);
+      Lock evictLock{shard.m_mutex};
+
+      // Recalculate the number of bytes to free since other thread may have
+      // already evicted.
+      const auto numBytesToFree = CalculateNumBytesToFree(bytesNeeded);
+      if (numBytesToFree != 0U) {
+        EvictRecords(shard, numBytesToFree);
+      }
     }
 
-    const auto curEpochTime = this->GetCurrentEpochTime();
+    auto& perfData = this->m_hashTable.m_perfData;
+    perfData.Increment(HashTablePerfCounter::InlineEvictionsCount);
+    perfData.Add(HashTablePerfCounter::InlineEvictionMicroseconds,
+                 std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - startTime)
+                     .count());
+  }
 
-    // The max number of iterations we are going through per eviction is twice
-    // the number of buckets so that it can clear the access status. Note that
-    // this is the worst case scenario and the eviction process should exit much
-    // quicker in a normal case.
-    auto& buckets = this->m_hashTable.m_buckets;
-    std::uint64_t numIterationsRemaining = buckets.size() * 2U;
+  // EvictRecords sweeps the buckets of the given shard with its CLOCK hand to
+  // evict records based on expiration and the eviction policy until the
+  // number of bytes freed match the given number of bytes to free, and
+  // returns the number of the records evicted. It is assumed that this
+  // function is called under the lock of the shard.
+  std::size_t EvictRecords(EvictionShard& shard, std::uint64_t numBytesToFree) {
+    const auto curEpochTime = this->GetMetadataEpochTime();
+    std::size_t numRecordsEvicted = 0U;
+
+    // The max number of iterations we are going through per eviction is the
+    // number of buckets times the number of passes that a record can survive
+    // so that it can clear the access status. Note that this is the worst case
+    // scenario and the eviction process should exit much quicker in a normal
+    // case.
+    auto& buckets = this->m_hashTable.GetBuckets();
+    std::uint64_t numIterationsRemaining =
+        shard.m_numBuckets * GetMaxNumPasses();
 
     while (numBytesToFree > 0U && numIterationsRemaining-- > 0U) {
       const auto currentBucketIndex =
-          m_currentEvictBucketIndex++ % buckets.size();
+          shard.m_beginBucketIndex +
+          shard.m_currentEvictBucketIndex++ % shard.m_numBuckets;
       auto& bucket = buckets[currentBucketIndex];
 
       // Lock the bucket since another thread can bypass Evict() since
-      // TotalDataSize can be updated before the lock on m_evictMutex is
+      // TotalDataSize can be updated before the lock on the shard is
       // released.
       typename HashTable::UniqueLock lock{
-          this->m_hashTable.GetMutex(currentBucketIndex)};
+          this->m_hashTable.GetBucketMutex(currentBucketIndex, buckets.size())};
       typename HashTable::Entry* entry = &bucket;
 
       while (entry != nullptr) {
@@ -276,16 +568,17 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
 
             // Evict this record if
             // 1: the record is expired, or
-            // 2: the entry is not recently accessed (and unset the access bit
-            // if set).
-            if (metadata.IsExpired(curEpochTime, this->m_recordTimeToLive) ||
-                !metadata.UpdateAccessStatus(false)) {
+            // 2: the eviction policy decides so (which updates the access
+            // count and the eviction state otherwise).
+            if (metadata.IsExpired(curEpochTime) ||
+                ShouldEvict(metadata, record.m_key)) {
               const auto numBytesFreed = record.m_key.m_size + value.m_size;
               numBytesToFree = (numBytesFreed >= numBytesToFree)
                                    ? 0U
                                    : numBytesToFree - numBytesFreed;
 
               WritableBase::Remove(*entry, i);
+              ++numRecordsEvicted;
 
               this->m_hashTable.m_perfData.Increment(
                   HashTablePerfCounter::EvictedRecordsCount);
@@ -296,35 +589,153 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
         entry = entry->m_next.Load(std::memory_order_relaxed);
       }
     }
+
+    return numRecordsEvicted;
   }
 
-  // Given the number of bytes needed, it calculates the number of bytes
-  // to free based on the max cache size.
-  std::uint64_t CalculateNumBytesToFree(std::uint64_t bytesNeeded) const {
-    const auto& perfData = GetPerfData();
+  // Returns true if the record with the given metadata and key should be
+  // evicted as the hand passes it. Otherwise, updates the access count and the
+  // eviction state for the next pass.
+  bool ShouldEvict(Metadata& metadata, const Key& key) {
+    switch (m_evictionPolicy) {
+      case EvictionPolicy::S3Fifo:
+        if (metadata.GetEvictionState() == c_mainQueue) {
+          return !metadata.DecrementAccessCount();
+        }
 
-    const std::uint64_t totalDataSize =
-        perfData.Get(HashTablePerfCounter::TotalKeySize) +
-        perfData.Get(HashTablePerfCounter::TotalValueSize) +
-        perfData.Get(HashTablePerfCounter::TotalIndexSize);
+        if (metadata.IsAccessed()) {
+          metadata.SetEvictionState(c_mainQueue);
+          return false;
+        }
+
+        AddGhostKey(key);
+        return true;
+
+      case EvictionPolicy::ClockPro:
+        if (metadata.GetEvictionState() == c_hot) {
+          if (!metadata.UpdateAccessStatus(false)) {
+            metadata.SetEvictionState(c_cold);
+          }
+          return false;
+        }
+
+        if (metadata.UpdateAccessStatus(false)) {
+          metadata.SetEvictionState(
+              (metadata.GetEvictionState() == c_coldInTest) ? c_hot
+                                                            : c_coldInTest);
+          return false;
+        }
+
+        if (metadata.GetEvictionState() == c_coldInTest) {
+          AddGhostKey(key);
+        }
+        return true;
+
+      default:
+        return !metadata.UpdateAccessStatus(false);
+    }
+  }
 
-    if ((bytesNeeded < m_maxCacheSizeInBytes) &&
-        (totalDataSize + bytesNeeded <= m_maxCacheSizeInBytes)) {
+  // Returns the max number of times the hand passes a record until it is
+  // evicted if the record is not accessed in the meantime.
+  std::uint64_t GetMaxNumPasses() const {
+    switch (m_evictionPolicy) {
+      case EvictionPolicy::S3Fifo:
+        // Moves to the main queue, then takes each access.
+        return 2U + Metadata::c_maxAccessCount;
+      case EvictionPolicy::ClockPro:
+        // Hot, cold, then evicted.
+        return 3U;
+      default:
+        return 2U;
+    }
+  }
+
+  // Sets the eviction state of a new record with the given key.
+  void InitializeEvictionState(Metadata& metadata, const Key& key) {
+    switch (m_evictionPolicy) {
+      case EvictionPolicy::S3Fifo:
+        metadata.SetEvictionState(RemoveGhostKey(key) ? c_mainQueue
+                                                      : c_smallQueue);
+        break;
+      case EvictionPolicy::ClockPro:
+        metadata.SetEvictionState(RemoveGhostKey(key) ? c_hot : c_coldInTest);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // The ghost table is a direct-mapped table of the fingerprints of the keys
+  // recently evicted, where a newer key overwrites an older one in the same
+  // slot. Returns the slot and the (non-zero) fingerprint of the given key.
+  std::pair<std::atomic<std::uint32_t>*, std::uint32_t> GetGhostKey(
+      const Key& key) {
+    const auto hash = this->GetBucketInfo(key).first;
+
+    return {&m_ghostKeys[hash % m_ghostKeys.size()],
+            static_cast<std::uint32_t>(hash >> 32U) | 1U};
+  }
+
+  void AddGhostKey(const Key& key) {
+    const auto ghostKey = GetGhostKey(key);
+    ghostKey.first->store(ghostKey.second, std::memory_order_relaxed);
+  }
+
+  // Returns true if the given key is in the ghost table, removing it.
+  bool RemoveGhostKey(const Key& key) {
+    auto ghostKey = GetGhostKey(key);
+    return ghostKey.first->compare_exchange_strong(
+        ghostKey.second, 0U, std::memory_order_relaxed);
+  }
+
+  // Returns the eviction shard that the bucket of the given key belongs to.
+  EvictionShard& GetEvictionShard(const Key& key) {
+    const std::uint64_t numBuckets = this->m_hashTable.GetBuckets().size();
+    const std::uint64_t bucketIndex = this->m_hashTable.GetBucketIndex(
+        this->GetBucketInfo(key).first, numBuckets);
+
+    return m_evictionShards[bucketIndex * m_evictionShards.size() /
+                            numBuckets];
+  }
+
+  // Given the number of bytes needed, it calculates the number of bytes to
+  // free in a shard based on the budget of the shard, which is an equal
+  // share of the max cache size. Since the keys are hashed uniformly to the
+  // shards, the data size of a shard is estimated as its share of the total
+  // data size instead of being tracked per shard.
+  std::uint64_t CalculateNumBytesToFree(std::uint64_t bytesNeeded) const {
+    const auto shardDataSize = GetTotalDataSize() / m_evictionShards.size();
+
+    if ((bytesNeeded < m_shardCacheSizeInBytes) &&
+        (shardDataSize + bytesNeeded <= m_shardCacheSizeInBytes)) {
       // There are enough free bytes.
       return 0U;
     }
 
-    // (totalDataSize > m_maxCacheSizeInBytes) case is possible:
+    // (shardDataSize > m_shardCacheSizeInBytes) case is possible:
     // 1) If multiple threads are evicting and adding at the same time.
     //    For example, if thread A was evicting and thread B could have
     //    used the evicted bytes before thread A consumed.
     // 2) If max cache size is set lower than expectation.
-    return (totalDataSize > m_maxCacheSizeInBytes)
-               ? (totalDataSize - m_maxCacheSizeInBytes + bytesNeeded)
+    return (shardDataSize > m_shardCacheSizeInBytes)
+               ? (shardDataSize - m_shardCacheSizeInBytes + bytesNeeded)
                : bytesNeeded;
   }
 
-  RecordBuffer* CreateRecordBuffer(const Key& key, const Value& value) {
+  // Returns the number of bytes counted against the max cache size.
+  std::uint64_t GetTotalDataSize() const {
+    const auto& perfData = GetPerfData();
+
+    return static_cast<std::uint64_t>(
+        perfData.Get(HashTablePerfCounter::TotalKeySize) +
+        perfData.Get(HashTablePerfCounter::TotalValueSize) +
+        perfData.Get(HashTablePerfCounter::TotalIndexSize));
+  }
+
+  RecordBuffer* CreateRecordBuffer(const Key& key,
+                                   const Value& value,
+                                   std::chrono::seconds timeToLive) {
     const auto bufferSize =
         this->m_recordSerializer.CalculateBufferSize(key, value);
     auto buffer = Detail::to_raw_pointer(
@@ -332,7 +743,9 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
             bufferSize));
 
     std::uint32_t metaDataBuffer;
-    Metadata{&metaDataBuffer, this->GetCurrentEpochTime()};
+    Metadata metadata{&metaDataBuffer, this->GetMetadataEpochTime(),
+                      timeToLive};
+    InitializeEvictionState(metadata, key);
 
     // 4-byte Metadata is inserted between key and value buffer.
     return this->m_recordSerializer.Serialize(
@@ -342,10 +755,22 @@ class WritableHashTable : public ReadOnlyHashTable<Allocator, Clock>,
         buffer, bufferSize);
   }
 
-  Mutex m_evictMutex;
   const std::uint64_t m_maxCacheSizeInBytes;
   const bool m_forceTimeBasedEviction;
-  std::uint64_t m_currentEvictBucketIndex;
+  const EvictionPolicy m_evictionPolicy;
+  const bool m_isBackgroundEvictionEnabled;
+  const std::uint64_t m_lowWatermarkInBytes;
+  const std::uint64_t m_highWatermarkInBytes;
+
+  // The byte budget of each eviction shard.
+  const std::uint64_t m_shardCacheSizeInBytes;
+
+  // The eviction shards (see HashTableConfig::Cache::m_numEvictionShards).
+  std::vector<EvictionShard> m_evictionShards;
+
+  // The ghost table (see GetGhostKey()), which is used by the policies other
+  // than EvictionPolicy::Clock.
+  std::vector<std::atomic<std::uint32_t>> m_ghostKeys;
 };
 
 #pragma warning(pop)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
@@ -9,83 +10,146 @@ namespace HashTable {
 namespace Cache {
 
 // Metadata class that stores caching related data.
-// It stores access bit to indicate whether a record is recently accessed
-// as well as the epoch time when a record is created.
+// It stores the access count to indicate how often a record is recently
+// accessed and the state used by the eviction policy, as well as the epoch
+// time when a record expires, so that each record can have its own time to
+// live. The epoch times are relative to the base chosen by the cache hash
+// table (see ReadOnlyHashTable::GetMetadataEpochTime()).
 // Note that this works regardless of the alignment of the metadata passed in.
 class Metadata {
  public:
-  // Constructs Metadata with the current epoch time.
-  Metadata(std::uint32_t* metadata, std::chrono::seconds curEpochTime)
+  // Constructs Metadata that expires after the given time to live from the
+  // current epoch time. The expiration time is capped at the largest epoch
+  // time that can be stored.
+  Metadata(std::uint32_t* metadata,
+           std::chrono::seconds curEpochTime,
+           std::chrono::seconds timeToLive)
       : Metadata{metadata} {
-    *m_metadata = curEpochTime.count() & s_epochTimeMask;
+    const std::int64_t maxEpochTime = s_epochTimeMask;
+    const auto expirationTime =
+        (curEpochTime.count() & s_epochTimeMask) +
+        (std::min)((std::max)(static_cast<std::int64_t>(timeToLive.count()),
+                              std::int64_t{0}),
+                   maxEpochTime);
+    *m_metadata =
+        static_cast<std::uint32_t>((std::min)(expirationTime, maxEpochTime));
   }
 
   explicit Metadata(std::uint32_t* metadata) : m_metadata{metadata} {
     assert(m_metadata != nullptr);
   }
 
-  // Returns the stored epoch time.
-  std::chrono::seconds GetEpochTime() const {
+  // Returns the stored epoch time when the record expires.
+  std::chrono::seconds GetExpirationTime() const {
     // *m_metadata even on the not-aligned memory should be fine since
-    // only the byte that contains the access bit is modified, and
-    // byte read is atomic.
+    // only the byte that contains the access count and the eviction state is
+    // modified, and byte read is atomic.
     return std::chrono::seconds{*m_metadata & s_epochTimeMask};
   }
 
-  // Returns true if the stored epoch time is expired based
-  // on the given current epoch time and time-to-live value.
-  bool IsExpired(std::chrono::seconds curEpochTime,
-                 std::chrono::seconds timeToLive) const {
-    assert(curEpochTime >= GetEpochTime());
-    return (curEpochTime - GetEpochTime()) > timeToLive;
+  // Returns true if the stored expiration time has passed at the given
+  // current epoch time.
+  bool IsExpired(std::chrono::seconds curEpochTime) const {
+    return curEpochTime > GetExpirationTime();
   }
 
-  // Returns true if the access status is on.
-  bool IsAccessed() const { return !!(GetAccessByte() & s_accessSetMask); }
+  // Returns true if the access count is not zero.
+  bool IsAccessed() const { return GetAccessCount() != 0U; }
 
-  // If "set" is true, turn on the access bit in the given metadata and store
-  // it. If "set" is false, turn off the access bit. Returns true if the given
-  // metadata's access bit was originally on.
+  // Returns the access count, which saturates at c_maxAccessCount.
+  std::uint8_t GetAccessCount() const {
+    return (GetStateByte() & s_accessCountMask) >> s_accessCountShift;
+  }
+
+  // If "set" is true, increment the access count unless it is saturated. If
+  // "set" is false, reset the access count to zero. Returns true if the
+  // access count was originally not zero.
+  // Note that the readers update the access count without synchronization,
+  // thus a concurrent update may be lost, which is fine for the eviction.
   bool UpdateAccessStatus(bool set) {
-    const auto isAccessBitOn = IsAccessed();
-
-    // Set the bit only if the bit is not set, and vice versa.
-    if (set != isAccessBitOn) {
-      if (set) {
-        GetAccessByte() |= s_accessSetMask;
-      } else {
-        GetAccessByte() &= s_accessUnsetMask;
-      }
+    const auto accessCount = GetAccessCount();
+
+    // Store only if the count changes, so that the frequently accessed
+    // records are not written by every read.
+    if (set && accessCount < c_maxAccessCount) {
+      SetAccessCount(accessCount + 1U);
+    } else if (!set && accessCount != 0U) {
+      SetAccessCount(0U);
     }
 
-    return isAccessBitOn;
+    return accessCount != 0U;
   }
 
-  static constexpr std::uint16_t c_metaDataSize = sizeof(std::uint32_t);
+  // Decrements the access count if it is not zero. Returns true if the access
+  // count was originally not zero.
+  bool DecrementAccessCount() {
+    const auto accessCount = GetAccessCount();
+    if (accessCount == 0U) {
+      return false;
+    }
 
- private:
-  std::uint8_t GetAccessByte() const {
-    return reinterpret_cast<std::uint8_t*>(m_metadata)[s_accessBitByte];
+    SetAccessCount(accessCount - 1U);
+    return true;
   }
 
-  std::uint8_t& GetAccessByte() {
-    return reinterpret_cast<std::uint8_t*>(m_metadata)[s_accessBitByte];
+  // Returns the state that the eviction policy keeps for the record, which is
+  // less than c_numEvictionStates.
+  std::uint8_t GetEvictionState() const {
+    return (GetStateByte() & s_evictionStateMask) >> s_evictionStateShift;
   }
 
-  // TODO: Create an endian test and assert it. (Works only on little endian).
-  // The byte that contains the most significant bit.
-  static constexpr std::uint8_t s_accessBitByte = 3U;
+  void SetEvictionState(std::uint8_t state) {
+    assert(state < c_numEvictionStates);
+    GetStateByte() = static_cast<std::uint8_t>(
+        (GetStateByte() & ~s_evictionStateMask) |
+        (state << s_evictionStateShift));
+  }
+
+  static constexpr std::uint16_t c_metaDataSize = sizeof(std::uint32_t);
 
-  // Most significant bit is set.
-  static constexpr std::uint8_t s_accessSetMask = 1U << 7;
-  static constexpr std::uint8_t s_accessUnsetMask = s_accessSetMask ^ 0xFF;
+  static constexpr std::uint8_t c_maxAccessCount = 3U;
 
-  // The rest of bits other than the most significant bit are set.
-  static constexpr std::uint32_t s_epochTimeMask = 0x7FFFFFFF;
+  static constexpr std::uint8_t c_numEvictionStates = 4U;
 
-  // The most significant bit is a CLOCK bit. It is set to 1 upon access
-  // and reset to 0 by the cache eviction.
-  // The rest of the bits are used for storing the epoch time in seconds.
+  // The largest epoch time that can be stored, which is about 8.5 years.
+  static constexpr std::uint32_t c_maxEpochTime = 0x0FFFFFFF;
+
+ private:
+  void SetAccessCount(unsigned accessCount) {
+    GetStateByte() = static_cast<std::uint8_t>(
+        (GetStateByte() & ~s_accessCountMask) |
+        (accessCount << s_accessCountShift));
+  }
+
+  std::uint8_t GetStateByte() const {
+    return reinterpret_cast<std::uint8_t*>(m_metadata)[s_stateByte];
+  }
+
+  std::uint8_t& GetStateByte() {
+    return reinterpret_cast<std::uint8_t*>(m_metadata)[s_stateByte];
+  }
+
+  // TODO: Create an endian test and assert it. (Works only on little endian).
+  // The byte that contains the most significant bits.
+  static constexpr std::uint8_t s_stateByte = 3U;
+
+  // The two most significant bits are the access count.
+  static constexpr std::uint8_t s_accessCountShift = 6U;
+  static constexpr std::uint8_t s_accessCountMask = 3U << s_accessCountShift;
+
+  // The next two bits are the eviction state.
+  static constexpr std::uint8_t s_evictionStateShift = 4U;
+  static constexpr std::uint8_t s_evictionStateMask = 3U
+                                                      << s_evictionStateShift;
+
+  // The rest of bits other than the four most significant bits are set.
+  static constexpr std::uint32_t s_epochTimeMask = c_maxEpochTime;
+
+  // The two most significant bits are a CLOCK counter. It is incremented upon
+  // access and decremented or reset by the cache eviction. The next two bits
+  // are the eviction state (see HashTableConfig::Cache::EvictionPolicy).
+  // The rest of the bits are used for storing the expiration epoch time in
+  // seconds.
   std::uint32_t* m_metadata = nullptr;
 };
 
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/Record.h"
+#include "HashTable/Common/SharedHashTable.h"
+#include "HashTable/Common/TagMatcher.h"
+#include "Interprocess/Container/Vector.h"
+#include "Log/PerfCounter.h"
+#include "Utils/AtomicOffsetPtr.h"
+#include "Utils/HugePages.h"
+#include "Utils/Lock.h"
+
+namespace L4 {
+namespace HashTable {
+
+// CuckooSharedHashTable struct represents the hash table structure for the
+// bucketized cuckoo hashing (see HashTableConfig::Engine::Cuckoo). Each key has
+// two candidate buckets derived from its hash value and is always placed in one
+// of them, so a look up reads at most two buckets regardless of the load. When
+// both buckets are full, the records are moved to their other buckets along a
+// path found by a breadth-first search until one of the buckets has room.
+template <typename TAllocator>
+struct CuckooSharedHashTable {
+  using Allocator = TAllocator;
+
+  // CuckooSharedHashTable::Bucket struct represents 8 slots. Bucket layout is
+  // as follows:
+  //
+  // | tag1          | tag2          | tag3          | tag4           | 1
+  // | tag5          | tag6          | tag7          | tag8           | 2
+  // | version                       | (padding)                      | 3
+  // | Data1 pointer                                                  | 4
+  // | ...                                                            |
+  // | Data8 pointer                                                  | 11
+  // <----------------------8 bytes ---------------------------------->
+  //
+  // A slot is empty if its data pointer is nullptr. The version is odd while a
+  // record is being moved into or out of the bucket, so that a reader that
+  // does not find a key can tell whether the key might have been moved between
+  // its two buckets during the look up (see Cuckoo::ReadOnlyHashTable::Find()).
+  struct Bucket {
+    static constexpr std::uint8_t c_numSlots = TagMatcher::c_numTags / 2U;
+
+    // Returns a bit mask of the slots whose tag matches the given tag.
+    TagMatcher::Mask MatchTag(std::uint16_t tag) const {
+      return TagMatcher::Match(m_tags, tag);
+    }
+
+    // Returns a bit mask of the empty slots. It is assumed that this function
+    // is called under a lock.
+    TagMatcher::Mask MatchEmpty() const {
+      TagMatcher::Mask mask = 0U;
+      for (std::uint8_t i = 0; i < c_numSlots; ++i) {
+        mask |= static_cast<TagMatcher::Mask>(
+                    m_dataList[i].Load(std::memory_order_relaxed) == nullptr)
+                << i;
+      }
+
+      return mask;
+    }
+
+    // Makes the version odd before moving a record. The fence keeps the
+    // following stores from being reordered before the version update.
+    void BeginMove() {
+      m_version.store(m_version.load(std::memory_order_relaxed) + 1U,
+                      std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // Makes the version even again after moving a record.
+    void EndMove() {
+      m_version.store(m_version.load(std::memory_order_relaxed) + 1U,
+                      std::memory_order_release);
+    }
+
+    TagMatcher::HalfWideTags m_tags{};
+
+    std::atomic<std::uint32_t> m_version{0U};
+
+    std::array<Utils::AtomicOffsetPtr<RecordBuffer>, c_numSlots> m_dataList{};
+  };
+
+  static_assert(sizeof(Bucket) == 88, "Bucket should be 88 bytes.");
+
+  using Setting = typename SharedHashTable<RecordBuffer, Allocator>::Setting;
+
+  using Mutex = Utils::ReaderWriterLockSlim;
+  using Lock = std::lock_guard<Mutex>;
+  using UniqueLock = std::unique_lock<Mutex>;
+
+  using BucketAllocator = Utils::HugePageAllocator<
+      typename Allocator::template rebind<Bucket>::other>;
+
+  using Buckets = Interprocess::Container::Vector<Bucket, BucketAllocator>;
+  using Mutexes = Interprocess::Container::
+      Vector<Mutex, typename Allocator::template rebind<Mutex>::other>;
+
+  // The indexes of the two candidate buckets of a key.
+  using BucketIndexes = std::pair<std::uint32_t, std::uint32_t>;
+
+  CuckooSharedHashTable(const Setting& setting, Allocator allocator)
+      : m_allocator{allocator},
+        m_setting{setting},
+        m_buckets{
+            (std::max)(setting.m_numBuckets, 1U),
+            BucketAllocator(m_allocator, setting.m_hugePages)},
+        m_mutexes{
+            (std::max)(setting.m_numBuckets /
+                           (std::max)(setting.m_numBucketsPerMutex, 1U),
+                       1U),
+            typename Allocator::template rebind<Mutex>::other(m_allocator)},
+        m_perfData{} {
+    m_perfData.Set(HashTablePerfCounter::BucketsCount, m_buckets.size());
+    m_perfData.Set(HashTablePerfCounter::HugePageBytes,
+                   m_buckets.get_allocator().GetHugePageBytes(
+                       Detail::to_raw_pointer(m_buckets.data())));
+    m_perfData.Set(HashTablePerfCounter::TotalIndexSize,
+                   (m_buckets.size() * sizeof(Bucket)) +
+                       (m_mutexes.size() * sizeof(Mutex)) +
+                       sizeof(CuckooSharedHashTable));
+  }
+
+  ~CuckooSharedHashTable() {
+    for (auto& bucket : m_buckets) {
+      for (auto& data : bucket.m_dataList) {
+        auto* dataToDelete = data.Load();
+        if (dataToDelete != nullptr) {
+          dataToDelete->~RecordBuffer();
+          GetAllocator<RecordBuffer>().deallocate(dataToDelete, 1U);
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  auto GetAllocator() const {
+    return typename Allocator::template rebind<T>::other(m_allocator);
+  }
+
+  // Returns the mutex guarding the bucket with the given index. Unlike
+  // SharedHashTable::GetMutex(), it takes the bucket index since a key has two
+  // buckets, whose mutexes are both taken by a writer.
+  Mutex& GetMutex(std::uint32_t bucketIndex) {
+    return m_mutexes[bucketIndex % m_mutexes.size()];
+  }
+
+  const Buckets& GetBuckets() const { return m_buckets; }
+
+  Buckets& GetBuckets() { return m_buckets; }
+
+  // Returns the indexes of the two candidate buckets for the given hash value.
+  // The second index is from the hash value remixed with a multiplication, and
+  // is made different from the first one if there are more than one bucket.
+  BucketIndexes GetBucketIndexes(std::uint64_t hash) const {
+    const auto numBuckets = static_cast<std::uint32_t>(m_buckets.size());
+    const auto first =
+        Hasher::GetBucketIndex(m_setting.m_rangeReduction, hash, numBuckets);
+
+    auto remixed = hash * 0x9E3779B97F4A7C15ULL;
+    remixed ^= remixed >> 32U;
+
+    auto second = Hasher::GetBucketIndex(m_setting.m_rangeReduction, remixed,
+                                         numBuckets);
+    if (second == first && numBuckets > 1U) {
+      second = (first + 1U) % numBuckets;
+    }
+
+    return {first, second};
+  }
+
+  Allocator m_allocator;
+
+  const Setting m_setting;
+
+  Buckets m_buckets;
+
+  Mutexes m_mutexes;
+
+  // Serializes the writers that move records to make room, since a path of
+  // moves spans the buckets guarded by different mutexes.
+  Mutex m_displacementMutex;
+
+  HashTablePerfData m_perfData;
+
+  CuckooSharedHashTable(const CuckooSharedHashTable&) = delete;
+  CuckooSharedHashTable& operator=(const CuckooSharedHashTable&) = delete;
+};
+
+}  // namespace HashTable
+}  // namespace L4
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "Utils/MurmurHash3.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define L4_HASHER_CRC32C_SSE4_2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace L4 {
+namespace HashTable {
+
+// HashFunction specifies the hash function used for the keys of a hash table.
+// Note that the value is persisted by the serializer, so the existing values
+// should not be changed.
+enum class HashFunction : std::uint8_t {
+  // MurmurHash3_x64_128, which is the default.
+  MurmurHash3 = 0U,
+
+  // A wyhash style hash function, which is much faster for short keys.
+  WyHash,
+
+  // CRC32C, which uses the SSE4.2 crc32 instruction if available. The hash
+  // value has only 32 bits of entropy.
+  Crc32c
+};
+
+// RangeReduction specifies how the hash value is mapped to a bucket index.
+// Note that the value is persisted by the serializer, so the existing values
+// should not be changed.
+enum class RangeReduction : std::uint8_t {
+  // hash % numBuckets.
+  Modulo = 0U,
+
+  // ((hash >> 32) * numBuckets) >> 32, which avoids the 64-bit division.
+  MultiplyShift
+};
+
+// Each hasher policy below provides "static HashValue Hash(data, size)" where
+// HashValue is a pair of the hash value, which determines the bucket, and the
+// 16-bit tag value. The tag value is taken from the bits that are not used by
+// the multiply-shift range reduction.
+using HashValue = std::pair<std::uint64_t, std::uint16_t>;
+
+// MurmurHash3Hasher uses the first half of the 128-bit hash value as the hash
+// value and the second half for the tag value.
+struct MurmurHash3Hasher {
+  static HashValue Hash(const void* data, std::size_t size) {
+    std::array<std::uint64_t, 2> hash;
+    MurmurHash3_x64_128(data, static_cast<int>(size), 0U, hash.data());
+
+    return {hash[0], static_cast<std::uint16_t>(hash[1])};
+  }
+};
+
+// WyHasher implements the wyhash (final version 4) algorithm without the
+// three-way loop for the keys longer than 48 bytes, which is unrolled in the
+// original for throughput. The keys up to 16 bytes are hashed with a couple of
+// overlapping reads and two 64x64->128 bit multiplications.
+struct WyHasher {
+  static HashValue Hash(const void* data, std::size_t size) {
+    const auto* p = static_cast<const std::uint8_t*>(data);
+
+    auto seed = Mix(c_secret0, c_secret1);
+    std::uint64_t a = 0U;
+    std::uint64_t b = 0U;
+
+    if (size <= 16U) {
+      if (size >= 4U) {
+        const auto offset = (size >> 3U) << 2U;
+        a = (Read4(p) << 32U) | Read4(p + offset);
+        b = (Read4(p + size - 4U) << 32U) | Read4(p + size - 4U - offset);
+      } else if (size > 0U) {
+        a = (static_cast<std::uint64_t>(p[0]) << 16U) |
+            (static_cast<std::uint64_t>(p[size >> 1U]) << 8U) | p[size - 1U];
+      }
+    } else {
+      auto remaining = size;
+      while (remaining > 16U) {
+        seed = Mix(Read8(p) ^ c_secret1, Read8(p + 8U) ^ seed);
+        p += 16U;
+        remaining -= 16U;
+      }
+
+      a = Read8(p + remaining - 16U);
+      b = Read8(p + remaining - 8U);
+    }
+
+    a ^= c_secret1;
+    b ^= seed;
+    Multiply(a, b);
+
+    const auto hash = Mix(a ^ c_secret0 ^ size, b ^ c_secret1);
+
+    return {hash, static_cast<std::uint16_t>(hash >> 16U)};
+  }
+
+ private:
+  static constexpr std::uint64_t c_secret0 = 0xa0761d6478bd642fULL;
+  static constexpr std::uint64_t c_secret1 = 0xe7037ed1a0b428dbULL;
+
+  // Replaces a and b with the low and high 64 bits of a * b.
+  static void Multiply(std::uint64_t& a, std::uint64_t& b) {
+#if defined(__SIZEOF_INT128__)
+    const auto product = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<std::uint64_t>(product);
+    b = static_cast<std::uint64_t>(product >> 64U);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    a = _umul128(a, b, &b);
+#else
+    const auto ha = a >> 32U;
+    const auto hb = b >> 32U;
+    const auto la = static_cast<std::uint32_t>(a);
+    const auto lb = static_cast<std::uint32_t>(b);
+    const auto rh = ha * hb;
+    const auto rm0 = ha * lb;
+    const auto rm1 = hb * la;
+    const auto rl = static_cast<std::uint64_t>(la) * lb;
+    const auto t = rl + (rm0 << 32U);
+    auto carry = static_cast<std::uint64_t>(t < rl);
+    const auto lo = t + (rm1 << 32U);
+    carry += static_cast<std::uint64_t>(lo < t);
+    a = lo;
+    b = rh + (rm0 >> 32U) + (rm1 >> 32U) + carry;
+#endif
+  }
+
+  static std::uint64_t Mix(std::uint64_t a, std::uint64_t b) {
+    Multiply(a, b);
+    return a ^ b;
+  }
+
+  static std::uint64_t Read8(const std::uint8_t* p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static std::uint64_t Read4(const std::uint8_t* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+};
+
+// Crc32cHasher computes CRC32C of the key and spreads the 32-bit result over 64
+// bits with a multiplication so that both range reductions and the tag get
+// well distributed bits. The crc32 instruction is used if the code is compiled
+// with SSE4.2 enabled (e.g., -msse4.2 or /arch:AVX); otherwise, a bitwise
+// implementation, which produces the same value, is used.
+struct Crc32cHasher {
+  static HashValue Hash(const void* data, std::size_t size) {
+    const auto hash = (static_cast<std::uint64_t>(Crc32c(data, size)) + size) *
+                      0x9e3779b97f4a7c15ULL;
+
+    return {hash, static_cast<std::uint16_t>(hash >> 16U)};
+  }
+
+  // Returns CRC32C (Castagnoli) of the given data.
+  static std::uint32_t Crc32c(const void* data, std::size_t size) {
+    const auto* p = static_cast<const std::uint8_t*>(data);
+    std::uint32_t crc = 0xffffffffU;
+
+#if defined(L4_HASHER_CRC32C_SSE4_2)
+    std::uint64_t crc64 = crc;
+    for (; size >= sizeof(std::uint64_t);
+         size -= sizeof(std::uint64_t), p += sizeof(std::uint64_t)) {
+      std::uint64_t value;
+      std::memcpy(&value, p, sizeof(value));
+      crc64 = _mm_crc32_u64(crc64, value);
+    }
+
+    crc = static_cast<std::uint32_t>(crc64);
+    for (; size > 0U; --size, ++p) {
+      crc = _mm_crc32_u8(crc, *p);
+    }
+#else
+    for (; size > 0U; --size, ++p) {
+      crc ^= *p;
+      for (std::uint8_t i = 0U; i < 8U; ++i) {
+        crc = (crc >> 1U) ^ (0x82f63b78U & (0U - (crc & 1U)));
+      }
+    }
+#endif
+
+    return ~crc;
+  }
+};
+
+#undef L4_HASHER_CRC32C_SSE4_2
+
+// Hasher computes the hash value of a key with the given hash function.
+struct Hasher {
+  static HashValue Hash(HashFunction hashFunction,
+                        const void* data,
+                        std::size_t size) {
+    switch (hashFunction) {
+      case HashFunction::WyHash:
+        return WyHasher::Hash(data, size);
+      case HashFunction::Crc32c:
+        return Crc32cHasher::Hash(data, size);
+      default:
+        return MurmurHash3Hasher::Hash(data, size);
+    }
+  }
+
+  // Maps the given hash value to an index in [0, numBuckets).
+  static std::uint32_t GetBucketIndex(RangeReduction rangeReduction,
+                                      std::uint64_t hash,
+                                      std::uint64_t numBuckets) {
+    return static_cast<std::uint32_t>(
+        (rangeReduction == RangeReduction::MultiplyShift)
+            ? ((hash >> 32U) * numBuckets) >> 32U
+            : hash % numBuckets);
+  }
+};
+
+}  // namespace HashTable
+}  // namespace L4
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/Record.h"
+#include "HashTable/Common/SharedHashTable.h"
+#include "HashTable/Common/TagMatcher.h"
+#include "Interprocess/Container/Vector.h"
+#include "Log/PerfCounter.h"
+#include "Utils/AtomicOffsetPtr.h"
+#include "Utils/HugePages.h"
+#include "Utils/Lock.h"
+
+namespace L4 {
+namespace HashTable {
+
+// InlineSharedHashTable struct represents the hash table structure where the
+// records are stored in the bucket entries themselves instead of being
+// allocated separately. It is used for the hash tables with small fixed-size
+// keys and values (see HashTableConfig::Setting::m_inlineRecords).
+template <typename TAllocator>
+struct InlineSharedHashTable {
+  using Allocator = TAllocator;
+
+  // InlineSharedHashTable::Entry struct represents an entry in the chained
+  // bucket list. Entry layout is as follows:
+  //
+  // | tag1  | tag2  | tag3  | tag4  | tag5  | tag6  | tag7  | tag 8  | 1
+  // | tag9  | tag10 | tag11 | tag12 | tag13 | tag14 | tag15 | tag 16 | 2
+  // | state1 ... state8                                              | 3
+  // | state9 ... state16                                             | 4
+  // | Record1 (key followed by value)                                | 5-6
+  // | ...                                                            |
+  // | Record16                                                       | 35-36
+  // | Entry pointer to the next Entry                                | 37
+  // <----------------------8 bytes ---------------------------------->
+  //
+  // A record slot goes through Empty -> Occupied -> Retired -> Empty. The
+  // record bytes are written only while the slot is Empty and then published
+  // by storing Occupied with memory_order_release, so a published record is
+  // never modified in place. Replacing or removing a record retires its slot,
+  // and the slot becomes Empty again only through the epoch manager, once no
+  // reader can hold a pointer to the record bytes (see
+  // Inline::WritableHashTable). This gives the lock-free readers the same
+  // guarantee as the out-of-line records without a per-slot seqlock.
+  struct Entry {
+    enum class State : std::uint8_t { Empty = 0U, Occupied, Retired };
+
+    static constexpr std::uint8_t c_numDataPerEntry = TagMatcher::c_numTags;
+
+    // The max number of bytes of a key and a value stored in a slot.
+    static constexpr std::size_t c_maxRecordSize = 16U;
+
+    using Record = std::array<std::uint8_t, c_maxRecordSize>;
+
+    Entry() {
+      for (auto& state : m_states) {
+        state.store(State::Empty, std::memory_order_relaxed);
+      }
+    }
+
+    // Releases all the chained entries.
+    void Release(Allocator allocator) {
+      auto* curEntry = m_next.Load();
+      while (curEntry != nullptr) {
+        auto* entryToDelete = curEntry;
+        curEntry = curEntry->m_next.Load();
+
+        entryToDelete->~Entry();
+        typename Allocator::template rebind<Entry>::other(allocator).deallocate(
+            entryToDelete, 1U);
+      }
+    }
+
+    // Returns a bit mask of the slots whose tag matches the given tag.
+    TagMatcher::Mask MatchTag(std::uint8_t tag) const {
+      return TagMatcher::Match(m_tags, tag);
+    }
+
+    TagMatcher::Tags m_tags{0U};
+
+    std::array<std::atomic<State>, c_numDataPerEntry> m_states;
+
+    std::array<Record, c_numDataPerEntry> m_records;
+
+    Utils::AtomicOffsetPtr<Entry> m_next{};
+  };
+
+  static_assert(sizeof(Entry) == 296, "Entry should be 296 bytes.");
+
+  using Setting = typename SharedHashTable<RecordBuffer, Allocator>::Setting;
+
+  using Mutex = Utils::ReaderWriterLockSlim;
+  using Lock = std::lock_guard<Mutex>;
+  using UniqueLock = std::unique_lock<Mutex>;
+
+  using BucketAllocator = Utils::HugePageAllocator<
+      typename Allocator::template rebind<Entry>::other>;
+
+  using Buckets = Interprocess::Container::Vector<Entry, BucketAllocator>;
+  using Mutexes = Interprocess::Container::
+      Vector<Mutex, typename Allocator::template rebind<Mutex>::other>;
+
+  // Returns true if the records with the given fixed key and value sizes can
+  // be stored inline.
+  static bool CanStoreInline(std::uint32_t fixedKeySize,
+                             std::uint32_t fixedValueSize) {
+    return fixedKeySize != 0U && fixedValueSize != 0U &&
+           fixedKeySize + fixedValueSize <= Entry::c_maxRecordSize;
+  }
+
+  InlineSharedHashTable(const Setting& setting, Allocator allocator)
+      : m_allocator{allocator},
+        m_setting{setting},
+        m_buckets{
+            setting.m_numBuckets,
+            BucketAllocator(m_allocator, setting.m_hugePages)},
+        m_mutexes{
+            (std::max)(setting.m_numBuckets /
+                           (std::max)(setting.m_numBucketsPerMutex, 1U),
+                       1U),
+            typename Allocator::template rebind<Mutex>::other(m_allocator)},
+        m_perfData{} {
+    if (!CanStoreInline(setting.m_fixedKeySize, setting.m_fixedValueSize)) {
+      throw RuntimeException(
+          "Inline records require fixed key and value sizes that fit in a "
+          "slot.");
+    }
+
+    m_perfData.Set(HashTablePerfCounter::BucketsCount, m_buckets.size());
+    m_perfData.Set(HashTablePerfCounter::HugePageBytes,
+                   m_buckets.get_allocator().GetHugePageBytes(
+                       Detail::to_raw_pointer(m_buckets.data())));
+    m_perfData.Set(HashTablePerfCounter::TotalIndexSize,
+                   (m_buckets.size() * sizeof(Entry)) +
+                       (m_mutexes.size() * sizeof(Mutex)) +
+                       sizeof(InlineSharedHashTable));
+  }
+
+  ~InlineSharedHashTable() {
+    for (auto& bucket : m_buckets) {
+      bucket.Release(m_allocator);
+    }
+  }
+
+  template <typename T>
+  auto GetAllocator() const {
+    return typename Allocator::template rebind<T>::other(m_allocator);
+  }
+
+  Mutex& GetMutex(std::uint64_t hash) {
+    return m_mutexes[GetBucketIndex(hash) % m_mutexes.size()];
+  }
+
+  const Buckets& GetBuckets() const { return m_buckets; }
+
+  Entry& GetBucket(std::uint64_t hash) {
+    return m_buckets[GetBucketIndex(hash)];
+  }
+
+  const Entry& GetBucket(std::uint64_t hash) const {
+    return m_buckets[GetBucketIndex(hash)];
+  }
+
+  std::uint32_t GetBucketIndex(std::uint64_t hash) const {
+    return Hasher::GetBucketIndex(m_setting.m_rangeReduction, hash,
+                                  m_buckets.size());
+  }
+
+  Allocator m_allocator;
+
+  const Setting m_setting;
+
+  Buckets m_buckets;
+
+  Mutexes m_mutexes;
+
+  HashTablePerfData m_perfData;
+
+  InlineSharedHashTable(const InlineSharedHashTable&) = delete;
+  InlineSharedHashTable& operator=(const InlineSharedHashTable&) = delete;
+};
+
+}  // namespace HashTable
+}  // namespace L4
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/Record.h"
+#include "HashTable/Common/SharedHashTable.h"
+#include "HashTable/Common/TagMatcher.h"
+#include "Interprocess/Container/Vector.h"
+#include "Log/PerfCounter.h"
+#include "Utils/AtomicOffsetPtr.h"
+#include "Utils/Exception.h"
+#include "Utils/HugePages.h"
+#include "Utils/Lock.h"
+
+namespace L4 {
+namespace HashTable {
+
+// OpenAddressingSharedHashTable struct represents the hash table structure
+// where the records are placed directly in a fixed array of slots instead of
+// chained entries (see HashTableConfig::Engine::OpenAddressing). The slots are
+// organized into groups of 16 with a control byte per slot, and a key is probed
+// group by group (linear probing over groups) starting from the group given by
+// its hash value until the key is found or a group with an empty slot is
+// reached. Since the number of groups is fixed, it is suited for the hash
+// tables whose size is predictable.
+template <typename TAllocator>
+struct OpenAddressingSharedHashTable {
+  using Allocator = TAllocator;
+
+  // OpenAddressingSharedHashTable::Group struct represents 16 slots. Group
+  // layout is as follows:
+  //
+  // | ctrl1 | ctrl2 | ctrl3 | ctrl4 | ctrl5 | ctrl6 | ctrl7 | ctrl8  | 1
+  // | ctrl9 | ctrl10| ctrl11| ctrl12| ctrl13| ctrl14| ctrl15| ctrl16 | 2
+  // | Data1 pointer                                                  | 3
+  // | ...                                                            |
+  // | Data16 pointer                                                 | 18
+  // <----------------------8 bytes ---------------------------------->
+  //
+  // A control byte is c_empty, c_deleted or the low 7 bits of the tag of the
+  // key in the slot, so all the control bytes in a group are compared against
+  // a key at once with TagMatcher. Similar to the tags in SharedHashTable, a
+  // control byte is read by the lock-free readers without synchronization, and
+  // the data pointer is always checked after a control byte matches.
+  struct Group {
+    static constexpr std::uint8_t c_numSlots = TagMatcher::c_numTags;
+
+    // A slot that has never been used. A key is never placed beyond a group
+    // with an empty slot, so the probing stops there.
+    static constexpr std::uint8_t c_empty = 0x80U;
+
+    // A slot whose record is removed. The probing continues past it.
+    static constexpr std::uint8_t c_deleted = 0xFEU;
+
+    Group() { m_controls.fill(c_empty); }
+
+    // Returns the control byte of a full slot for the given tag.
+    static std::uint8_t ToControl(std::uint16_t tag) {
+      return static_cast<std::uint8_t>(tag & 0x7FU);
+    }
+
+    // Returns a bit mask of the slots whose control byte is equal to the given
+    // control byte.
+    TagMatcher::Mask Match(std::uint8_t control) const {
+      return TagMatcher::Match(m_controls, control);
+    }
+
+    TagMatcher::Mask MatchEmpty() const { return Match(c_empty); }
+
+    // Returns a bit mask of the slots that a new record can be placed in.
+    TagMatcher::Mask MatchAvailable() const {
+      return Match(c_empty) | Match(c_deleted);
+    }
+
+    TagMatcher::Tags m_controls;
+
+    std::array<Utils::AtomicOffsetPtr<RecordBuffer>, c_numSlots> m_dataList{};
+  };
+
+  static_assert(sizeof(Group) == 144, "Group should be 144 bytes.");
+
+  // The number of buckets in the setting is the number of groups.
+  using Setting = typename SharedHashTable<RecordBuffer, Allocator>::Setting;
+
+  using Mutex = Utils::ReaderWriterLockSlim;
+  using Lock = std::lock_guard<Mutex>;
+  using UniqueLock = std::unique_lock<Mutex>;
+
+  using GroupAllocator = Utils::HugePageAllocator<
+      typename Allocator::template rebind<Group>::other>;
+
+  using Groups = Interprocess::Container::Vector<Group, GroupAllocator>;
+
+  // The probe sequences get long quickly as the table fills up, so at most 7/8
+  // of the slots can be used (either full or deleted).
+  static constexpr std::uint32_t c_maxLoadFactorNumerator = 7U;
+  static constexpr std::uint32_t c_maxLoadFactorDenominator = 8U;
+
+  OpenAddressingSharedHashTable(const Setting& setting, Allocator allocator)
+      : m_allocator{allocator},
+        m_setting{setting},
+        m_groups{(std::max)(setting.m_numBuckets, 1U),
+                 GroupAllocator(m_allocator, setting.m_hugePages)},
+        m_maxNumUsedSlots{static_cast<std::uint64_t>(m_groups.size()) *
+                          Group::c_numSlots * c_maxLoadFactorNumerator /
+                          c_maxLoadFactorDenominator},
+        m_numUsedSlots{0U},
+        m_perfData{} {
+    m_perfData.Set(HashTablePerfCounter::BucketsCount, m_groups.size());
+    m_perfData.Set(HashTablePerfCounter::HugePageBytes,
+                   m_groups.get_allocator().GetHugePageBytes(
+                       Detail::to_raw_pointer(m_groups.data())));
+    m_perfData.Set(HashTablePerfCounter::TotalIndexSize,
+                   (m_groups.size() * sizeof(Group)) +
+                       sizeof(OpenAddressingSharedHashTable));
+  }
+
+  ~OpenAddressingSharedHashTable() {
+    for (auto& group : m_groups) {
+      for (auto& data : group.m_dataList) {
+        auto* dataToDelete = data.Load();
+        if (dataToDelete != nullptr) {
+          dataToDelete->~RecordBuffer();
+          GetAllocator<RecordBuffer>().deallocate(dataToDelete, 1U);
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  auto GetAllocator() const {
+    return typename Allocator::template rebind<T>::other(m_allocator);
+  }
+
+  // Returns the groups. It is named after SharedHashTable::GetBuckets() so
+  // that the serializer can be shared.
+  const Groups& GetBuckets() const { return m_groups; }
+
+  Groups& GetBuckets() { return m_groups; }
+
+  // Returns the index of the group where the probing starts for the given hash
+  // value.
+  std::uint32_t GetGroupIndex(std::uint64_t hash) const {
+    return Hasher::GetBucketIndex(m_setting.m_rangeReduction, hash,
+                                  m_groups.size());
+  }
+
+  Allocator m_allocator;
+
+  const Setting m_setting;
+
+  Groups m_groups;
+
+  // The writers are serialized by a single mutex since a probe sequence can
+  // span the groups that would be guarded by different stripes.
+  Mutex m_mutex;
+
+  const std::uint64_t m_maxNumUsedSlots;
+
+  // The number of the slots that are not empty (either full or deleted). This
+  // is only accessed under m_mutex.
+  std::uint64_t m_numUsedSlots;
+
+  HashTablePerfData m_perfData;
+
+  OpenAddressingSharedHashTable(const OpenAddressingSharedHashTable&) = delete;
+  OpenAddressingSharedHashTable& operator=(
+      const OpenAddressingSharedHashTable&) = delete;
+};
+
+template <typename TAllocator>
+constexpr std::uint8_t
+    OpenAddressingSharedHashTable<TAllocator>::Group::c_empty;
+
+template <typename TAllocator>
+constexpr std::uint8_t
+    OpenAddressingSharedHashTable<TAllocator>::Group::c_deleted;
+
+}  // namespace HashTable
+}  // namespace L4
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include "HashTable/IHashTable.h"
 #include "Utils/Exception.h"
 
@@ -116,6 +117,29 @@ class RecordSerializer {
     return reinterpret_cast<RecordBuffer*>(buffer);
   }
 
+  // Serializes the given key and the size of the value (excluding the
+  // metadata) to the given buffer, leaving the value to be written by the
+  // caller to the value of the deserialized record.
+  RecordBuffer* SerializeKey(const Key& key,
+                             ValueSize valueSize,
+                             std::uint8_t* const buffer,
+                             std::size_t bufferSize) const {
+    Validate(key, Value{nullptr, valueSize});
+
+    assert(CalculateBufferSize(key, Value{nullptr, valueSize}) <= bufferSize);
+    (void)bufferSize;
+
+    const auto start =
+        SerializeSizes(buffer, key.m_size, valueSize + m_metadataSize);
+
+#if defined(_MSC_VER)
+    memcpy_s(buffer + start, key.m_size, key.m_data, key.m_size);
+#else
+    memcpy(buffer + start, key.m_data, key.m_size);
+#endif
+    return reinterpret_cast<RecordBuffer*>(buffer);
+  }
+
   // Deserializes the given buffer and returns a Record object.
   Record Deserialize(const RecordBuffer& buffer) const {
     Record record;
@@ -144,6 +168,12 @@ class RecordSerializer {
     return record;
   }
 
+  // Returns true if the key of the record in the given buffer is equal to the
+  // given key.
+  bool IsKeyEqual(const Key& key, const RecordBuffer& buffer) const {
+    return Deserialize(buffer).m_key == key;
+  }
+
  private:
   // Validates key and value sizes when fixed sizes are set.
   // Throws an exception if invalid sizes are used.
@@ -189,5 +219,134 @@ class RecordSerializer {
   const ValueSize m_metadataSize;
 };
 
+// FixedRecordSerializer provides the same functionality as RecordSerializer
+// for the records whose key and value sizes are fixed at compile time. The
+// serialized format is identical to RecordSerializer's with the same fixed
+// sizes, but the key/value offsets and sizes are constants, so the key
+// comparison is a fixed-width compare.
+template <std::uint16_t c_keySize, std::uint32_t c_valueSize>
+class FixedRecordSerializer {
+ public:
+  using Key = Record::Key;
+  using Value = Record::Value;
+  using KeySize = Key::size_type;
+  using ValueSize = Value::size_type;
+
+  static_assert(c_keySize != 0U && c_valueSize != 0U,
+                "Fixed key and value sizes should be non-zero.");
+
+  FixedRecordSerializer(KeySize fixedKeySize,
+                        ValueSize fixedValueSize,
+                        ValueSize metadataSize = 0U)
+      : m_metadataSize{metadataSize} {
+    if (fixedKeySize != c_keySize || fixedValueSize != c_valueSize) {
+      throw RuntimeException(
+          "Fixed key and value sizes do not match the record format.");
+    }
+  }
+
+  std::size_t CalculateBufferSize(const Key&, const Value&) const {
+    return c_keySize + c_valueSize + m_metadataSize;
+  }
+
+  std::size_t CalculateRecordOverhead() const { return 0U; }
+
+  RecordBuffer* Serialize(const Key& key,
+                          const Value& value,
+                          std::uint8_t* const buffer,
+                          std::size_t bufferSize) const {
+    Validate(key, value);
+
+    assert(CalculateBufferSize(key, value) <= bufferSize);
+    (void)bufferSize;
+
+    memcpy(buffer, key.m_data, c_keySize);
+    memcpy(buffer + c_keySize, value.m_data, c_valueSize);
+
+    return reinterpret_cast<RecordBuffer*>(buffer);
+  }
+
+  RecordBuffer* Serialize(const Key& key,
+                          const Value& value,
+                          const Value& metaValue,
+                          std::uint8_t* const buffer,
+                          std::size_t bufferSize) const {
+    Validate(key, value);
+
+    if (m_metadataSize != metaValue.m_size) {
+      throw RuntimeException("Invalid meta value size is given.");
+    }
+
+    assert(CalculateBufferSize(key, value) <= bufferSize);
+    (void)bufferSize;
+
+    memcpy(buffer, key.m_data, c_keySize);
+    memcpy(buffer + c_keySize, metaValue.m_data, metaValue.m_size);
+    memcpy(buffer + c_keySize + metaValue.m_size, value.m_data, c_valueSize);
+
+    return reinterpret_cast<RecordBuffer*>(buffer);
+  }
+
+  RecordBuffer* SerializeKey(const Key& key,
+                             ValueSize valueSize,
+                             std::uint8_t* const buffer,
+                             std::size_t bufferSize) const {
+    Validate(key, Value{nullptr, valueSize});
+
+    assert(CalculateBufferSize(key, Value{nullptr, valueSize}) <= bufferSize);
+    (void)bufferSize;
+
+    memcpy(buffer, key.m_data, c_keySize);
+
+    return reinterpret_cast<RecordBuffer*>(buffer);
+  }
+
+  Record Deserialize(const RecordBuffer& buffer) const {
+    return Record{Key{buffer.m_buffer, c_keySize},
+                  Value{buffer.m_buffer + c_keySize,
+                        c_valueSize + m_metadataSize}};
+  }
+
+  bool IsKeyEqual(const Key& key, const RecordBuffer& buffer) const {
+    return key.m_size == c_keySize &&
+           memcmp(key.m_data, buffer.m_buffer, c_keySize) == 0;
+  }
+
+ private:
+  void Validate(const Key& key, const Value& value) const {
+    if (key.m_size != c_keySize || value.m_size != c_valueSize) {
+      throw RuntimeException("Invalid key or value sizes are given.");
+    }
+  }
+
+  const ValueSize m_metadataSize;
+};
+
+// A record format is given to the hash tables (e.g.,
+// ReadWrite::ReadOnlyHashTable) as a template parameter and selects the record
+// serializer at compile time.
+
+// VarRecord is the record format whose key and value sizes are given by the
+// hash table setting at runtime. Both fixed and variable sizes are supported.
+struct VarRecord {
+  using Serializer = RecordSerializer;
+
+  static bool IsMatch(std::uint32_t /* fixedKeySize */,
+                      std::uint32_t /* fixedValueSize */) {
+    return true;
+  }
+};
+
+// FixedRecord is the record format for the given fixed key and value sizes.
+template <std::uint16_t c_keySize, std::uint32_t c_valueSize>
+struct FixedRecord {
+  using Serializer = FixedRecordSerializer<c_keySize, c_valueSize>;
+
+  static bool IsMatch(std::uint32_t fixedKeySize,
+                      std::uint32_t fixedValueSize) {
+    return fixedKeySize == c_keySize && fixedValueSize == c_valueSize;
+  }
+};
+
 }  // namespace HashTable
 }  // namespace L4
@@ -21,6 +21,12 @@ class SettingAdapter {
         (std::max)(from.m_numBucketsPerMutex.get_value_or(1U), 1U);
     to.m_fixedKeySize = from.m_fixedKeySize.get_value_or(0U);
     to.m_fixedValueSize = from.m_fixedValueSize.get_value_or(0U);
+    to.m_hashFunction =
+        from.m_hashFunction.get_value_or(HashFunction::MurmurHash3);
+    to.m_rangeReduction =
+        from.m_rangeReduction.get_value_or(RangeReduction::Modulo);
+    to.m_hugePages = from.m_hugePages.get_value_or(false);
+    to.m_inPlaceUpdates = from.m_inPlaceUpdates.get_value_or(false);
 
     return to;
   }
@@ -1,20 +1,28 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/TagMatcher.h"
 #include "HashTable/IHashTable.h"
 #include "Interprocess/Container/Vector.h"
 #include "Log/PerfCounter.h"
 #include "Utils/AtomicOffsetPtr.h"
 #include "Utils/Exception.h"
+#include "Utils/HugePages.h"
 #include "Utils/Lock.h"
+#include "detail/ToRawPointer.h"
 
 namespace L4 {
 namespace HashTable {
 
-// SharedHashTable struct represents the hash table structure.
-template <typename TData, typename TAllocator>
+// SharedHashTable struct represents the hash table structure. TMutex is the
+// type of the mutexes guarding the buckets (see HashTableConfig::BucketLock).
+template <typename TData,
+          typename TAllocator,
+          typename TMutex = Utils::ReaderWriterLockSlim>
 struct SharedHashTable {
   using Data = TData;
   using Allocator = TAllocator;
@@ -22,32 +30,40 @@ struct SharedHashTable {
   // HashTable::Entry struct represents an entry in the chained bucket list.
   // Entry layout is as follows:
   //
-  // | tag1  | tag2  | tag3  | tag4  | tag5  | tag6  | tag7  | tag 8  | 1
-  // | tag9  | tag10 | tag11 | tag12 | tag13 | tag14 | tag15 | tag 16 | 2
-  // | Data1 pointer                                                  | 3
-  // | Data2 pointer                                                  | 4
-  // | Data3 pointer                                                  | 5
-  // | Data4 pointer                                                  | 6
-  // | Data5 pointer                                                  | 7
-  // | Data6 pointer                                                  | 8
-  // | Data7 pointer                                                  | 9
-  // | Data8 pointer                                                  | 10
-  // | Data9 pointer                                                  | 11
-  // | Data10 pointer                                                 | 12
-  // | Data11 pointer                                                 | 13
-  // | Data12 pointer                                                 | 14
-  // | Data13 pointer                                                 | 15
-  // | Data14 pointer                                                 | 16
-  // | Data15 pointer                                                 | 17
-  // | Data16 pointer                                                 | 18
-  // | Entry pointer to the next Entry                                | 19
+  // | tag1          | tag2          | tag3          | tag4           | 1
+  // | tag5          | tag6          | tag7          | tag8           | 2
+  // | tag9          | tag10         | tag11         | tag12          | 3
+  // | tag13         | tag14         | tag15         | tag16          | 4
+  // | occupancy     | (padding)                                      | 5
+  // | Data1 pointer                                                  | 6
+  // | Data2 pointer                                                  | 7
+  // | Data3 pointer                                                  | 8
+  // | Data4 pointer                                                  | 9
+  // | Data5 pointer                                                  | 10
+  // | Data6 pointer                                                  | 11
+  // | Data7 pointer                                                  | 12
+  // | Data8 pointer                                                  | 13
+  // | Data9 pointer                                                  | 14
+  // | Data10 pointer                                                 | 15
+  // | Data11 pointer                                                 | 16
+  // | Data12 pointer                                                 | 17
+  // | Data13 pointer                                                 | 18
+  // | Data14 pointer                                                 | 19
+  // | Data15 pointer                                                 | 20
+  // | Data16 pointer                                                 | 21
+  // | Entry pointer to the next Entry                                | 22
   // <----------------------8 bytes ---------------------------------->
-  // , where tag1 is a tag for Data1, tag2 for Data2, and so on. A tag value can
-  // be looked up first before going to the corresponding Data for a quick
-  // check. Also note that a byte read is atomic in modern processors so that
-  // tag is just std::uint8_t instead of being atomic. Even in the case where
-  // the tag value read is a garbage , this is acceptable because of the
-  // followings:
+  // , where tag1 is a 16-bit tag (fingerprint) for Data1, tag2 for Data2, and
+  // so on, and the i-th bit of the occupancy bitmap is set if Data(i) is set.
+  // A tag value can be looked up first before going to the corresponding Data
+  // for a quick check. With 16-bit tags, a lookup in a full entry compares the
+  // key of a wrong record with the probability of about 16/65536 instead of
+  // 16/256 with 8-bit tags (see HashTablePerfCounter::TagFalsePositiveCount).
+  // Since the occupancy bitmap tells the empty slots, a tag value of 0 is a
+  // valid tag and an empty slot never matches a tag. Also note that a
+  // two-byte aligned read is atomic in modern processors so that tag is just
+  // std::uint16_t instead of being atomic. Even in the case where the tag value
+  // read is a garbage , this is acceptable because of the followings:
   //    1) if the garbage value was a hit where it should have been a miss: the
   //    actual key comparison will fail, 2) if the garbage value was a miss
   //    where it should have been a hit: the key value must
@@ -70,10 +86,61 @@ struct SharedHashTable {
 
     // Releases deallocates all the memories of the chained entries including
     // the data list in the current Entry.
-    void Release(Allocator allocator) {
-      auto dataDeleter = [allocator](auto& data) {
+    void Release(Allocator allocator) { Release(allocator, true); }
+
+    // Deallocates only the chained entries, leaving the data untouched. This is
+    // used when the data is owned by another Entry (e.g., after the data is
+    // migrated to a new bucket array).
+    void ReleaseChainedEntries(Allocator allocator) {
+      Release(allocator, false);
+    }
+
+    // Returns a bit mask of the occupied slots whose tag matches the given
+    // tag. The acquire load synchronizes with the release store in
+    // SetOccupied() so that the tag and the data of a matched slot are visible.
+    TagMatcher::Mask MatchTag(std::uint16_t tag) const {
+      return TagMatcher::Match(m_tags, tag) &
+             m_occupancy.load(std::memory_order_acquire);
+    }
+
+    // Returns a bit mask of the empty slots. Note that this is called by a
+    // writer under a lock.
+    TagMatcher::Mask MatchEmpty() const {
+      return ~static_cast<TagMatcher::Mask>(
+                 m_occupancy.load(std::memory_order_relaxed)) &
+             c_allSlotsMask;
+    }
+
+    // Sets or clears the occupancy bit of the given slot. It is assumed that
+    // this function is called under a lock.
+    void SetOccupied(std::uint8_t index, bool isOccupied) {
+      const auto bit = static_cast<std::uint16_t>(1U << index);
+      const auto occupancy = m_occupancy.load(std::memory_order_relaxed);
+
+      m_occupancy.store(
+          static_cast<std::uint16_t>(isOccupied ? (occupancy | bit)
+                                                : (occupancy & ~bit)),
+          std::memory_order_release);
+    }
+
+    static constexpr std::uint8_t c_numDataPerEntry = TagMatcher::c_numTags;
+
+    static constexpr TagMatcher::Mask c_allSlotsMask =
+        (1U << c_numDataPerEntry) - 1U;
+
+    TagMatcher::WideTags m_tags{0U};
+
+    std::atomic<std::uint16_t> m_occupancy{0U};
+
+    std::array<Utils::AtomicOffsetPtr<Data>, c_numDataPerEntry> m_dataList{};
+
+    Utils::AtomicOffsetPtr<Entry> m_next{};
+
+   private:
+    void Release(Allocator allocator, bool releaseData) {
+      auto dataDeleter = [allocator, releaseData](auto& data) {
         auto dataToDelete = data.Load();
-        if (dataToDelete != nullptr) {
+        if (releaseData && dataToDelete != nullptr) {
           dataToDelete->~Data();
           typename Allocator::template rebind<Data>::other(allocator)
               .deallocate(dataToDelete, 1U);
@@ -105,17 +172,9 @@ struct SharedHashTable {
         dataDeleter(data);
       }
     }
-
-    static constexpr std::uint8_t c_numDataPerEntry = 16U;
-
-    std::array<std::uint8_t, c_numDataPerEntry> m_tags{0U};
-
-    std::array<Utils::AtomicOffsetPtr<Data>, c_numDataPerEntry> m_dataList{};
-
-    Utils::AtomicOffsetPtr<Entry> m_next{};
   };
 
-  static_assert(sizeof(Entry) == 152, "Entry should be 152 bytes.");
+  static_assert(sizeof(Entry) == 176, "Entry should be 176 bytes.");
 
   struct Setting {
     using KeySize = IReadOnlyHashTable::Key::size_type;
@@ -126,66 +185,229 @@ struct SharedHashTable {
     explicit Setting(std::uint32_t numBuckets,
                      std::uint32_t numBucketsPerMutex = 1U,
                      KeySize fixedKeySize = 0U,
-                     ValueSize fixedValueSize = 0U)
+                     ValueSize fixedValueSize = 0U,
+                     HashFunction hashFunction = HashFunction::MurmurHash3,
+                     RangeReduction rangeReduction = RangeReduction::Modulo,
+                     bool hugePages = false,
+                     bool inPlaceUpdates = false)
         : m_numBuckets{numBuckets},
           m_numBucketsPerMutex{numBucketsPerMutex},
           m_fixedKeySize{fixedKeySize},
-          m_fixedValueSize{fixedValueSize} {}
+          m_fixedValueSize{fixedValueSize},
+          m_hashFunction{hashFunction},
+          m_rangeReduction{rangeReduction},
+          m_hugePages{hugePages},
+          m_inPlaceUpdates{inPlaceUpdates} {}
 
     std::uint32_t m_numBuckets = 1U;
     std::uint32_t m_numBucketsPerMutex = 1U;
     KeySize m_fixedKeySize = 0U;
     ValueSize m_fixedValueSize = 0U;
+    HashFunction m_hashFunction = HashFunction::MurmurHash3;
+    RangeReduction m_rangeReduction = RangeReduction::Modulo;
+
+    // Whether the bucket array is backed by huge pages. This occupies what
+    // used to be the padding, thus the size of Setting, which is serialized
+    // as is, does not change.
+    bool m_hugePages = false;
+
+    // Whether the values of the existing records are overwritten in place
+    // (see ReadWrite::WritableHashTable::Add()), which requires the fixed
+    // value size. This also occupies what used to be the padding.
+    bool m_inPlaceUpdates = false;
   };
 
+  static_assert(sizeof(Setting) == 20, "Setting should be 20 bytes.");
+
+  using Mutex = TMutex;
+  using Lock = std::lock_guard<Mutex>;
+  using UniqueLock = std::unique_lock<Mutex>;
+
+  using BucketAllocator = Utils::HugePageAllocator<
+      typename Allocator::template rebind<Entry>::other>;
+
+  using Buckets = Interprocess::Container::Vector<Entry, BucketAllocator>;
+  using Mutexes = Interprocess::Container::
+      Vector<Mutex, typename Allocator::template rebind<Mutex>::other>;
+
   SharedHashTable(const Setting& setting, Allocator allocator)
       : m_allocator{allocator},
         m_setting{setting},
-        m_buckets{
-            setting.m_numBuckets,
-            typename Allocator::template rebind<Entry>::other(m_allocator)},
+        m_buckets{},
+        m_newBuckets{},
+        m_numMigratedBuckets{0U},
+        m_maxMigratedBucketChainLength{1U},
         m_mutexes{
             (std::max)(setting.m_numBuckets /
                            (std::max)(setting.m_numBucketsPerMutex, 1U),
                        1U),
             typename Allocator::template rebind<Mutex>::other(m_allocator)},
         m_perfData{} {
-    m_perfData.Set(HashTablePerfCounter::BucketsCount, m_buckets.size());
+    m_buckets.Store(CreateBuckets(setting.m_numBuckets));
+
+    m_perfData.Set(HashTablePerfCounter::BucketsCount, setting.m_numBuckets);
+    m_perfData.Set(HashTablePerfCounter::HugePageBytes,
+                   GetHugePageBytes(GetBuckets()));
     m_perfData.Set(HashTablePerfCounter::TotalIndexSize,
-                   (m_buckets.size() * sizeof(Entry)) +
+                   (setting.m_numBuckets * sizeof(Entry)) +
                        (m_mutexes.size() * sizeof(Mutex)) +
                        sizeof(SharedHashTable));
   }
 
   ~SharedHashTable() {
-    for (auto& bucket : m_buckets) {
-      bucket.Release(m_allocator);
-    }
-  }
+    auto& buckets = GetBuckets();
+    auto* newBuckets = m_newBuckets.Load();
+
+    if (newBuckets != nullptr && newBuckets != &buckets) {
+      // The buckets that are already migrated share the data with the new
+      // buckets, thus only their chained entries are released.
+      const auto numMigratedBuckets = m_numMigratedBuckets.load();
+      for (std::size_t i = 0U; i < buckets.size(); ++i) {
+        if (i < numMigratedBuckets) {
+          buckets[i].ReleaseChainedEntries(m_allocator);
+        } else {
+          buckets[i].Release(m_allocator);
+        }
+      }
 
-  using Mutex = Utils::ReaderWriterLockSlim;
-  using Lock = std::lock_guard<Mutex>;
-  using UniqueLock = std::unique_lock<Mutex>;
+      for (auto& bucket : *newBuckets) {
+        bucket.Release(m_allocator);
+      }
 
-  using Buckets = Interprocess::Container::
-      Vector<Entry, typename Allocator::template rebind<Entry>::other>;
-  using Mutexes = Interprocess::Container::
-      Vector<Mutex, typename Allocator::template rebind<Mutex>::other>;
+      DestroyBuckets(newBuckets);
+    } else {
+      for (auto& bucket : buckets) {
+        bucket.Release(m_allocator);
+      }
+    }
+
+    DestroyBuckets(&buckets);
+  }
 
   template <typename T>
   auto GetAllocator() const {
     return typename Allocator::template rebind<T>::other(m_allocator);
   }
 
-  Mutex& GetMutex(std::size_t index) {
-    return m_mutexes[index % m_mutexes.size()];
+  // Returns the mutex guarding the key with the given hash value. Note that the
+  // mutex is chosen based on the index of the bucket in the initial bucket
+  // array. Since the bucket array only grows by doubling, all the keys in a
+  // bucket map to the same bucket in the initial bucket array (for either
+  // range reduction), thus a key is guarded by the same mutex regardless of
+  // which bucket array it lives in.
+  Mutex& GetMutex(std::uint64_t hash) { return m_mutexes[GetMutexIndex(hash)]; }
+
+  // Returns the index of the mutex returned by GetMutex(), which is used to
+  // group the keys guarded by the same mutex (e.g., for the batch operations).
+  std::size_t GetMutexIndex(std::uint64_t hash) const {
+    return GetBucketIndex(hash, m_setting.m_numBuckets) % m_mutexes.size();
+  }
+
+  // Returns the mutex guarding the bucket with the given index in a bucket
+  // array with the given number of buckets (see GetMutex() above).
+  Mutex& GetBucketMutex(std::uint64_t index, std::uint64_t numBuckets) {
+    const auto initialIndex =
+        (m_setting.m_rangeReduction == RangeReduction::MultiplyShift)
+            ? index / (numBuckets / m_setting.m_numBuckets)
+            : index % m_setting.m_numBuckets;
+    return m_mutexes[initialIndex % m_mutexes.size()];
+  }
+
+  // Returns the bucket array that is currently used.
+  Buckets& GetBuckets() const {
+    return *m_buckets.Load(std::memory_order_acquire);
+  }
+
+  // Returns the bucket for the given hash value in the bucket array that is
+  // currently used. Note that while the bucket array is being resized, the
+  // writers keep the current bucket array complete (see GetBucketsForWrite()),
+  // so the lock-free readers always look up the current bucket array.
+  Entry& GetBucket(std::uint64_t hash) const {
+    auto& buckets = GetBuckets();
+    return buckets[GetBucketIndex(hash, buckets.size())];
+  }
+
+  // Returns the buckets that a writer needs to update for the given hash
+  // value. The first is the bucket that owns the key. The second is non-null
+  // only if the bucket array is being resized and the bucket in the current
+  // array has already been migrated; in this case, the first is the bucket in
+  // the new array and the second is the bucket in the current array, which
+  // needs to mirror the update so that the current array stays complete until
+  // the resize is completed. This should be called under GetMutex(hash).
+  std::pair<Entry*, Entry*> GetBucketsForWrite(std::uint64_t hash) const {
+    // m_newBuckets needs to be loaded before m_buckets since completing the
+    // resize sets m_buckets to the new array before resetting m_newBuckets.
+    auto* newBuckets = m_newBuckets.Load(std::memory_order_acquire);
+    auto& buckets = GetBuckets();
+
+    const auto index = GetBucketIndex(hash, buckets.size());
+
+    if (newBuckets != nullptr && newBuckets != &buckets &&
+        index < m_numMigratedBuckets.load(std::memory_order_acquire)) {
+      return {&(*newBuckets)[GetBucketIndex(hash, newBuckets->size())],
+              &buckets[index]};
+    }
+
+    return {&buckets[index], nullptr};
+  }
+
+  // Returns the index of the bucket for the given hash value.
+  std::uint32_t GetBucketIndex(std::uint64_t hash,
+                               std::uint64_t numBuckets) const {
+    return Hasher::GetBucketIndex(m_setting.m_rangeReduction, hash,
+                                  numBuckets);
+  }
+
+  // Returns true if the bucket array is being resized.
+  bool IsResizing() const {
+    return m_newBuckets.Load(std::memory_order_acquire) != nullptr;
+  }
+
+  // Allocates a new bucket array with the given number of buckets.
+  Buckets* CreateBuckets(std::size_t numBuckets) {
+    auto* buckets =
+        Detail::to_raw_pointer(GetAllocator<Buckets>().allocate(1U));
+    return new (buckets) Buckets(
+        numBuckets,
+        BucketAllocator(GetAllocator<Entry>(), m_setting.m_hugePages));
+  }
+
+  // Returns the number of bytes of the given bucket array that are backed by
+  // huge pages.
+  std::size_t GetHugePageBytes(const Buckets& buckets) const {
+    return buckets.get_allocator().GetHugePageBytes(
+        Detail::to_raw_pointer(buckets.data()));
+  }
+
+  // Deallocates the given bucket array. Note that the entries in the bucket
+  // array should be released beforehand.
+  void DestroyBuckets(Buckets* buckets) {
+    buckets->~Buckets();
+    GetAllocator<Buckets>().deallocate(buckets, 1U);
   }
 
   Allocator m_allocator;
 
   const Setting m_setting;
 
-  Buckets m_buckets;
+  // The bucket array currently used.
+  Utils::AtomicOffsetPtr<Buckets> m_buckets;
+
+  // The bucket array that the buckets are being migrated to. It is set only
+  // while the bucket array is being resized.
+  Utils::AtomicOffsetPtr<Buckets> m_newBuckets;
+
+  // The buckets in m_buckets whose indices are less than this value are
+  // migrated to m_newBuckets.
+  std::atomic<std::uint64_t> m_numMigratedBuckets;
+
+  // Serializes the resize operations.
+  Mutex m_resizeMutex;
+
+  // The max chain length of the buckets migrated so far, which becomes the
+  // MaxBucketChainLength once the resize is completed. Guarded by
+  // m_resizeMutex.
+  std::uint32_t m_maxMigratedBucketChainLength;
 
   Mutexes m_mutexes;
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define L4_TAG_MATCHER_SSE2
+#endif
+
+namespace L4 {
+namespace HashTable {
+
+// TagMatcher compares all the tags stored in an entry against a given tag at
+// once and returns the result as a bit mask, where the i-th bit is set if the
+// i-th tag matches. Both one-byte tags (InlineSharedHashTable::Entry) and
+// two-byte tags (SharedHashTable::Entry and CuckooSharedHashTable::Bucket) are
+// supported. The implementation is
+// chosen at compile time: SSE2 is the baseline for x86/x64 and the scalar loop
+// is used otherwise. Note that 16 one-byte tags fit in a single 128-bit
+// register, and 16 two-byte tags in two, which are packed into one before
+// taking the mask, so AVX2 does not give anything extra over SSE2 here (the
+// SSE2 path is used when AVX2 is on).
+struct TagMatcher {
+  using Mask = std::uint32_t;
+
+  static constexpr std::uint8_t c_numTags = 16U;
+
+  using Tags = std::array<std::uint8_t, c_numTags>;
+  using WideTags = std::array<std::uint16_t, c_numTags>;
+  using HalfWideTags = std::array<std::uint16_t, c_numTags / 2U>;
+
+  // Returns a bit mask of the slots whose tag is equal to the given tag.
+  static Mask Match(const Tags& tags, std::uint8_t tag) {
+#if defined(__AVX2__) || defined(L4_TAG_MATCHER_SSE2)
+    const auto tagsVector =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags.data()));
+    const auto tagVector = _mm_set1_epi8(static_cast<char>(tag));
+
+    return static_cast<Mask>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(tagsVector, tagVector)));
+#else
+    Mask mask = 0U;
+    for (std::uint8_t i = 0; i < c_numTags; ++i) {
+      mask |= static_cast<Mask>(tags[i] == tag) << i;
+    }
+
+    return mask;
+#endif
+  }
+
+  // Returns a bit mask of the slots whose two-byte tag is equal to the given
+  // tag.
+  static Mask Match(const WideTags& tags, std::uint16_t tag) {
+#if defined(__AVX2__) || defined(L4_TAG_MATCHER_SSE2)
+    const auto tagVector = _mm_set1_epi16(static_cast<short>(tag));
+    const auto low = _mm_cmpeq_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags.data())),
+        tagVector);
+    const auto high = _mm_cmpeq_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags.data() + 8U)),
+        tagVector);
+
+    // Each comparison result is either 0 or -1, so the signed saturation
+    // packs it into a byte without changing it.
+    return static_cast<Mask>(_mm_movemask_epi8(_mm_packs_epi16(low, high)));
+#else
+    Mask mask = 0U;
+    for (std::uint8_t i = 0; i < c_numTags; ++i) {
+      mask |= static_cast<Mask>(tags[i] == tag) << i;
+    }
+
+    return mask;
+#endif
+  }
+
+  // Returns a bit mask of the slots whose two-byte tag is equal to the given
+  // tag. The eight tags fit in a single 128-bit register.
+  static Mask Match(const HalfWideTags& tags, std::uint16_t tag) {
+#if defined(__AVX2__) || defined(L4_TAG_MATCHER_SSE2)
+    const auto result = _mm_cmpeq_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags.data())),
+        _mm_set1_epi16(static_cast<short>(tag)));
+
+    return static_cast<Mask>(
+        _mm_movemask_epi8(_mm_packs_epi16(result, _mm_setzero_si128())));
+#else
+    Mask mask = 0U;
+    for (std::uint8_t i = 0; i < tags.size(); ++i) {
+      mask |= static_cast<Mask>(tags[i] == tag) << i;
+    }
+
+    return mask;
+#endif
+  }
+
+  // Returns a bit mask of the slots whose tag is 0. Since a removed or an
+  // unused slot always has its tag reset to 0, the returned slots are the only
+  // candidates for an empty slot. Note that a slot with the tag 0 can still
+  // hold a record whose tag happens to be 0, so the caller needs to check the
+  // data pointer.
+  static Mask MatchEmpty(const Tags& tags) { return Match(tags, 0U); }
+};
+
+#undef L4_TAG_MATCHER_SSE2
+
+}  // namespace HashTable
+}  // namespace L4
@@ -5,6 +5,7 @@
 #include <chrono>
 #include <cstdint>
 #include <memory>
+#include "HashTable/Common/Hasher.h"
 #include "HashTable/IHashTable.h"
 #include "Utils/Properties.h"
 
@@ -12,36 +13,214 @@ namespace L4 {
 
 // HashTableConfig struct.
 struct HashTableConfig {
+  // Engine specifies the data structure of the hash table.
+  enum class Engine : std::uint8_t {
+    // Chained buckets of 16-slot entries (see SharedHashTable), which is the
+    // default.
+    Chained = 0U,
+
+    // Open addressing over groups of 16 slots probed with control bytes (see
+    // OpenAddressingSharedHashTable). The number of buckets is the number of
+    // groups, which is fixed; Add() throws once 7/8 of the slots are used.
+    OpenAddressing,
+
+    // Bucketized cuckoo hashing with two candidate buckets of 8 slots per key
+    // (see CuckooSharedHashTable), so that a look up reads at most two
+    // buckets. The number of buckets is fixed; Add() throws once no room can
+    // be made by moving the records to their other buckets.
+    Cuckoo
+  };
+
+  // BucketLock specifies the type of the mutexes guarding the buckets of the
+  // chained engine, which the writers take exclusively (the readers are
+  // lock-free). See Utils/Lock.h for the characteristics of each.
+  enum class BucketLock : std::uint8_t {
+    // Utils::ReaderWriterLockSlim (SRW lock on Windows and pthread_rwlock_t
+    // otherwise), which is the default.
+    ReaderWriter = 0U,
+
+    // Utils::SpinLock.
+    Spin,
+
+    // Utils::TicketLock.
+    Ticket,
+
+    // Utils::AdaptiveLock, which spins and then sleeps.
+    Adaptive
+  };
+
   struct Setting {
     using KeySize = IReadOnlyHashTable::Key::size_type;
     using ValueSize = IReadOnlyHashTable::Value::size_type;
 
+    using HashFunction = HashTable::HashFunction;
+    using RangeReduction = HashTable::RangeReduction;
+
     explicit Setting(std::uint32_t numBuckets,
                      boost::optional<std::uint32_t> numBucketsPerMutex = {},
                      boost::optional<KeySize> fixedKeySize = {},
-                     boost::optional<ValueSize> fixedValueSize = {})
+                     boost::optional<ValueSize> fixedValueSize = {},
+                     boost::optional<HashFunction> hashFunction = {},
+                     boost::optional<RangeReduction> rangeReduction = {},
+                     boost::optional<bool> inlineRecords = {},
+                     boost::optional<Engine> engine = {},
+                     boost::optional<bool> hugePages = {},
+                     boost::optional<BucketLock> bucketLock = {},
+                     boost::optional<bool> inPlaceUpdates = {})
         : m_numBuckets{numBuckets},
           m_numBucketsPerMutex{numBucketsPerMutex},
           m_fixedKeySize{fixedKeySize},
-          m_fixedValueSize{fixedValueSize} {}
+          m_fixedValueSize{fixedValueSize},
+          m_hashFunction{hashFunction},
+          m_rangeReduction{rangeReduction},
+          m_inlineRecords{inlineRecords},
+          m_engine{engine},
+          m_hugePages{hugePages},
+          m_bucketLock{bucketLock},
+          m_inPlaceUpdates{inPlaceUpdates} {}
 
     std::uint32_t m_numBuckets;
     boost::optional<std::uint32_t> m_numBucketsPerMutex;
     boost::optional<KeySize> m_fixedKeySize;
     boost::optional<ValueSize> m_fixedValueSize;
+    boost::optional<HashFunction> m_hashFunction;
+    boost::optional<RangeReduction> m_rangeReduction;
+
+    // If set to true, the records are stored in the bucket entries instead of
+    // being allocated separately, which saves memory and a cache miss per look
+    // up. This requires both m_fixedKeySize and m_fixedValueSize to be set and
+    // their sum to be at most 16 bytes (see InlineSharedHashTable).
+    boost::optional<bool> m_inlineRecords;
+
+    boost::optional<Engine> m_engine;
+
+    // If set to true, the bucket array is backed by huge pages when available
+    // (see Utils::HugePages), falling back to the regular pages otherwise.
+    // HashTablePerfCounter::HugePageBytes reports the bytes that are actually
+    // backed by huge pages. This is not persisted by the serializer.
+    boost::optional<bool> m_hugePages;
+
+    // Supported only by the chained engine. Since the lock type is a template
+    // parameter of the hash table, it is not persisted by the serializer.
+    boost::optional<BucketLock> m_bucketLock;
+
+    // If set to true, Add() overwrites the value of an existing key in place
+    // when the sizes of the values are the same (e.g., with m_fixedValueSize),
+    // instead of allocating a new record and retiring the old one through the
+    // epoch manager. Each record carries a sequence counter, which
+    // IReadOnlyHashTable::GetCopy() uses to copy out a consistent value; the
+    // value returned by Get() (or MultiGet()) may change while it is being
+    // read. This is supported only by the chained engine without cache or
+    // inline records. It is not persisted by the serializer.
+    boost::optional<bool> m_inPlaceUpdates;
   };
 
   struct Cache {
+    // EvictionPolicy decides which records the eviction hand, which sweeps
+    // the buckets in order, removes when the cache is full. The readers count
+    // the accesses of each record (up to 3) without taking any lock.
+    //    1) Clock evicts a record that has not been accessed since the hand
+    //    last passed it. Since the hand does not move the records, it also
+    //    behaves as SIEVE would over the bucket order.
+    //    2) S3Fifo (Yang et al., SOSP'23) adds a record to the small queue,
+    //    from which it is evicted when the hand first passes it unless it has
+    //    been accessed, in which case it moves to the main queue. In the main
+    //    queue, each pass of the hand takes one access, and the record is
+    //    evicted when none is left. The keys evicted from the small queue are
+    //    remembered in a ghost table, and such a key added again goes
+    //    straight to the main queue. This keeps a scan of one-hit keys from
+    //    evicting the frequently accessed records.
+    //    3) ClockPro (Jiang et al., USENIX ATC'05) adds a record as cold in
+    //    its test period. A cold record accessed in its test period becomes
+    //    hot, and a hot record not accessed since the hand last passed it
+    //    becomes cold, thus only the cold records are evicted. A key evicted
+    //    in its test period is remembered in the ghost table and is added
+    //    again as hot.
+    enum class EvictionPolicy : std::uint8_t { Clock, S3Fifo, ClockPro };
+
+    // BackgroundEviction struct configures the background eviction, which
+    // keeps the free headroom in the cache so that the writers do not have to
+    // evict. LocalMemory::HashTableService checks the cache size every
+    // m_interval on a background thread, and once it goes above
+    // m_highWatermark of m_maxCacheSizeInBytes, evicts the records until it
+    // goes down to m_lowWatermark of it (see
+    // IWritableHashTable::EvictToWatermark()). Add() still evicts inline when
+    // the cache size would go above m_maxCacheSizeInBytes, which is the hard
+    // limit.
+    struct BackgroundEviction {
+      explicit BackgroundEviction(
+          double lowWatermark = 0.8,
+          double highWatermark = 0.9,
+          std::chrono::milliseconds interval = std::chrono::milliseconds{10})
+          : m_lowWatermark{lowWatermark},
+            m_highWatermark{highWatermark},
+            m_interval{interval} {}
+
+      double m_lowWatermark;
+      double m_highWatermark;
+      std::chrono::milliseconds m_interval;
+    };
+
     Cache(std::uint64_t maxCacheSizeInBytes,
           std::chrono::seconds recordTimeToLive,
-          bool forceTimeBasedEviction)
+          bool forceTimeBasedEviction,
+          EvictionPolicy evictionPolicy = EvictionPolicy::Clock,
+          boost::optional<BackgroundEviction> backgroundEviction = {},
+          std::uint16_t numEvictionShards = 1U)
         : m_maxCacheSizeInBytes{maxCacheSizeInBytes},
           m_recordTimeToLive{recordTimeToLive},
-          m_forceTimeBasedEviction{forceTimeBasedEviction} {}
+          m_forceTimeBasedEviction{forceTimeBasedEviction},
+          m_evictionPolicy{evictionPolicy},
+          m_backgroundEviction{backgroundEviction},
+          m_numEvictionShards{numEvictionShards} {}
 
     std::uint64_t m_maxCacheSizeInBytes;
     std::chrono::seconds m_recordTimeToLive;
     bool m_forceTimeBasedEviction;
+    EvictionPolicy m_evictionPolicy;
+    boost::optional<BackgroundEviction> m_backgroundEviction;
+
+    // The number of the shards that the buckets are split into for the
+    // eviction, which should be between 1 and the number of buckets. Each
+    // shard has its own CLOCK hand, lock and an equal share of
+    // m_maxCacheSizeInBytes, and a writer evicts only in the shard of its
+    // key, thus the writers can evict in parallel.
+    std::uint16_t m_numEvictionShards;
+  };
+
+  // Resize struct that configures when and how fast the bucket array grows.
+  // The bucket array is doubled when the ratio of the number of records to the
+  // number of buckets goes above m_maxLoadFactor or when MaxBucketChainLength
+  // goes above m_maxBucketChainLength (0 disables each check). The buckets are
+  // then migrated incrementally by the writers, m_numBucketsToMigratePerAdd
+  // buckets at a time.
+  struct Resize {
+    explicit Resize(double maxLoadFactor,
+                    std::uint32_t maxBucketChainLength = 0U,
+                    std::uint32_t numBucketsToMigratePerAdd = 16U)
+        : m_maxLoadFactor{maxLoadFactor},
+          m_maxBucketChainLength{maxBucketChainLength},
+          m_numBucketsToMigratePerAdd{numBucketsToMigratePerAdd} {}
+
+    double m_maxLoadFactor;
+    std::uint32_t m_maxBucketChainLength;
+    std::uint32_t m_numBucketsToMigratePerAdd;
+  };
+
+  // Compaction struct configures the background compaction that reclaims the
+  // chained entries left empty by the removed records (see
+  // IWritableHashTable::Compact()). LocalMemory::HashTableService compacts
+  // m_numBucketsPerRun buckets of the hash table every m_interval on a
+  // background thread. This is supported only by the chained engine without
+  // inline records and is ignored otherwise.
+  struct Compaction {
+    explicit Compaction(
+        std::chrono::milliseconds interval = std::chrono::milliseconds{1000},
+        std::uint32_t numBucketsPerRun = 1024U)
+        : m_interval{interval}, m_numBucketsPerRun{numBucketsPerRun} {}
+
+    std::chrono::milliseconds m_interval;
+    std::uint32_t m_numBucketsPerRun;
   };
 
   struct Serializer {
@@ -58,11 +237,17 @@ struct HashTableConfig {
   HashTableConfig(std::string name,
                   Setting setting,
                   boost::optional<Cache> cache = {},
-                  boost::optional<Serializer> serializer = {})
+                  boost::optional<Serializer> serializer = {},
+                  boost::optional<Resize> resize = {},
+                  boost::optional<bool> numaReplicas = {},
+                  boost::optional<Compaction> compaction = {})
       : m_name{std::move(name)},
         m_setting{std::move(setting)},
         m_cache{cache},
-        m_serializer{serializer} {
+        m_serializer{serializer},
+        m_resize{resize},
+        m_numaReplicas{numaReplicas},
+        m_compaction{compaction} {
     assert(m_setting.m_numBuckets > 0U ||
            (m_serializer && (serializer->m_stream != nullptr)));
   }
@@ -71,6 +256,15 @@ struct HashTableConfig {
   Setting m_setting;
   boost::optional<Cache> m_cache;
   boost::optional<Serializer> m_serializer;
+  boost::optional<Resize> m_resize;
+
+  // If set to true, one replica of the hash table is created on each NUMA node
+  // so that the readers read from the memory local to their node. The writes
+  // are applied to all the replicas, thus this is for the read-mostly hash
+  // tables (see LocalMemory::ReplicatedHashTable).
+  boost::optional<bool> m_numaReplicas;
+
+  boost::optional<Compaction> m_compaction;
 };
 
 }  // namespace L4
@@ -0,0 +1,652 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "Epoch/IEpochActionManager.h"
+#include "HashTable/Common/CuckooSharedHashTable.h"
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/Record.h"
+#include "HashTable/IHashTable.h"
+#include "HashTable/ReadWrite/Serializer.h"
+#include "Log/PerfCounter.h"
+#include "Utils/Exception.h"
+#include "Utils/Math.h"
+#include "Utils/Prefetch.h"
+#include "Utils/Properties.h"
+#include "detail/ToRawPointer.h"
+
+namespace L4 {
+
+// Cuckoo hash table is a hash table engine where a key is placed in one of its
+// two candidate buckets (see CuckooSharedHashTable). Same as ReadWrite hash
+// table, the look up is lock free and the records are reclaimed through the
+// epoch manager.
+namespace HashTable {
+namespace Cuckoo {
+
+// ReadOnlyHashTable class implements IReadOnlyHashTable interface and provides
+// the functionality to read data given a key.
+template <typename Allocator>
+class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
+ public:
+  using HashTable = CuckooSharedHashTable<Allocator>;
+
+  class Iterator;
+
+  explicit ReadOnlyHashTable(HashTable& hashTable)
+      : m_hashTable{hashTable},
+        m_recordSerializer{hashTable.m_setting.m_fixedKeySize,
+                           hashTable.m_setting.m_fixedValueSize} {}
+
+  virtual bool Get(const Key& key, Value& value) const override {
+    return Find(key, GetBucketInfo(key), value);
+  }
+
+  // MultiGet resolves the keys in groups of c_multiGetGroupSize in stages so
+  // that the cache misses of the keys in the same group are overlapped (see
+  // ReadWrite::ReadOnlyHashTable::MultiGet()).
+  virtual std::size_t MultiGet(const Key* keys,
+                               std::size_t numKeys,
+                               Value* values,
+                               bool* found) const override {
+    std::array<BucketInfo, c_multiGetGroupSize> bucketInfos;
+    std::size_t numFound = 0U;
+
+    const auto& buckets = m_hashTable.GetBuckets();
+
+    for (std::size_t start = 0U; start < numKeys;
+         start += c_multiGetGroupSize) {
+      const auto groupSize = (std::min)(numKeys - start, c_multiGetGroupSize);
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        bucketInfos[i] = GetBucketInfo(keys[start + i]);
+
+        const auto indexes =
+            m_hashTable.GetBucketIndexes(bucketInfos[i].first);
+        Utils::Prefetch(&buckets[indexes.first],
+                        sizeof(typename HashTable::Bucket));
+        Utils::Prefetch(&buckets[indexes.second],
+                        sizeof(typename HashTable::Bucket));
+      }
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        found[start + i] =
+            Find(keys[start + i], bucketInfos[i], values[start + i]);
+        numFound += found[start + i] ? 1U : 0U;
+      }
+    }
+
+    return numFound;
+  }
+
+  virtual IIteratorPtr GetIterator() const override {
+    return std::make_unique<Iterator>(m_hashTable, m_recordSerializer);
+  }
+
+  virtual const HashTablePerfData& GetPerfData() const override {
+    // Synchronizes with any std::memory_order_release if there exists, so that
+    // HashTablePerfData has the latest values at the moment when GetPerfData()
+    // is called.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_hashTable.m_perfData;
+  }
+
+  ReadOnlyHashTable(const ReadOnlyHashTable&) = delete;
+  ReadOnlyHashTable& operator=(const ReadOnlyHashTable&) = delete;
+
+ protected:
+  using BucketInfo = HashValue;
+
+  static constexpr std::size_t c_multiGetGroupSize = 16U;
+
+  // Looks up the given key whose bucket information is already calculated.
+  // A key found in either bucket is always valid. However, a key that is not
+  // found might have been moved from one bucket to the other while they were
+  // read, so the look up is retried if the version of either bucket has
+  // changed (or is odd, which means a move is in progress).
+  bool Find(const Key& key, const BucketInfo& bucketInfo, Value& value) const {
+    const auto& buckets = m_hashTable.GetBuckets();
+    const auto indexes = m_hashTable.GetBucketIndexes(bucketInfo.first);
+    const auto& first = buckets[indexes.first];
+    const auto& second = buckets[indexes.second];
+
+    while (true) {
+      const auto firstVersion = first.m_version.load(std::memory_order_acquire);
+      const auto secondVersion =
+          second.m_version.load(std::memory_order_acquire);
+
+      if (((firstVersion | secondVersion) & 1U) == 0U) {
+        if (FindInBucket(first, key, bucketInfo.second, value) ||
+            FindInBucket(second, key, bucketInfo.second, value)) {
+          return true;
+        }
+
+        // Keeps the version loads below from being reordered before the data
+        // pointer loads above.
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (first.m_version.load(std::memory_order_relaxed) == firstVersion &&
+            second.m_version.load(std::memory_order_relaxed) ==
+                secondVersion) {
+          return false;
+        }
+      }
+    }
+  }
+
+  bool FindInBucket(const typename HashTable::Bucket& bucket,
+                    const Key& key,
+                    std::uint16_t tag,
+                    Value& value) const {
+    for (auto mask = bucket.MatchTag(tag); mask != 0U; mask &= mask - 1U) {
+      const auto i = Utils::Math::CountTrailingZeros(mask);
+
+      // The data pointer is loaded once since it can be updated during the
+      // access (the record is not freed until the epoch moves on).
+      const auto data = bucket.m_dataList[i].Load(std::memory_order_acquire);
+
+      if (data != nullptr) {
+        if (m_recordSerializer.IsKeyEqual(key, *data)) {
+          value = m_recordSerializer.Deserialize(*data).m_value;
+          return true;
+        }
+
+        OnTagFalsePositive();
+      }
+    }
+
+    return false;
+  }
+
+  // Counts a key comparison that failed although the tag matched.
+  void OnTagFalsePositive() const {
+    m_hashTable.m_perfData.Increment(
+        HashTablePerfCounter::TagFalsePositiveCount);
+  }
+
+  BucketInfo GetBucketInfo(const Key& key) const {
+    return Hasher::Hash(m_hashTable.m_setting.m_hashFunction, key.m_data,
+                        key.m_size);
+  }
+
+  HashTable& m_hashTable;
+
+  RecordSerializer m_recordSerializer;
+};
+
+template <typename Allocator>
+constexpr std::size_t ReadOnlyHashTable<Allocator>::c_multiGetGroupSize;
+
+// ReadOnlyHashTable::Iterator class implements IIterator interface and provides
+// read-only iterator for the ReadOnlyHashTable. Note that a record moved to its
+// other bucket during the iteration can be visited twice or not at all.
+template <typename Allocator>
+class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
+ public:
+  Iterator(const HashTable& hashTable,
+           const RecordSerializer& recordDeserializer)
+      : m_hashTable{hashTable},
+        m_recordSerializer{recordDeserializer},
+        m_currentBucketIndex{0U},
+        m_currentSlotIndex{-1},
+        m_currentRecord{nullptr} {}
+
+  void Reset() override {
+    m_currentBucketIndex = 0U;
+    m_currentSlotIndex = -1;
+    m_currentRecord = nullptr;
+  }
+
+  bool MoveNext() override {
+    const auto& buckets = m_hashTable.GetBuckets();
+
+    while (m_currentBucketIndex < buckets.size()) {
+      if (++m_currentSlotIndex >= HashTable::Bucket::c_numSlots) {
+        m_currentSlotIndex = -1;
+        ++m_currentBucketIndex;
+        continue;
+      }
+
+      m_currentRecord = buckets[m_currentBucketIndex]
+                            .m_dataList[m_currentSlotIndex]
+                            .Load(std::memory_order_acquire);
+      if (m_currentRecord != nullptr) {
+        return true;
+      }
+    }
+
+    m_currentRecord = nullptr;
+    return false;
+  }
+
+  Key GetKey() const override {
+    if (m_currentRecord == nullptr) {
+      throw RuntimeException("HashTableIterator is not correctly used.");
+    }
+
+    return m_recordSerializer.Deserialize(*m_currentRecord).m_key;
+  }
+
+  Value GetValue() const override {
+    if (m_currentRecord == nullptr) {
+      throw RuntimeException("HashTableIterator is not correctly used.");
+    }
+
+    return m_recordSerializer.Deserialize(*m_currentRecord).m_value;
+  }
+
+  Iterator(const Iterator&) = delete;
+  Iterator& operator=(const Iterator&) = delete;
+
+ private:
+  const HashTable& m_hashTable;
+  const RecordSerializer& m_recordSerializer;
+
+  std::size_t m_currentBucketIndex;
+  std::int32_t m_currentSlotIndex;
+
+  const RecordBuffer* m_currentRecord;
+};
+
+// The following warning is from the virtual inheritance and safe to disable in
+// this case. https://msdn.microsoft.com/en-us/library/6b3sy7ae.aspx
+#pragma warning(push)
+#pragma warning(disable : 4250)
+
+// WritableHashTable class implements IWritableHashTable interface and also
+// provides the read only access (Get()) to the hash table.
+template <typename Allocator>
+class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
+                          public IWritableHashTable {
+ public:
+  using Base = ReadOnlyHashTable<Allocator>;
+  using HashTable = typename Base::HashTable;
+
+  WritableHashTable(HashTable& hashTable, IEpochActionManager& epochManager)
+      : Base(hashTable), m_epochManager{epochManager} {}
+
+  // Adds the given key and value. Throws RuntimeException if the key is new and
+  // no room can be made in either of its buckets.
+  virtual void Add(const Key& key, const Value& value) override {
+    auto* recordToAdd = CreateRecordBuffer(key, value);
+    const auto newRecord = this->m_recordSerializer.Deserialize(*recordToAdd);
+    const auto bucketInfo = this->GetBucketInfo(key);
+    const auto indexes = this->m_hashTable.GetBucketIndexes(bucketInfo.first);
+
+    auto& buckets = this->m_hashTable.GetBuckets();
+
+    while (true) {
+      BucketLocks locks{this->m_hashTable, indexes.first, indexes.second};
+
+      typename HashTable::Bucket* bucket = nullptr;
+      std::uint8_t index = 0U;
+
+      if (FindSlot(indexes, key, bucketInfo.second, bucket, index)) {
+        auto& recordHolder = bucket->m_dataList[index];
+        auto* oldRecord = recordHolder.Load(std::memory_order_relaxed);
+        recordHolder.Store(recordToAdd, std::memory_order_release);
+        locks.Unlock();
+
+        const auto oldValueSize =
+            this->m_recordSerializer.Deserialize(*oldRecord).m_value.m_size;
+        ReleaseRecord(oldRecord);
+
+        this->m_hashTable.m_perfData.Add(
+            HashTablePerfCounter::TotalValueSize,
+            static_cast<HashTablePerfData::TValue>(newRecord.m_value.m_size) -
+                oldValueSize);
+        return;
+      }
+
+      std::uint32_t numBucketsRead = 1U;
+      for (const auto bucketIndex : {indexes.first, indexes.second}) {
+        const auto emptyMask = buckets[bucketIndex].MatchEmpty();
+        if (emptyMask != 0U) {
+          bucket = &buckets[bucketIndex];
+          index = static_cast<std::uint8_t>(
+              Utils::Math::CountTrailingZeros(emptyMask));
+          break;
+        }
+
+        ++numBucketsRead;
+      }
+
+      if (bucket != nullptr) {
+        // The tag is set before the record is published, and a reader always
+        // checks the data pointer after the tag matches.
+        bucket->m_tags[index] = bucketInfo.second;
+        bucket->m_dataList[index].Store(recordToAdd,
+                                        std::memory_order_release);
+        locks.Unlock();
+
+        auto& perfData = this->m_hashTable.m_perfData;
+        perfData.Increment(HashTablePerfCounter::RecordsCount);
+        perfData.Add(HashTablePerfCounter::TotalKeySize,
+                     newRecord.m_key.m_size);
+        perfData.Add(HashTablePerfCounter::TotalValueSize,
+                     newRecord.m_value.m_size);
+        perfData.Add(HashTablePerfCounter::TotalIndexSize,
+                     this->m_recordSerializer.CalculateRecordOverhead());
+        perfData.Min(HashTablePerfCounter::MinKeySize, newRecord.m_key.m_size);
+        perfData.Max(HashTablePerfCounter::MaxKeySize, newRecord.m_key.m_size);
+        perfData.Min(HashTablePerfCounter::MinValueSize,
+                     newRecord.m_value.m_size);
+        perfData.Max(HashTablePerfCounter::MaxValueSize,
+                     newRecord.m_value.m_size);
+        perfData.Max(HashTablePerfCounter::MaxBucketChainLength,
+                     numBucketsRead);
+        return;
+      }
+
+      locks.Unlock();
+
+      // Both buckets are full. Once some room is made, the key is looked up
+      // again since another writer may have added it in the meantime.
+      if (!MakeRoom(indexes)) {
+        // The record is not visible to anyone, so it is freed right away.
+        recordToAdd->~RecordBuffer();
+        this->m_hashTable.template GetAllocator<RecordBuffer>().deallocate(
+            recordToAdd, 1U);
+
+        throw RuntimeException("The hash table is full.");
+      }
+    }
+  }
+
+  virtual bool Remove(const Key& key) override {
+    const auto bucketInfo = this->GetBucketInfo(key);
+    const auto indexes = this->m_hashTable.GetBucketIndexes(bucketInfo.first);
+
+    BucketLocks locks{this->m_hashTable, indexes.first, indexes.second};
+
+    typename HashTable::Bucket* bucket = nullptr;
+    std::uint8_t index = 0U;
+
+    if (!FindSlot(indexes, key, bucketInfo.second, bucket, index)) {
+      return false;
+    }
+
+    auto* record = bucket->m_dataList[index].Load(std::memory_order_relaxed);
+    bucket->m_dataList[index].Store(nullptr, std::memory_order_release);
+    locks.Unlock();
+
+    const auto removedRecord = this->m_recordSerializer.Deserialize(*record);
+
+    auto& perfData = this->m_hashTable.m_perfData;
+    perfData.Decrement(HashTablePerfCounter::RecordsCount);
+    perfData.Subtract(HashTablePerfCounter::TotalKeySize,
+                      removedRecord.m_key.m_size);
+    perfData.Subtract(HashTablePerfCounter::TotalValueSize,
+                      removedRecord.m_value.m_size);
+    perfData.Subtract(HashTablePerfCounter::TotalIndexSize,
+                      this->m_recordSerializer.CalculateRecordOverhead());
+
+    ReleaseRecord(record);
+    return true;
+  }
+
+  virtual ISerializerPtr GetSerializer() const override {
+    return std::make_unique<WritableHashTable::Serializer>(this->m_hashTable);
+  }
+
+ private:
+  class Serializer;
+
+  // The max number of the buckets visited by the breadth-first search for a
+  // path of moves in MakeRoom(). With 8 slots per bucket, it covers the paths
+  // of up to 3 moves.
+  static constexpr std::size_t c_maxSearchNodes = 2U + 16U + 128U + 1024U;
+
+  // BucketLocks class takes the mutexes of two buckets in the address order
+  // to avoid a deadlock. The mutex is taken once if both buckets share it.
+  class BucketLocks {
+   public:
+    BucketLocks(HashTable& hashTable,
+                std::uint32_t firstIndex,
+                std::uint32_t secondIndex) {
+      auto* first = &hashTable.GetMutex(firstIndex);
+      auto* second = &hashTable.GetMutex(secondIndex);
+      if (second < first) {
+        std::swap(first, second);
+      }
+
+      m_first = typename HashTable::UniqueLock{*first};
+      if (second != first) {
+        m_second = typename HashTable::UniqueLock{*second};
+      }
+    }
+
+    void Unlock() {
+      if (m_second.owns_lock()) {
+        m_second.unlock();
+      }
+      m_first.unlock();
+    }
+
+    BucketLocks(const BucketLocks&) = delete;
+    BucketLocks& operator=(const BucketLocks&) = delete;
+
+   private:
+    typename HashTable::UniqueLock m_first;
+    typename HashTable::UniqueLock m_second;
+  };
+
+  // PathNode struct represents a bucket visited by the search in MakeRoom().
+  // The record in the slot "m_slotIndex" of the parent bucket can be moved to
+  // this bucket, which is its other bucket.
+  struct PathNode {
+    std::uint32_t m_bucketIndex;
+    std::int32_t m_parent;
+    std::uint8_t m_slotIndex;
+    const RecordBuffer* m_record;
+  };
+
+  // Returns true if either of the given buckets has the record with the given
+  // key and sets its bucket and slot index. It is assumed that this function is
+  // called under the locks of both buckets.
+  bool FindSlot(const typename HashTable::BucketIndexes& indexes,
+                const Key& key,
+                std::uint16_t tag,
+                typename HashTable::Bucket*& bucket,
+                std::uint8_t& index) const {
+    auto& buckets = this->m_hashTable.GetBuckets();
+
+    for (const auto bucketIndex : {indexes.first, indexes.second}) {
+      auto& current = buckets[bucketIndex];
+
+      for (auto mask = current.MatchTag(tag); mask != 0U; mask &= mask - 1U) {
+        const auto i = Utils::Math::CountTrailingZeros(mask);
+        const auto data = current.m_dataList[i].Load(std::memory_order_relaxed);
+
+        if (data != nullptr) {
+          if (this->m_recordSerializer.IsKeyEqual(key, *data)) {
+            bucket = &current;
+            index = static_cast<std::uint8_t>(i);
+            return true;
+          }
+
+          this->OnTagFalsePositive();
+        }
+      }
+    }
+
+    return false;
+  }
+
+  // Makes room in one of the given buckets by moving the records to their
+  // other buckets along the shortest path found by a breadth-first search.
+  // Returns false if no path is found, which means the hash table is full.
+  // Returns true once the moves are done or if the path became stale due to
+  // the concurrent writers, in which case the caller tries again.
+  //
+  // The search reads the buckets without the locks, which is safe because the
+  // records are not freed until the epoch moves on, and each move is validated
+  // under the locks of its two buckets.
+  bool MakeRoom(const typename HashTable::BucketIndexes& indexes) {
+    typename HashTable::Lock displacementLock{
+        this->m_hashTable.m_displacementMutex};
+
+    const auto& buckets = this->m_hashTable.GetBuckets();
+
+    std::vector<PathNode> nodes;
+    nodes.reserve(c_maxSearchNodes);
+    nodes.push_back(PathNode{indexes.first, -1, 0U, nullptr});
+    if (indexes.second != indexes.first) {
+      nodes.push_back(PathNode{indexes.second, -1, 0U, nullptr});
+    }
+
+    for (std::size_t current = 0U; current < nodes.size(); ++current) {
+      const auto bucketIndex = nodes[current].m_bucketIndex;
+      const auto& bucket = buckets[bucketIndex];
+
+      for (std::uint8_t i = 0U; i < HashTable::Bucket::c_numSlots; ++i) {
+        const auto* record =
+            bucket.m_dataList[i].Load(std::memory_order_acquire);
+
+        if (record == nullptr) {
+          return MovePath(nodes, current, i);
+        }
+
+        if (nodes.size() == c_maxSearchNodes) {
+          continue;
+        }
+
+        const auto recordIndexes = this->m_hashTable.GetBucketIndexes(
+            this->GetBucketInfo(
+                    this->m_recordSerializer.Deserialize(*record).m_key)
+                .first);
+        const auto otherIndex = (recordIndexes.first == bucketIndex)
+                                    ? recordIndexes.second
+                                    : recordIndexes.first;
+
+        if (otherIndex != bucketIndex) {
+          nodes.push_back(PathNode{otherIndex,
+                                   static_cast<std::int32_t>(current), i,
+                                   record});
+        }
+      }
+    }
+
+    return false;
+  }
+
+  // Moves the records along the path ending at the given empty slot, starting
+  // from the end so that each move fills the slot emptied by the previous one.
+  bool MovePath(const std::vector<PathNode>& nodes,
+                std::size_t last,
+                std::uint8_t emptySlotIndex) {
+    auto targetBucketIndex = nodes[last].m_bucketIndex;
+    auto targetSlotIndex = emptySlotIndex;
+
+    for (auto current = static_cast<std::int32_t>(last);
+         nodes[current].m_parent >= 0; current = nodes[current].m_parent) {
+      const auto& node = nodes[current];
+      const auto sourceBucketIndex = nodes[node.m_parent].m_bucketIndex;
+
+      if (!Move(sourceBucketIndex, node.m_slotIndex, node.m_record,
+                targetBucketIndex, targetSlotIndex)) {
+        return true;
+      }
+
+      targetBucketIndex = sourceBucketIndex;
+      targetSlotIndex = node.m_slotIndex;
+    }
+
+    return true;
+  }
+
+  // Moves the given record between its two buckets. Returns false if the
+  // source slot no longer has the record or the target slot is no longer
+  // empty. Since both buckets are locked, no writer can update the key.
+  bool Move(std::uint32_t sourceBucketIndex,
+            std::uint8_t sourceSlotIndex,
+            const RecordBuffer* record,
+            std::uint32_t targetBucketIndex,
+            std::uint8_t targetSlotIndex) {
+    BucketLocks locks{this->m_hashTable, sourceBucketIndex, targetBucketIndex};
+
+    auto& buckets = this->m_hashTable.GetBuckets();
+    auto& source = buckets[sourceBucketIndex];
+    auto& target = buckets[targetBucketIndex];
+
+    auto* recordToMove =
+        source.m_dataList[sourceSlotIndex].Load(std::memory_order_relaxed);
+
+    if (recordToMove != record ||
+        target.m_dataList[targetSlotIndex].Load(std::memory_order_relaxed) !=
+            nullptr) {
+      return false;
+    }
+
+    source.BeginMove();
+    target.BeginMove();
+
+    target.m_tags[targetSlotIndex] = source.m_tags[sourceSlotIndex];
+    target.m_dataList[targetSlotIndex].Store(recordToMove,
+                                             std::memory_order_release);
+    source.m_dataList[sourceSlotIndex].Store(nullptr,
+                                             std::memory_order_release);
+
+    target.EndMove();
+    source.EndMove();
+
+    return true;
+  }
+
+  RecordBuffer* CreateRecordBuffer(const Key& key, const Value& value) {
+    const auto bufferSize =
+        this->m_recordSerializer.CalculateBufferSize(key, value);
+    auto buffer = Detail::to_raw_pointer(
+        this->m_hashTable.template GetAllocator<std::uint8_t>().allocate(
+            bufferSize));
+
+    return this->m_recordSerializer.Serialize(key, value, buffer, bufferSize);
+  }
+
+  void ReleaseRecord(RecordBuffer* record) {
+    m_epochManager.RegisterAction([this, record]() {
+      record->~RecordBuffer();
+      this->m_hashTable.template GetAllocator<RecordBuffer>().deallocate(record,
+                                                                         1U);
+    });
+  }
+
+  IEpochActionManager& m_epochManager;
+};
+
+template <typename Allocator>
+constexpr std::size_t WritableHashTable<Allocator>::c_maxSearchNodes;
+
+#pragma warning(pop)
+
+// WritableHashTable::Serializer class that implements ISerializer, which
+// provides the functionality to serialize the WritableHashTable. The format is
+// the same as the one of ReadWrite hash table, so a hash table serialized by
+// one engine can be deserialized by the other.
+template <typename Allocator>
+class WritableHashTable<Allocator>::Serializer
+    : public IWritableHashTable::ISerializer {
+ public:
+  explicit Serializer(HashTable& hashTable) : m_hashTable{hashTable} {}
+
+  Serializer(const Serializer&) = delete;
+  Serializer& operator=(const Serializer&) = delete;
+
+  void Serialize(std::ostream& stream,
+                 const Utils::Properties& /* properties */) override {
+    ReadWrite::Serializer<HashTable, Cuckoo::ReadOnlyHashTable>{}.Serialize(
+        m_hashTable, stream);
+  }
+
+ private:
+  HashTable& m_hashTable;
+};
+
+}  // namespace Cuckoo
+}  // namespace HashTable
+}  // namespace L4
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <iosfwd>
+#include <vector>
+#include "Log/HashTableStats.h"
 #include "Log/PerfCounter.h"
 #include "Utils/Properties.h"
 
@@ -41,9 +44,66 @@ struct IReadOnlyHashTable {
 
   virtual bool Get(const Key& key, Value& value) const = 0;
 
+  // Looks up the given key and copies its value to the given buffer, which
+  // is resized to the size of the value. Unlike Get(), the copy is consistent
+  // even if the value is updated in place concurrently (see
+  // HashTableConfig::Setting::m_inPlaceUpdates). The capacity of the buffer
+  // is reused across the calls. The default implementation copies the value
+  // returned by Get().
+  virtual bool GetCopy(const Key& key, std::vector<std::uint8_t>& value) const;
+
+  // Looks up the given number of keys in a batch. For each i-th key, found[i]
+  // is set to whether the key exists and, if so, values[i] is set to its value.
+  // Returns the number of keys found. The batch allows the memory accesses of
+  // different keys to be overlapped, so it is faster than calling Get() for
+  // each key when the table does not fit in the CPU cache.
+  virtual std::size_t MultiGet(const Key* keys,
+                               std::size_t numKeys,
+                               Value* values,
+                               bool* found) const = 0;
+
   virtual IIteratorPtr GetIterator() const = 0;
 
+  // The callback for ForEachRecord(), which is called with the given context,
+  // the index of the calling thread and a record.
+  using ForEachCallback = void (*)(void* context,
+                                   std::uint16_t threadIndex,
+                                   const Key& key,
+                                   const Value& value);
+
+  // Calls the given callback for each record with the given number of threads
+  // (including the calling thread), where each thread scans a disjoint range
+  // of the buckets. The callback is called concurrently from the different
+  // threads. The default implementation scans the records with the iterator
+  // on the calling thread.
+  virtual void ForEachRecord(ForEachCallback callback,
+                             void* context,
+                             std::uint16_t numThreads) const;
+
+  // Calls func(threadIndex, key, value) for each record with the given number
+  // of threads. See ForEachRecord().
+  template <typename Func>
+  void ParallelForEach(const Func& func, std::uint16_t numThreads) const {
+    ForEachRecord(&InvokeForEachCallback<Func>,
+                  const_cast<void*>(static_cast<const void*>(&func)),
+                  numThreads);
+  }
+
+  // The ForEachCallback that calls the given function object as the context.
+  template <typename Func>
+  static void InvokeForEachCallback(void* context,
+                                    std::uint16_t threadIndex,
+                                    const Key& key,
+                                    const Value& value) {
+    (*static_cast<const Func*>(context))(threadIndex, key, value);
+  }
+
   virtual const HashTablePerfData& GetPerfData() const = 0;
+
+  // Collects the statistics of the buckets and the records without blocking
+  // the writers (see HashTableStats). The default implementation only counts
+  // the records and their sizes through ForEachRecord().
+  virtual HashTableStats GetStats(const HashTableStatsOptions& options) const;
 };
 
 // IReadOnlyHashTable::IIterator interface for the hash table iterator.
@@ -59,19 +119,185 @@ struct IReadOnlyHashTable::IIterator {
   virtual Value GetValue() const = 0;
 };
 
+inline bool IReadOnlyHashTable::GetCopy(
+    const Key& key,
+    std::vector<std::uint8_t>& value) const {
+  Value found;
+  if (!Get(key, found)) {
+    return false;
+  }
+
+  value.assign(found.m_data, found.m_data + found.m_size);
+  return true;
+}
+
+inline HashTableStats IReadOnlyHashTable::GetStats(
+    const HashTableStatsOptions& options) const {
+  const auto numThreads =
+      (std::max)(options.m_numThreads, static_cast<std::uint16_t>(1U));
+
+  std::vector<HashTableStats> stats(numThreads);
+  ParallelForEach(
+      [&stats](std::uint16_t threadIndex, const Key& key, const Value& value) {
+        stats[threadIndex].AddRecord(key.m_size + value.m_size);
+      },
+      numThreads);
+
+  for (std::uint16_t i = 1U; i < numThreads; ++i) {
+    stats[0].Merge(stats[i]);
+  }
+
+  return std::move(stats[0]);
+}
+
+inline void IReadOnlyHashTable::ForEachRecord(
+    ForEachCallback callback,
+    void* context,
+    std::uint16_t /* numThreads */) const {
+  auto iterator = GetIterator();
+  while (iterator->MoveNext()) {
+    callback(context, 0U, iterator->GetKey(), iterator->GetValue());
+  }
+}
+
 // IWritableHashTable interface for write access to the hash table.
 struct IWritableHashTable : public virtual IReadOnlyHashTable {
   struct ISerializer;
 
+  struct IMergeOperator;
+
   using ISerializerPtr = std::unique_ptr<ISerializer>;
 
+  // KeyValue struct represents a record given to the batch operations.
+  struct KeyValue {
+    KeyValue() = default;
+
+    KeyValue(const Key& key, const Value& value) : m_key{key}, m_value{value} {}
+
+    Key m_key;
+    Value m_value;
+  };
+
+  // BulkLoadOptions struct configures BulkLoad().
+  struct BulkLoadOptions {
+    explicit BulkLoadOptions(std::uint16_t numThreads = 1U,
+                             bool skipDuplicateCheck = false)
+        : m_numThreads{numThreads}, m_skipDuplicateCheck{skipDuplicateCheck} {}
+
+    // The number of threads (including the calling thread) that load the
+    // records.
+    std::uint16_t m_numThreads;
+
+    // If set to true, the keys are assumed to be unique and not in the hash
+    // table already, so that the records are placed in the first empty slots
+    // without looking for the same key. Otherwise, the duplicate keys are
+    // replaced as Add() does, where the last one in the batch wins.
+    bool m_skipDuplicateCheck;
+  };
+
   virtual void Add(const Key& key, const Value& value) = 0;
 
+  // Adds the given records, which is meant for populating a hash table. Unlike
+  // calling Add() for each record, the hash table may load the records in
+  // parallel and update the perf counters once at the end. The default
+  // implementation calls Add() for each record.
+  virtual void BulkLoad(const KeyValue* records,
+                        std::size_t numRecords,
+                        const BulkLoadOptions& /* options */) {
+    for (std::size_t i = 0U; i < numRecords; ++i) {
+      Add(records[i].m_key, records[i].m_value);
+    }
+  }
+
+  // Adds the given records in a batch, where the last one wins for the same
+  // key in the batch. The hash table may apply the records guarded by the same
+  // lock at once and update the perf counters once for the batch. The default
+  // implementation calls Add() for each record.
+  virtual void AddBatch(const KeyValue* records, std::size_t numRecords) {
+    for (std::size_t i = 0U; i < numRecords; ++i) {
+      Add(records[i].m_key, records[i].m_value);
+    }
+  }
+
   virtual bool Remove(const Key& key) = 0;
 
+  // Removes the given keys in a batch in the same way as AddBatch(), and
+  // returns the number of the records removed. If "removed" is not nullptr,
+  // removed[i] is set to whether the i-th key is removed. The default
+  // implementation calls Remove() for each key.
+  virtual std::size_t RemoveBatch(const Key* keys,
+                                  std::size_t numKeys,
+                                  bool* removed) {
+    std::size_t numRemoved = 0U;
+    for (std::size_t i = 0U; i < numKeys; ++i) {
+      const bool isRemoved = Remove(keys[i]);
+      if (removed != nullptr) {
+        removed[i] = isRemoved;
+      }
+      numRemoved += isRemoved ? 1U : 0U;
+    }
+
+    return numRemoved;
+  }
+
+  // Replaces the value of the given key with the one produced by the given
+  // merge operator from the existing value and the given operand, adding the
+  // key if it does not exist (e.g., to increment a counter or to append to a
+  // list without a separate Get() and Add()). The hash table may produce the
+  // new value under the lock guarding the key so that the concurrent
+  // Upsert()s of the same key are not lost. The default implementation calls
+  // Get() and Add(), thus it is not atomic.
+  virtual void Upsert(const Key& key,
+                      const Value& operand,
+                      const IMergeOperator& mergeOperator);
+
+  // Reclaims the space left by the removed records in up to the given number
+  // of buckets, continuing from the bucket where the previous call stopped,
+  // and returns the number of the chained entries released. This is meant to
+  // be called periodically (e.g., see HashTableConfig::Compaction) under an
+  // epoch. The default implementation does nothing.
+  virtual std::size_t Compact(std::uint32_t /* maxNumBuckets */) { return 0U; }
+
+  // Evicts the records ahead of the writers if the cache is filled above the
+  // high watermark, and returns the number of the records evicted. This is
+  // meant to be called periodically (e.g., see
+  // HashTableConfig::Cache::BackgroundEviction) under an epoch. The default
+  // implementation does nothing.
+  virtual std::size_t EvictToWatermark() { return 0U; }
+
   virtual ISerializerPtr GetSerializer() const = 0;
 };
 
+// IWritableHashTable::IMergeOperator interface produces the new value of a key
+// for Upsert() from its existing value and an operand. It may be called under
+// the lock guarding the key, thus it should not access the hash table.
+struct IWritableHashTable::IMergeOperator {
+  virtual ~IMergeOperator() = default;
+
+  // Returns the size of the new value, where existingValue is nullptr if the
+  // key does not exist.
+  virtual Value::size_type GetMergedSize(const Value* existingValue,
+                                         const Value& operand) const = 0;
+
+  // Writes the new value of GetMergedSize() bytes to the given buffer.
+  virtual void Merge(const Value* existingValue,
+                     const Value& operand,
+                     std::uint8_t* buffer) const = 0;
+};
+
+inline void IWritableHashTable::Upsert(const Key& key,
+                                       const Value& operand,
+                                       const IMergeOperator& mergeOperator) {
+  Value existingValue;
+  const auto* existing = Get(key, existingValue) ? &existingValue : nullptr;
+
+  std::vector<std::uint8_t> buffer(
+      mergeOperator.GetMergedSize(existing, operand));
+  mergeOperator.Merge(existing, operand, buffer.data());
+
+  Add(key, Value{buffer.data(), static_cast<Value::size_type>(buffer.size())});
+}
+
 // IWritableHashTable::ISerializer interface for serializing hash table.
 struct IWritableHashTable::ISerializer {
   virtual ~ISerializer() = default;
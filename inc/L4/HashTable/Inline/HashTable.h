@@ -0,0 +1,438 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include "Epoch/IEpochActionManager.h"
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/InlineSharedHashTable.h"
+#include "HashTable/IHashTable.h"
+#include "Log/PerfCounter.h"
+#include "Utils/Exception.h"
+#include "Utils/Math.h"
+#include "Utils/Prefetch.h"
+#include "detail/ToRawPointer.h"
+
+namespace L4 {
+
+// InlineHashTable is a hash table for small fixed-size keys and values, where
+// the records are stored in the bucket entries. Compared to ReadWrite hash
+// table, a look up doesn't need to chase a pointer to the record and a record
+// doesn't need a separate allocation.
+namespace HashTable {
+namespace Inline {
+
+// ReadOnlyHashTable class implements IReadOnlyHashTable interface and provides
+// the functionality to read data given a key.
+template <typename Allocator>
+class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
+ public:
+  using HashTable = InlineSharedHashTable<Allocator>;
+
+  class Iterator;
+
+  explicit ReadOnlyHashTable(HashTable& hashTable)
+      : m_hashTable{hashTable},
+        m_keySize{hashTable.m_setting.m_fixedKeySize},
+        m_valueSize{hashTable.m_setting.m_fixedValueSize} {}
+
+  virtual bool Get(const Key& key, Value& value) const override {
+    return Find(key, GetBucketInfo(key), value);
+  }
+
+  // MultiGet hashes all the keys in a group and prefetches their buckets
+  // before looking them up, so that the cache misses of the keys in the same
+  // group are overlapped (see ReadWrite::ReadOnlyHashTable::MultiGet()). Since
+  // the records are in the buckets, there is no second stage here.
+  virtual std::size_t MultiGet(const Key* keys,
+                               std::size_t numKeys,
+                               Value* values,
+                               bool* found) const override {
+    std::array<BucketInfo, c_multiGetGroupSize> bucketInfos;
+    std::size_t numFound = 0U;
+
+    for (std::size_t start = 0U; start < numKeys;
+         start += c_multiGetGroupSize) {
+      const auto groupSize = (std::min)(numKeys - start, c_multiGetGroupSize);
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        bucketInfos[i] = GetBucketInfo(keys[start + i]);
+        Utils::Prefetch(&m_hashTable.GetBucket(bucketInfos[i].first),
+                        sizeof(typename HashTable::Entry));
+      }
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        found[start + i] =
+            Find(keys[start + i], bucketInfos[i], values[start + i]);
+        numFound += found[start + i] ? 1U : 0U;
+      }
+    }
+
+    return numFound;
+  }
+
+  virtual IIteratorPtr GetIterator() const override {
+    return std::make_unique<Iterator>(m_hashTable);
+  }
+
+  virtual const HashTablePerfData& GetPerfData() const override {
+    // Synchronizes with any std::memory_order_release if there exists, so that
+    // HashTablePerfData has the latest values at the moment when GetPerfData()
+    // is called.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_hashTable.m_perfData;
+  }
+
+  ReadOnlyHashTable(const ReadOnlyHashTable&) = delete;
+  ReadOnlyHashTable& operator=(const ReadOnlyHashTable&) = delete;
+
+ protected:
+  // The inline entries keep one-byte tags since the slot states already tell
+  // the empty slots (see InlineSharedHashTable::Entry).
+  using BucketInfo = std::pair<std::uint64_t, std::uint8_t>;
+  using State = typename HashTable::Entry::State;
+
+  static constexpr std::size_t c_multiGetGroupSize = 16U;
+
+  // Looks up the given key whose bucket information is already calculated.
+  bool Find(const Key& key, const BucketInfo& bucketInfo, Value& value) const {
+    if (key.m_size != m_keySize) {
+      return false;
+    }
+
+    const auto* entry = &m_hashTable.GetBucket(bucketInfo.first);
+
+    while (entry != nullptr) {
+      for (auto mask = entry->MatchTag(bucketInfo.second); mask != 0U;
+           mask &= mask - 1U) {
+        const auto i = Utils::Math::CountTrailingZeros(mask);
+
+        // The acquire load synchronizes with the release store of Occupied,
+        // which happens after the record is written.
+        if (entry->m_states[i].load(std::memory_order_acquire) ==
+            State::Occupied) {
+          if (IsKeyEqual(entry->m_records[i], key)) {
+            value.m_data = entry->m_records[i].data() + m_keySize;
+            value.m_size = m_valueSize;
+            return true;
+          }
+
+          m_hashTable.m_perfData.Increment(
+              HashTablePerfCounter::TagFalsePositiveCount);
+        }
+      }
+
+      entry = entry->m_next.Load(std::memory_order_acquire);
+    }
+
+    return false;
+  }
+
+  BucketInfo GetBucketInfo(const Key& key) const {
+    const auto hashValue = Hasher::Hash(m_hashTable.m_setting.m_hashFunction,
+                                        key.m_data, key.m_size);
+
+    return {hashValue.first, static_cast<std::uint8_t>(hashValue.second)};
+  }
+
+  bool IsKeyEqual(const typename HashTable::Entry::Record& record,
+                  const Key& key) const {
+    return !memcmp(record.data(), key.m_data, m_keySize);
+  }
+
+  HashTable& m_hashTable;
+
+  const Key::size_type m_keySize;
+  const Value::size_type m_valueSize;
+};
+
+template <typename Allocator>
+constexpr std::size_t ReadOnlyHashTable<Allocator>::c_multiGetGroupSize;
+
+// ReadOnlyHashTable::Iterator class implements IIterator interface and provides
+// read-only iterator for the ReadOnlyHashTable.
+template <typename Allocator>
+class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
+ public:
+  explicit Iterator(const HashTable& hashTable)
+      : m_hashTable{hashTable},
+        m_currentBucketIndex{-1},
+        m_currentRecordIndex{0U},
+        m_currentEntry{nullptr} {}
+
+  void Reset() override {
+    m_currentBucketIndex = -1;
+    m_currentRecordIndex = 0U;
+    m_currentEntry = nullptr;
+  }
+
+  bool MoveNext() override {
+    if (IsEnd()) {
+      return false;
+    }
+
+    if (m_currentEntry != nullptr) {
+      MoveToNextData();
+    }
+
+    while ((m_currentEntry == nullptr) ||
+           m_currentEntry->m_states[m_currentRecordIndex].load(
+               std::memory_order_acquire) != State::Occupied) {
+      if (m_currentEntry == nullptr) {
+        ++m_currentBucketIndex;
+        m_currentRecordIndex = 0U;
+
+        if (IsEnd()) {
+          return false;
+        }
+
+        m_currentEntry = &m_hashTable.GetBuckets()[m_currentBucketIndex];
+      } else {
+        MoveToNextData();
+      }
+    }
+
+    return true;
+  }
+
+  Key GetKey() const override {
+    if (!IsValid()) {
+      throw RuntimeException("HashTableIterator is not correctly used.");
+    }
+
+    return Key{m_currentEntry->m_records[m_currentRecordIndex].data(),
+               m_hashTable.m_setting.m_fixedKeySize};
+  }
+
+  Value GetValue() const override {
+    if (!IsValid()) {
+      throw RuntimeException("HashTableIterator is not correctly used.");
+    }
+
+    return Value{m_currentEntry->m_records[m_currentRecordIndex].data() +
+                     m_hashTable.m_setting.m_fixedKeySize,
+                 m_hashTable.m_setting.m_fixedValueSize};
+  }
+
+  Iterator(const Iterator&) = delete;
+  Iterator& operator=(const Iterator&) = delete;
+
+ private:
+  bool IsValid() const { return !IsEnd() && (m_currentEntry != nullptr); }
+
+  bool IsEnd() const {
+    return m_currentBucketIndex ==
+           static_cast<std::int64_t>(m_hashTable.GetBuckets().size());
+  }
+
+  void MoveToNextData() {
+    if (++m_currentRecordIndex >= HashTable::Entry::c_numDataPerEntry) {
+      m_currentRecordIndex = 0U;
+      m_currentEntry = m_currentEntry->m_next.Load();
+    }
+  }
+
+  const HashTable& m_hashTable;
+
+  std::int64_t m_currentBucketIndex;
+  std::uint8_t m_currentRecordIndex;
+
+  const typename HashTable::Entry* m_currentEntry;
+};
+
+// The following warning is from the virtual inheritance and safe to disable in
+// this case. https://msdn.microsoft.com/en-us/library/6b3sy7ae.aspx
+#pragma warning(push)
+#pragma warning(disable : 4250)
+
+// WritableHashTable class implements IWritableHashTable interface and also
+// provides the read only access (Get()) to the hash table.
+template <typename Allocator>
+class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
+                          public virtual IWritableHashTable {
+ public:
+  using Base = ReadOnlyHashTable<Allocator>;
+  using HashTable = typename Base::HashTable;
+
+  WritableHashTable(HashTable& hashTable, IEpochActionManager& epochManager)
+      : Base(hashTable), m_epochManager{epochManager} {}
+
+  virtual void Add(const Key& key, const Value& value) override {
+    if (key.m_size != this->m_keySize || value.m_size != this->m_valueSize) {
+      throw RuntimeException("Invalid key or value sizes are given.");
+    }
+
+    const auto bucketInfo = this->GetBucketInfo(key);
+
+    typename HashTable::UniqueLock lock{
+        this->m_hashTable.GetMutex(bucketInfo.first)};
+
+    std::uint8_t oldIndex = 0U;
+    auto* oldEntry = FindEntry(bucketInfo, key, oldIndex);
+
+    std::uint32_t chainIndex = 0U;
+    bool isNewEntryAdded = false;
+    std::uint8_t index = 0U;
+    auto& entry = FindEmptySlot(bucketInfo.first, index, chainIndex,
+                                isNewEntryAdded);
+
+    auto& record = entry.m_records[index];
+    memcpy(record.data(), key.m_data, key.m_size);
+    memcpy(record.data() + key.m_size, value.m_data, value.m_size);
+    entry.m_tags[index] = bucketInfo.second;
+
+    // Publish the new record before retiring the old one so that the readers
+    // always find the key.
+    entry.m_states[index].store(State::Occupied, std::memory_order_release);
+
+    auto& perfData = this->m_hashTable.m_perfData;
+
+    if (isNewEntryAdded) {
+      perfData.Increment(HashTablePerfCounter::ChainingEntriesCount);
+      perfData.Add(HashTablePerfCounter::TotalIndexSize,
+                   sizeof(typename HashTable::Entry));
+      perfData.Max(HashTablePerfCounter::MaxBucketChainLength, chainIndex);
+    }
+
+    if (oldEntry != nullptr) {
+      oldEntry->m_states[oldIndex].store(State::Retired,
+                                         std::memory_order_release);
+      lock.unlock();
+
+      ReleaseSlot(bucketInfo.first, *oldEntry, oldIndex);
+      return;
+    }
+
+    perfData.Increment(HashTablePerfCounter::RecordsCount);
+    perfData.Add(HashTablePerfCounter::TotalKeySize, key.m_size);
+    perfData.Add(HashTablePerfCounter::TotalValueSize, value.m_size);
+    perfData.Min(HashTablePerfCounter::MinKeySize, key.m_size);
+    perfData.Max(HashTablePerfCounter::MaxKeySize, key.m_size);
+    perfData.Min(HashTablePerfCounter::MinValueSize, value.m_size);
+    perfData.Max(HashTablePerfCounter::MaxValueSize, value.m_size);
+  }
+
+  virtual bool Remove(const Key& key) override {
+    if (key.m_size != this->m_keySize) {
+      return false;
+    }
+
+    const auto bucketInfo = this->GetBucketInfo(key);
+
+    typename HashTable::UniqueLock lock{
+        this->m_hashTable.GetMutex(bucketInfo.first)};
+
+    std::uint8_t index = 0U;
+    auto* entry = FindEntry(bucketInfo, key, index);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    entry->m_states[index].store(State::Retired, std::memory_order_release);
+    lock.unlock();
+
+    ReleaseSlot(bucketInfo.first, *entry, index);
+
+    auto& perfData = this->m_hashTable.m_perfData;
+    perfData.Decrement(HashTablePerfCounter::RecordsCount);
+    perfData.Subtract(HashTablePerfCounter::TotalKeySize, this->m_keySize);
+    perfData.Subtract(HashTablePerfCounter::TotalValueSize, this->m_valueSize);
+
+    return true;
+  }
+
+  virtual ISerializerPtr GetSerializer() const override {
+    throw std::runtime_error("Not implemented yet.");
+  }
+
+ private:
+  using BucketInfo = typename Base::BucketInfo;
+  using State = typename Base::State;
+
+  // Returns the entry containing the given key and sets its index to "index".
+  // Returns nullptr if not found. It is assumed that this function is called
+  // under a lock.
+  typename HashTable::Entry* FindEntry(const BucketInfo& bucketInfo,
+                                       const Key& key,
+                                       std::uint8_t& index) {
+    auto* entry = &this->m_hashTable.GetBucket(bucketInfo.first);
+
+    while (entry != nullptr) {
+      for (auto mask = entry->MatchTag(bucketInfo.second); mask != 0U;
+           mask &= mask - 1U) {
+        const auto i = Utils::Math::CountTrailingZeros(mask);
+
+        if (entry->m_states[i].load(std::memory_order_relaxed) ==
+                State::Occupied &&
+            this->IsKeyEqual(entry->m_records[i], key)) {
+          index = static_cast<std::uint8_t>(i);
+          return entry;
+        }
+      }
+
+      entry = entry->m_next.Load(std::memory_order_relaxed);
+    }
+
+    return nullptr;
+  }
+
+  // Returns the entry with an empty slot in the bucket for the given hash value
+  // and sets the slot index to "index", appending a new entry to the chain if
+  // there is no empty slot. It is assumed that this function is called under a
+  // lock.
+  typename HashTable::Entry& FindEmptySlot(std::uint64_t hash,
+                                           std::uint8_t& index,
+                                           std::uint32_t& chainIndex,
+                                           bool& isNewEntryAdded) {
+    auto* entry = &this->m_hashTable.GetBucket(hash);
+
+    while (true) {
+      ++chainIndex;
+
+      for (std::uint8_t i = 0U; i < HashTable::Entry::c_numDataPerEntry; ++i) {
+        if (entry->m_states[i].load(std::memory_order_relaxed) ==
+            State::Empty) {
+          index = i;
+          return *entry;
+        }
+      }
+
+      auto* next = entry->m_next.Load(std::memory_order_relaxed);
+      if (next == nullptr) {
+        next = new (Detail::to_raw_pointer(
+            this->m_hashTable.template GetAllocator<typename HashTable::Entry>()
+                .allocate(1U))) typename HashTable::Entry();
+        entry->m_next.Store(next, std::memory_order_release);
+        isNewEntryAdded = true;
+      }
+
+      entry = next;
+    }
+  }
+
+  // Makes the given retired slot empty once no reader can be accessing the
+  // record in it. Note that this should be called outside of the lock since
+  // the action takes the lock.
+  void ReleaseSlot(std::uint64_t hash,
+                   typename HashTable::Entry& entry,
+                   std::uint8_t index) {
+    // Note that the chained entries are not freed until the hash table is
+    // destroyed, thus "entry" is still valid when the action is performed.
+    m_epochManager.RegisterAction([this, hash, &entry, index]() {
+      typename HashTable::Lock lock{this->m_hashTable.GetMutex(hash)};
+
+      entry.m_tags[index] = 0U;
+      entry.m_states[index].store(State::Empty, std::memory_order_release);
+    });
+  }
+
+  IEpochActionManager& m_epochManager;
+};
+
+#pragma warning(pop)
+
+}  // namespace Inline
+}  // namespace HashTable
+}  // namespace L4
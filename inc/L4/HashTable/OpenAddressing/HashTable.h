@@ -0,0 +1,493 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include "Epoch/IEpochActionManager.h"
+#include "HashTable/Common/Hasher.h"
+#include "HashTable/Common/OpenAddressingSharedHashTable.h"
+#include "HashTable/Common/Record.h"
+#include "HashTable/IHashTable.h"
+#include "HashTable/ReadWrite/Serializer.h"
+#include "Log/PerfCounter.h"
+#include "Utils/Exception.h"
+#include "Utils/Math.h"
+#include "Utils/Prefetch.h"
+#include "Utils/Properties.h"
+#include "detail/ToRawPointer.h"
+
+namespace L4 {
+
+// OpenAddressing hash table is a hash table engine where the records are
+// placed in a fixed array of slots probed in groups (see
+// OpenAddressingSharedHashTable). Same as ReadWrite hash table, the look up is
+// lock free and the records are reclaimed through the epoch manager.
+namespace HashTable {
+namespace OpenAddressing {
+
+// ReadOnlyHashTable class implements IReadOnlyHashTable interface and provides
+// the functionality to read data given a key.
+template <typename Allocator>
+class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
+ public:
+  using HashTable = OpenAddressingSharedHashTable<Allocator>;
+
+  class Iterator;
+
+  explicit ReadOnlyHashTable(HashTable& hashTable)
+      : m_hashTable{hashTable},
+        m_recordSerializer{hashTable.m_setting.m_fixedKeySize,
+                           hashTable.m_setting.m_fixedValueSize} {}
+
+  virtual bool Get(const Key& key, Value& value) const override {
+    return Find(key, GetBucketInfo(key), value);
+  }
+
+  // MultiGet resolves the keys in groups of c_multiGetGroupSize in stages so
+  // that the cache misses of the keys in the same group are overlapped (see
+  // ReadWrite::ReadOnlyHashTable::MultiGet()).
+  virtual std::size_t MultiGet(const Key* keys,
+                               std::size_t numKeys,
+                               Value* values,
+                               bool* found) const override {
+    std::array<BucketInfo, c_multiGetGroupSize> bucketInfos;
+    std::size_t numFound = 0U;
+
+    const auto& groups = m_hashTable.GetBuckets();
+
+    for (std::size_t start = 0U; start < numKeys;
+         start += c_multiGetGroupSize) {
+      const auto groupSize = (std::min)(numKeys - start, c_multiGetGroupSize);
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        bucketInfos[i] = GetBucketInfo(keys[start + i]);
+        Utils::Prefetch(
+            &groups[m_hashTable.GetGroupIndex(bucketInfos[i].first)],
+            sizeof(typename HashTable::Group));
+      }
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        const auto& group =
+            groups[m_hashTable.GetGroupIndex(bucketInfos[i].first)];
+
+        for (auto mask = group.Match(
+                 HashTable::Group::ToControl(bucketInfos[i].second));
+             mask != 0U; mask &= mask - 1U) {
+          Utils::Prefetch(
+              group.m_dataList[Utils::Math::CountTrailingZeros(mask)].Load(
+                  std::memory_order_acquire));
+        }
+      }
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        found[start + i] =
+            Find(keys[start + i], bucketInfos[i], values[start + i]);
+        numFound += found[start + i] ? 1U : 0U;
+      }
+    }
+
+    return numFound;
+  }
+
+  virtual IIteratorPtr GetIterator() const override {
+    return std::make_unique<Iterator>(m_hashTable, m_recordSerializer);
+  }
+
+  virtual const HashTablePerfData& GetPerfData() const override {
+    // Synchronizes with any std::memory_order_release if there exists, so that
+    // HashTablePerfData has the latest values at the moment when GetPerfData()
+    // is called.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_hashTable.m_perfData;
+  }
+
+  ReadOnlyHashTable(const ReadOnlyHashTable&) = delete;
+  ReadOnlyHashTable& operator=(const ReadOnlyHashTable&) = delete;
+
+ protected:
+  using BucketInfo = HashValue;
+
+  static constexpr std::size_t c_multiGetGroupSize = 16U;
+
+  // Looks up the given key whose bucket information is already calculated.
+  bool Find(const Key& key, const BucketInfo& bucketInfo, Value& value) const {
+    const auto& groups = m_hashTable.GetBuckets();
+    const auto control = HashTable::Group::ToControl(bucketInfo.second);
+
+    auto index = m_hashTable.GetGroupIndex(bucketInfo.first);
+
+    for (std::size_t probe = 0U; probe < groups.size(); ++probe) {
+      const auto& group = groups[index];
+
+      for (auto mask = group.Match(control); mask != 0U; mask &= mask - 1U) {
+        const auto i = Utils::Math::CountTrailingZeros(mask);
+
+        // The data pointer is loaded once since it can be updated during the
+        // access (the record is not freed until the epoch moves on).
+        const auto data = group.m_dataList[i].Load(std::memory_order_acquire);
+
+        if (data != nullptr) {
+          if (m_recordSerializer.IsKeyEqual(key, *data)) {
+            value = m_recordSerializer.Deserialize(*data).m_value;
+            return true;
+          }
+
+          OnTagFalsePositive();
+        }
+      }
+
+      if (group.MatchEmpty() != 0U) {
+        break;
+      }
+
+      if (++index == groups.size()) {
+        index = 0U;
+      }
+    }
+
+    return false;
+  }
+
+  // Counts a key comparison that failed although the control byte matched.
+  void OnTagFalsePositive() const {
+    m_hashTable.m_perfData.Increment(
+        HashTablePerfCounter::TagFalsePositiveCount);
+  }
+
+  BucketInfo GetBucketInfo(const Key& key) const {
+    return Hasher::Hash(m_hashTable.m_setting.m_hashFunction, key.m_data,
+                        key.m_size);
+  }
+
+  HashTable& m_hashTable;
+
+  RecordSerializer m_recordSerializer;
+};
+
+template <typename Allocator>
+constexpr std::size_t ReadOnlyHashTable<Allocator>::c_multiGetGroupSize;
+
+// ReadOnlyHashTable::Iterator class implements IIterator interface and provides
+// read-only iterator for the ReadOnlyHashTable.
+template <typename Allocator>
+class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
+ public:
+  Iterator(const HashTable& hashTable,
+           const RecordSerializer& recordDeserializer)
+      : m_hashTable{hashTable},
+        m_recordSerializer{recordDeserializer},
+        m_currentGroupIndex{0U},
+        m_currentSlotIndex{-1},
+        m_currentRecord{nullptr} {}
+
+  void Reset() override {
+    m_currentGroupIndex = 0U;
+    m_currentSlotIndex = -1;
+    m_currentRecord = nullptr;
+  }
+
+  bool MoveNext() override {
+    const auto& groups = m_hashTable.GetBuckets();
+
+    while (m_currentGroupIndex < groups.size()) {
+      if (++m_currentSlotIndex >= HashTable::Group::c_numSlots) {
+        m_currentSlotIndex = -1;
+        ++m_currentGroupIndex;
+        continue;
+      }
+
+      m_currentRecord = groups[m_currentGroupIndex]
+                            .m_dataList[m_currentSlotIndex]
+                            .Load(std::memory_order_acquire);
+      if (m_currentRecord != nullptr) {
+        return true;
+      }
+    }
+
+    m_currentRecord = nullptr;
+    return false;
+  }
+
+  Key GetKey() const override {
+    if (m_currentRecord == nullptr) {
+      throw RuntimeException("HashTableIterator is not correctly used.");
+    }
+
+    return m_recordSerializer.Deserialize(*m_currentRecord).m_key;
+  }
+
+  Value GetValue() const override {
+    if (m_currentRecord == nullptr) {
+      throw RuntimeException("HashTableIterator is not correctly used.");
+    }
+
+    return m_recordSerializer.Deserialize(*m_currentRecord).m_value;
+  }
+
+  Iterator(const Iterator&) = delete;
+  Iterator& operator=(const Iterator&) = delete;
+
+ private:
+  const HashTable& m_hashTable;
+  const RecordSerializer& m_recordSerializer;
+
+  std::size_t m_currentGroupIndex;
+  std::int32_t m_currentSlotIndex;
+
+  const RecordBuffer* m_currentRecord;
+};
+
+// The following warning is from the virtual inheritance and safe to disable in
+// this case. https://msdn.microsoft.com/en-us/library/6b3sy7ae.aspx
+#pragma warning(push)
+#pragma warning(disable : 4250)
+
+// WritableHashTable class implements IWritableHashTable interface and also
+// provides the read only access (Get()) to the hash table.
+template <typename Allocator>
+class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
+                          public IWritableHashTable {
+ public:
+  using Base = ReadOnlyHashTable<Allocator>;
+  using HashTable = typename Base::HashTable;
+
+  WritableHashTable(HashTable& hashTable, IEpochActionManager& epochManager)
+      : Base(hashTable), m_epochManager{epochManager} {}
+
+  // Adds the given key and value. Throws RuntimeException if the key is new and
+  // no more slot can be used.
+  virtual void Add(const Key& key, const Value& value) override {
+    auto* recordToAdd = CreateRecordBuffer(key, value);
+    const auto newRecord = this->m_recordSerializer.Deserialize(*recordToAdd);
+    const auto bucketInfo = this->GetBucketInfo(key);
+    const auto control = HashTable::Group::ToControl(bucketInfo.second);
+
+    typename HashTable::UniqueLock lock{this->m_hashTable.m_mutex};
+
+    auto& groups = this->m_hashTable.GetBuckets();
+
+    typename HashTable::Group* availableGroup = nullptr;
+    std::uint8_t availableIndex = 0U;
+    std::uint32_t probeLength = 0U;
+
+    // Note that the following block is performed inside a critical section,
+    // therefore, it is safe to do "Load"s with memory_order_relaxed.
+    auto index = this->m_hashTable.GetGroupIndex(bucketInfo.first);
+    for (std::size_t probe = 0U; probe < groups.size(); ++probe) {
+      auto& group = groups[index];
+
+      std::uint8_t i = 0U;
+      if (FindSlot(group, key, control, i)) {
+        auto& recordHolder = group.m_dataList[i];
+        auto* oldRecord = recordHolder.Load(std::memory_order_relaxed);
+        recordHolder.Store(recordToAdd, std::memory_order_release);
+        lock.unlock();
+
+        const auto oldValueSize =
+            this->m_recordSerializer.Deserialize(*oldRecord).m_value.m_size;
+        ReleaseRecord(oldRecord);
+
+        this->m_hashTable.m_perfData.Add(
+            HashTablePerfCounter::TotalValueSize,
+            static_cast<HashTablePerfData::TValue>(newRecord.m_value.m_size) -
+                oldValueSize);
+        return;
+      }
+
+      // Remember the first available slot, but keep probing for the key.
+      const auto availableMask = group.MatchAvailable();
+      if (availableGroup == nullptr && availableMask != 0U) {
+        availableGroup = &group;
+        availableIndex = static_cast<std::uint8_t>(
+            Utils::Math::CountTrailingZeros(availableMask));
+        probeLength = static_cast<std::uint32_t>(probe + 1U);
+      }
+
+      if (group.MatchEmpty() != 0U) {
+        break;
+      }
+
+      if (++index == groups.size()) {
+        index = 0U;
+      }
+    }
+
+    const bool isEmptySlot =
+        availableGroup != nullptr &&
+        availableGroup->m_controls[availableIndex] == HashTable::Group::c_empty;
+
+    if (availableGroup == nullptr ||
+        (isEmptySlot && this->m_hashTable.m_numUsedSlots >=
+                            this->m_hashTable.m_maxNumUsedSlots)) {
+      lock.unlock();
+
+      // The record is not visible to anyone, so it is freed right away.
+      recordToAdd->~RecordBuffer();
+      this->m_hashTable.template GetAllocator<RecordBuffer>().deallocate(
+          recordToAdd, 1U);
+
+      throw RuntimeException("The hash table is full.");
+    }
+
+    if (isEmptySlot) {
+      ++this->m_hashTable.m_numUsedSlots;
+    }
+
+    // The record is published before the control byte so that a reader that
+    // sees the control byte finds either the record or nullptr.
+    availableGroup->m_dataList[availableIndex].Store(recordToAdd,
+                                                     std::memory_order_release);
+    availableGroup->m_controls[availableIndex] = control;
+
+    lock.unlock();
+
+    auto& perfData = this->m_hashTable.m_perfData;
+    perfData.Increment(HashTablePerfCounter::RecordsCount);
+    perfData.Add(HashTablePerfCounter::TotalKeySize, newRecord.m_key.m_size);
+    perfData.Add(HashTablePerfCounter::TotalValueSize,
+                 newRecord.m_value.m_size);
+    perfData.Add(HashTablePerfCounter::TotalIndexSize,
+                 this->m_recordSerializer.CalculateRecordOverhead());
+    perfData.Min(HashTablePerfCounter::MinKeySize, newRecord.m_key.m_size);
+    perfData.Max(HashTablePerfCounter::MaxKeySize, newRecord.m_key.m_size);
+    perfData.Min(HashTablePerfCounter::MinValueSize, newRecord.m_value.m_size);
+    perfData.Max(HashTablePerfCounter::MaxValueSize, newRecord.m_value.m_size);
+    perfData.Max(HashTablePerfCounter::MaxBucketChainLength, probeLength);
+  }
+
+  virtual bool Remove(const Key& key) override {
+    const auto bucketInfo = this->GetBucketInfo(key);
+    const auto control = HashTable::Group::ToControl(bucketInfo.second);
+
+    typename HashTable::UniqueLock lock{this->m_hashTable.m_mutex};
+
+    auto& groups = this->m_hashTable.GetBuckets();
+
+    auto index = this->m_hashTable.GetGroupIndex(bucketInfo.first);
+    for (std::size_t probe = 0U; probe < groups.size(); ++probe) {
+      auto& group = groups[index];
+
+      std::uint8_t i = 0U;
+      if (FindSlot(group, key, control, i)) {
+        auto* record = group.m_dataList[i].Load(std::memory_order_relaxed);
+        group.m_dataList[i].Store(nullptr, std::memory_order_release);
+
+        // If the group has an empty slot, no key was placed beyond this group
+        // while the slot was used, so the slot can become empty again.
+        if (group.MatchEmpty() != 0U) {
+          group.m_controls[i] = HashTable::Group::c_empty;
+          --this->m_hashTable.m_numUsedSlots;
+        } else {
+          group.m_controls[i] = HashTable::Group::c_deleted;
+        }
+
+        lock.unlock();
+
+        const auto removedRecord =
+            this->m_recordSerializer.Deserialize(*record);
+
+        auto& perfData = this->m_hashTable.m_perfData;
+        perfData.Decrement(HashTablePerfCounter::RecordsCount);
+        perfData.Subtract(HashTablePerfCounter::TotalKeySize,
+                          removedRecord.m_key.m_size);
+        perfData.Subtract(HashTablePerfCounter::TotalValueSize,
+                          removedRecord.m_value.m_size);
+        perfData.Subtract(HashTablePerfCounter::TotalIndexSize,
+                          this->m_recordSerializer.CalculateRecordOverhead());
+
+        ReleaseRecord(record);
+        return true;
+      }
+
+      if (group.MatchEmpty() != 0U) {
+        break;
+      }
+
+      if (++index == groups.size()) {
+        index = 0U;
+      }
+    }
+
+    return false;
+  }
+
+  virtual ISerializerPtr GetSerializer() const override {
+    return std::make_unique<WritableHashTable::Serializer>(this->m_hashTable);
+  }
+
+ private:
+  class Serializer;
+
+  // Returns true if the given group has the record with the given key and sets
+  // its slot index to "index". It is assumed that this function is called
+  // under a lock.
+  bool FindSlot(const typename HashTable::Group& group,
+                const Key& key,
+                std::uint8_t control,
+                std::uint8_t& index) const {
+    for (auto mask = group.Match(control); mask != 0U; mask &= mask - 1U) {
+      const auto i = Utils::Math::CountTrailingZeros(mask);
+      const auto data = group.m_dataList[i].Load(std::memory_order_relaxed);
+
+      if (data != nullptr) {
+        if (this->m_recordSerializer.IsKeyEqual(key, *data)) {
+          index = static_cast<std::uint8_t>(i);
+          return true;
+        }
+
+        this->OnTagFalsePositive();
+      }
+    }
+
+    return false;
+  }
+
+  RecordBuffer* CreateRecordBuffer(const Key& key, const Value& value) {
+    const auto bufferSize =
+        this->m_recordSerializer.CalculateBufferSize(key, value);
+    auto buffer = Detail::to_raw_pointer(
+        this->m_hashTable.template GetAllocator<std::uint8_t>().allocate(
+            bufferSize));
+
+    return this->m_recordSerializer.Serialize(key, value, buffer, bufferSize);
+  }
+
+  void ReleaseRecord(RecordBuffer* record) {
+    m_epochManager.RegisterAction([this, record]() {
+      record->~RecordBuffer();
+      this->m_hashTable.template GetAllocator<RecordBuffer>().deallocate(record,
+                                                                         1U);
+    });
+  }
+
+  IEpochActionManager& m_epochManager;
+};
+
+#pragma warning(pop)
+
+// WritableHashTable::Serializer class that implements ISerializer, which
+// provides the functionality to serialize the WritableHashTable. The format is
+// the same as the one of ReadWrite hash table, so a hash table serialized by
+// one engine can be deserialized by the other.
+template <typename Allocator>
+class WritableHashTable<Allocator>::Serializer
+    : public IWritableHashTable::ISerializer {
+ public:
+  explicit Serializer(HashTable& hashTable) : m_hashTable{hashTable} {}
+
+  Serializer(const Serializer&) = delete;
+  Serializer& operator=(const Serializer&) = delete;
+
+  void Serialize(std::ostream& stream,
+                 const Utils::Properties& /* properties */) override {
+    ReadWrite::Serializer<HashTable, OpenAddressing::ReadOnlyHashTable>{}
+        .Serialize(m_hashTable, stream);
+  }
+
+ private:
+  HashTable& m_hashTable;
+};
+
+}  // namespace OpenAddressing
+}  // namespace HashTable
+}  // namespace L4
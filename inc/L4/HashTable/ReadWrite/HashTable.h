@@ -1,16 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <boost/optional.hpp>
 #include <cstdint>
+#include <limits>
 #include <mutex>
+#include <thread>
+#include <vector>
 #include "Epoch/IEpochActionManager.h"
 #include "HashTable/Common/Record.h"
 #include "HashTable/Common/SharedHashTable.h"
+#include "HashTable/Config.h"
 #include "HashTable/IHashTable.h"
 #include "HashTable/ReadWrite/Serializer.h"
 #include "Log/PerfCounter.h"
 #include "Utils/Exception.h"
-#include "Utils/MurmurHash3.h"
+#include "Utils/Lock.h"
+#include "Utils/Math.h"
+#include "Utils/Parallel.h"
+#include "Utils/Prefetch.h"
 #include "Utils/Properties.h"
 #include "detail/ToRawPointer.h"
 
@@ -22,11 +31,17 @@ namespace HashTable {
 namespace ReadWrite {
 
 // ReadOnlyHashTable class implements IReadOnlyHashTable interface and provides
-// the functionality to read data given a key.
-template <typename Allocator>
+// the functionality to read data given a key. RecordFormat (VarRecord or
+// FixedRecord) selects the record serializer at compile time, and BucketMutex
+// is the type of the mutexes guarding the buckets (see
+// HashTableConfig::BucketLock).
+template <typename Allocator,
+          typename RecordFormat = VarRecord,
+          typename BucketMutex = Utils::ReaderWriterLockSlim>
 class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
  public:
-  using HashTable = SharedHashTable<RecordBuffer, Allocator>;
+  using HashTable = SharedHashTable<RecordBuffer, Allocator, BucketMutex>;
+  using RecordSerializer = typename RecordFormat::Serializer;
 
   class Iterator;
 
@@ -41,39 +56,134 @@ class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
                                    m_hashTable.m_setting.m_fixedValueSize}} {}
 
   virtual bool Get(const Key& key, Value& value) const override {
-    const auto bucketInfo = GetBucketInfo(key);
-    const auto* entry = &m_hashTable.m_buckets[bucketInfo.first];
+    return Find(key, GetBucketInfo(key), value);
+  }
 
-    while (entry != nullptr) {
-      for (std::uint8_t i = 0; i < HashTable::Entry::c_numDataPerEntry; ++i) {
-        if (bucketInfo.second == entry->m_tags[i]) {
-          // There could be a race condition where m_dataList[i] is updated
-          // during access. Therefore, load it once and save it (it's safe to
-          // store it b/c the memory will not be deleted until ref count becomes
-          // 0).
-          const auto data =
-              entry->m_dataList[i].Load(std::memory_order_acquire);
-
-          if (data != nullptr) {
-            const auto record = m_recordSerializer.Deserialize(*data);
-            if (record.m_key == key) {
-              value = record.m_value;
-              return true;
-            }
-          }
+  // If the values are updated in place (see WritableHashTable::Add()), the
+  // value is copied under the sequence counter of the record, retrying while
+  // the value is being overwritten.
+  virtual bool GetCopy(const Key& key,
+                       std::vector<std::uint8_t>& value) const override {
+    if (!m_hashTable.m_setting.m_inPlaceUpdates) {
+      return IReadOnlyHashTable::GetCopy(key, value);
+    }
+
+    Value found;
+    if (!Find(key, GetBucketInfo(key), found)) {
+      return false;
+    }
+
+    const auto& sequence = GetSequence(found);
+    Utils::Backoff backoff;
+
+    while (true) {
+      const auto version = sequence.load(std::memory_order_acquire);
+      if ((version & 1U) == 0U) {
+        value.assign(found.m_data, found.m_data + found.m_size);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == version) {
+          return true;
         }
       }
 
-      entry = entry->m_next.Load(std::memory_order_acquire);
+      backoff();
     }
+  }
 
-    return false;
+  // MultiGet resolves the keys in groups of c_multiGetGroupSize in stages so
+  // that the cache misses of the keys in the same group are overlapped:
+  //   1) hash all the keys and prefetch their buckets,
+  //   2) match the tags in the head entries and prefetch the matched records,
+  //   3) look up each key, which now mostly hits the CPU cache.
+  virtual std::size_t MultiGet(const Key* keys,
+                               std::size_t numKeys,
+                               Value* values,
+                               bool* found) const override {
+    std::array<BucketInfo, c_multiGetGroupSize> bucketInfos;
+    std::size_t numFound = 0U;
+
+    for (std::size_t start = 0U; start < numKeys;
+         start += c_multiGetGroupSize) {
+      const auto groupSize = (std::min)(numKeys - start, c_multiGetGroupSize);
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        bucketInfos[i] = GetBucketInfo(keys[start + i]);
+        Utils::Prefetch(&m_hashTable.GetBucket(bucketInfos[i].first),
+                        sizeof(typename HashTable::Entry));
+      }
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        const auto& entry = m_hashTable.GetBucket(bucketInfos[i].first);
+
+        for (auto mask = entry.MatchTag(bucketInfos[i].second); mask != 0U;
+             mask &= mask - 1U) {
+          Utils::Prefetch(
+              entry.m_dataList[Utils::Math::CountTrailingZeros(mask)].Load(
+                  std::memory_order_acquire));
+        }
+      }
+
+      for (std::size_t i = 0U; i < groupSize; ++i) {
+        found[start + i] =
+            Find(keys[start + i], bucketInfos[i], values[start + i]);
+        numFound += found[start + i] ? 1U : 0U;
+      }
+    }
+
+    return numFound;
   }
 
   virtual IIteratorPtr GetIterator() const override {
     return std::make_unique<Iterator>(m_hashTable, m_recordSerializer);
   }
 
+  // Splits the bucket array into the ranges of the same size, one for each
+  // thread. As with the iterator, the bucket array is fixed when the scan
+  // starts even if the bucket array is resized during the scan. The next
+  // bucket and the records in the current entry are prefetched before the
+  // callback is called for the records.
+  virtual void ForEachRecord(ForEachCallback callback,
+                             void* context,
+                             std::uint16_t numThreads) const override {
+    const auto& buckets = m_hashTable.GetBuckets();
+    numThreads = (std::max)(numThreads, static_cast<std::uint16_t>(1U));
+
+    Utils::RunInParallel(numThreads, [&](std::uint16_t threadIndex) {
+      const auto end = buckets.size() * (threadIndex + 1U) / numThreads;
+
+      for (auto i = buckets.size() * threadIndex / numThreads; i < end; ++i) {
+        if (i + 1U < end) {
+          Utils::Prefetch(&buckets[i + 1U], sizeof(typename HashTable::Entry));
+        }
+
+        for (const auto* entry = &buckets[i]; entry != nullptr;
+             entry = entry->m_next.Load(std::memory_order_acquire)) {
+          std::array<const RecordBuffer*, HashTable::Entry::c_numDataPerEntry>
+              records;
+          for (std::uint8_t j = 0U; j < records.size(); ++j) {
+            records[j] = entry->m_dataList[j].Load(std::memory_order_acquire);
+            if (records[j] != nullptr) {
+              Utils::Prefetch(records[j]);
+            }
+          }
+
+          for (const auto* data : records) {
+            if (data != nullptr) {
+              const auto record = m_recordSerializer.Deserialize(*data);
+              callback(context, threadIndex, record.m_key, record.m_value);
+            }
+          }
+        }
+      }
+    });
+  }
+
+  virtual HashTableStats GetStats(
+      const HashTableStatsOptions& options) const override {
+    return CollectStats(options, 0U);
+  }
+
   virtual const HashTablePerfData& GetPerfData() const override {
     // Synchronizes with any std::memory_order_release if there exists, so that
     // HashTablePerfData has the latest values at the moment when GetPerfData()
@@ -86,20 +196,143 @@ class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
   ReadOnlyHashTable& operator=(const ReadOnlyHashTable&) = delete;
 
  protected:
-  // GetBucketInfo returns a pair, where the first is the index to the bucket
-  // and the second is the tag value for the given key.
-  // In this hash table, we treat tag value of 0 as empty (see
-  // WritableHashTable::Remove()), so in the worst case scenario, where an entry
-  // has an empty data list and the tag value returned for the key is 0, the
-  // look up cost is up to 6 checks. We can do something smarter by using the
-  // unused two bytes per Entry, but since an Entry object fits into CPU cache,
-  // the extra overhead should be minimal.
-  std::pair<std::uint32_t, std::uint8_t> GetBucketInfo(const Key& key) const {
-    std::array<std::uint64_t, 2> hash;
-    MurmurHash3_x64_128(key.m_data, key.m_size, 0U, hash.data());
-
-    return {static_cast<std::uint32_t>(hash[0] % m_hashTable.m_buckets.size()),
-            static_cast<std::uint8_t>(hash[1])};
+  using BucketInfo = HashValue;
+
+  // The number of keys whose lookups are overlapped in MultiGet(). It is bound
+  // by the number of outstanding cache misses a core can track.
+  static constexpr std::size_t c_multiGetGroupSize = 16U;
+
+  // The sequence counter of a record whose value is updated in place, which is
+  // odd while the value is being overwritten.
+  using Sequence = std::atomic<std::uint32_t>;
+
+  // Returns the sequence counter of the record with the given value, which is
+  // placed right after the value, aligned, when the values are updated in
+  // place (see WritableHashTable::CalculateRecordBufferSize()).
+  static Sequence& GetSequence(const Value& value) {
+    return *reinterpret_cast<Sequence*>(Utils::Math::RoundUp(
+        reinterpret_cast<std::uintptr_t>(value.m_data + value.m_size),
+        alignof(Sequence)));
+  }
+
+  // Looks up the given key whose bucket information is already calculated.
+  bool Find(const Key& key, const BucketInfo& bucketInfo, Value& value) const {
+    const auto* entry = &m_hashTable.GetBucket(bucketInfo.first);
+
+    while (entry != nullptr) {
+      for (auto mask = entry->MatchTag(bucketInfo.second); mask != 0U;
+           mask &= mask - 1U) {
+        const auto i = Utils::Math::CountTrailingZeros(mask);
+
+        // There could be a race condition where m_dataList[i] is updated
+        // during access. Therefore, load it once and save it (it's safe to
+        // store it b/c the memory will not be deleted until ref count becomes
+        // 0).
+        const auto data = entry->m_dataList[i].Load(std::memory_order_acquire);
+
+        if (data != nullptr) {
+          if (m_recordSerializer.IsKeyEqual(key, *data)) {
+            value = m_recordSerializer.Deserialize(*data).m_value;
+            return true;
+          }
+
+          OnTagFalsePositive();
+        }
+      }
+
+      entry = entry->m_next.Load(std::memory_order_acquire);
+    }
+
+    return false;
+  }
+
+  // Collects the stats of the sampled buckets (see HashTableStatsOptions) with
+  // the given number of threads, each of which visits a disjoint range of the
+  // buckets. The buckets are read in the same way as the lock-free readers,
+  // thus the writers are not blocked. The given size of the metadata is
+  // excluded from the size of each value.
+  HashTableStats CollectStats(const HashTableStatsOptions& options,
+                              std::size_t metadataSize) const {
+    const auto& buckets = m_hashTable.GetBuckets();
+
+    const auto stride =
+        (options.m_samplingRatio > 0.0 && options.m_samplingRatio < 1.0)
+            ? static_cast<std::size_t>(1.0 / options.m_samplingRatio + 0.5)
+            : 1U;
+    const auto numSampledBuckets = (buckets.size() + stride - 1U) / stride;
+    const auto numThreads = static_cast<std::uint16_t>((std::max)(
+        (std::min)(static_cast<std::size_t>(options.m_numThreads),
+                   numSampledBuckets),
+        static_cast<std::size_t>(1U)));
+
+    std::vector<HashTableStats> stats(numThreads);
+
+    Utils::RunInParallel(numThreads, [&](std::uint16_t threadIndex) {
+      auto& threadStats = stats[threadIndex];
+
+      // The tags of the records in the current chain, which are used to count
+      // the tag false positives.
+      std::vector<std::uint16_t> tags;
+
+      const auto end = numSampledBuckets * (threadIndex + 1U) / numThreads;
+      for (auto i = numSampledBuckets * threadIndex / numThreads; i < end;
+           ++i) {
+        tags.clear();
+        std::size_t chainLength = 0U;
+
+        for (const auto* entry = &buckets[i * stride]; entry != nullptr;
+             entry = entry->m_next.Load(std::memory_order_acquire)) {
+          ++chainLength;
+          std::size_t numOccupiedSlots = 0U;
+
+          for (std::uint8_t j = 0U; j < HashTable::Entry::c_numDataPerEntry;
+               ++j) {
+            const auto data =
+                entry->m_dataList[j].Load(std::memory_order_acquire);
+            if (data == nullptr) {
+              continue;
+            }
+
+            ++numOccupiedSlots;
+
+            const auto tag = entry->m_tags[j];
+            threadStats.m_numTagFalsePositives +=
+                std::count(tags.cbegin(), tags.cend(), tag);
+            tags.push_back(tag);
+
+            const auto record = m_recordSerializer.Deserialize(*data);
+            threadStats.AddRecord(record.m_key.m_size + record.m_value.m_size -
+                                  metadataSize);
+          }
+
+          threadStats.AddEntry(numOccupiedSlots);
+        }
+
+        threadStats.AddBucket(chainLength, tags.empty());
+      }
+    });
+
+    for (std::uint16_t i = 1U; i < numThreads; ++i) {
+      stats[0].Merge(stats[i]);
+    }
+
+    return std::move(stats[0]);
+  }
+
+  // Counts a key comparison that failed although the tag matched.
+  void OnTagFalsePositive() const {
+    m_hashTable.m_perfData.Increment(
+        HashTablePerfCounter::TagFalsePositiveCount);
+  }
+
+  // GetBucketInfo returns a pair, where the first is the hash value that
+  // determines the bucket (see SharedHashTable::GetBucket()) and the second is
+  // the tag value for the given key, computed by the hash function configured in
+  // the setting (see Hasher). Note that the empty slots are tracked by the
+  // occupancy bitmap of an entry, so any 16-bit tag value including 0 is valid.
+  BucketInfo GetBucketInfo(const Key& key) const {
+    return Hasher::Hash(m_hashTable.m_setting.m_hashFunction, key.m_data,
+                        key.m_size);
   }
 
   HashTable& m_hashTable;
@@ -107,15 +340,21 @@ class ReadOnlyHashTable : public virtual IReadOnlyHashTable {
   RecordSerializer m_recordSerializer;
 };
 
+template <typename Allocator, typename RecordFormat, typename BucketMutex>
+constexpr std::size_t ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex>::
+    c_multiGetGroupSize;
+
 // ReadOnlyHashTable::Iterator class implements IIterator interface and provides
 // read-only iterator for the ReadOnlyHashTable.
-template <typename Allocator>
-class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
+template <typename Allocator, typename RecordFormat, typename BucketMutex>
+class ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex>::Iterator
+    : public IIterator {
  public:
   Iterator(const HashTable& hashTable,
            const RecordSerializer& recordDeserializer)
       : m_hashTable{hashTable},
         m_recordSerializer{recordDeserializer},
+        m_buckets{&hashTable.GetBuckets()},
         m_currentBucketIndex{-1},
         m_currentRecordIndex{0U},
         m_currentEntry{nullptr} {}
@@ -123,11 +362,13 @@ class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
   Iterator(Iterator&& iterator)
       : m_hashTable{std::move(iterator.m_hashTable)},
         m_recordSerializer{std::move(iterator.recordDeserializer)},
+        m_buckets{std::move(iterator.m_buckets)},
         m_currentBucketIndex{std::move(iterator.m_currentBucketIndex)},
         m_currentRecordIndex{std::move(iterator.m_currentRecordIndex)},
         m_currentEntry{std::move(iterator.m_currentEntry)} {}
 
   void Reset() override {
+    m_buckets = &m_hashTable.GetBuckets();
     m_currentBucketIndex = -1;
     m_currentRecordIndex = 0U;
     m_currentEntry = nullptr;
@@ -156,7 +397,7 @@ class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
           return false;
         }
 
-        m_currentEntry = &m_hashTable.m_buckets[m_currentBucketIndex];
+        m_currentEntry = &(*m_buckets)[m_currentBucketIndex];
       } else {
         MoveToNextData();
       }
@@ -195,7 +436,7 @@ class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
 
   bool IsEnd() const {
     return m_currentBucketIndex ==
-           static_cast<std::int64_t>(m_hashTable.m_buckets.size());
+           static_cast<std::int64_t>(m_buckets->size());
   }
 
   void MoveToNextData() {
@@ -208,6 +449,10 @@ class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
   const HashTable& m_hashTable;
   const RecordSerializer& m_recordSerializer;
 
+  // The bucket array being iterated, which is fixed when the iteration starts
+  // even if the bucket array is resized during the iteration.
+  const typename HashTable::Buckets* m_buckets;
+
   std::int64_t m_currentBucketIndex;
   std::uint8_t m_currentRecordIndex;
 
@@ -222,138 +467,386 @@ class ReadOnlyHashTable<Allocator>::Iterator : public IIterator {
 
 // WritableHashTable class implements IWritableHashTable interface and also
 // provides the read only access (Get()) to the hash table. Note the virtual
-// inheritance on ReadOnlyHashTable<Allocator> so that any derived class can
-// have only one ReadOnlyHashTable base class instance.
-template <typename Allocator>
-class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
-                          public IWritableHashTable {
+// inheritance on ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex> so
+// that any derived class can have only one ReadOnlyHashTable base class
+// instance.
+template <typename Allocator,
+          typename RecordFormat = VarRecord,
+          typename BucketMutex = Utils::ReaderWriterLockSlim>
+class WritableHashTable
+    : public virtual ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex>,
+      public IWritableHashTable {
  public:
-  using Base = ReadOnlyHashTable<Allocator>;
+  using Base = ReadOnlyHashTable<Allocator, RecordFormat, BucketMutex>;
   using HashTable = typename Base::HashTable;
 
-  WritableHashTable(HashTable& hashTable, IEpochActionManager& epochManager)
-      : Base(hashTable), m_epochManager{epochManager} {}
-
+  WritableHashTable(
+      HashTable& hashTable,
+      IEpochActionManager& epochManager,
+      boost::optional<HashTableConfig::Resize> resize = boost::none)
+      : Base(hashTable), m_epochManager{epochManager}, m_resize{resize} {}
+
+  // If the values are updated in place (see
+  // HashTableConfig::Setting::m_inPlaceUpdates) and the key exists with a
+  // value of the same size, the value is overwritten in the existing record,
+  // so that nothing is allocated or retired. Otherwise, a new record replaces
+  // the existing one.
   virtual void Add(const Key& key, const Value& value) override {
+    if (this->m_hashTable.m_setting.m_inPlaceUpdates &&
+        UpdateInPlace(key, value)) {
+      return;
+    }
+
     Add(CreateRecordBuffer(key, value));
   }
 
   virtual bool Remove(const Key& key) override {
     const auto bucketInfo = this->GetBucketInfo(key);
 
-    auto* entry = &(this->m_hashTable.m_buckets[bucketInfo.first]);
-
     typename HashTable::Lock lock{this->m_hashTable.GetMutex(bucketInfo.first)};
 
-    // Note that similar to Add(), the following block is performed inside a
-    // critical section, therefore, it is safe to do "Load"s with
-    // memory_order_relaxed.
-    while (entry != nullptr) {
-      for (std::uint8_t i = 0; i < HashTable::Entry::c_numDataPerEntry; ++i) {
-        if (bucketInfo.second == entry->m_tags[i]) {
-          const auto data =
-              entry->m_dataList[i].Load(std::memory_order_relaxed);
-
-          if (data != nullptr) {
-            const auto record = this->m_recordSerializer.Deserialize(*data);
-            if (record.m_key == key) {
-              Remove(*entry, i);
-              return true;
-            }
-          }
+    std::uint8_t index = 0U;
+    auto* entry = FindEntryForRemove(key, bucketInfo, index);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    Remove(*entry, index);
+    return true;
+  }
+
+  // Produces the new value under the lock guarding the key, so that the
+  // chain is walked once and the concurrent Upsert()s of the same key are
+  // serialized. The merge operator writes the new value directly to the
+  // record allocated for it.
+  virtual void Upsert(const Key& key,
+                      const Value& operand,
+                      const IMergeOperator& mergeOperator) override {
+    UpsertRecord(key, [&](const RecordBuffer* existingRecord) {
+      if (existingRecord == nullptr) {
+        return CreateMergedRecordBuffer(key, nullptr, operand, mergeOperator,
+                                        0U);
+      }
+
+      const auto existingValue =
+          this->m_recordSerializer.Deserialize(*existingRecord).m_value;
+      return CreateMergedRecordBuffer(key, &existingValue, operand,
+                                      mergeOperator, 0U);
+    });
+  }
+
+  // Adds the records in the batch, grouping them by the mutex so that each
+  // mutex is taken once for all the records guarded by it. The perf counters
+  // are updated once for the batch and the replaced records are released by a
+  // single epoch action.
+  virtual void AddBatch(const KeyValue* records,
+                        std::size_t numRecords) override {
+    AddRecords(records, numRecords, 1U, false);
+
+    if (m_resize) {
+      ResizeIfNeeded(numRecords);
+    }
+  }
+
+  // Removes the keys in the batch in the same way as AddBatch().
+  virtual std::size_t RemoveBatch(const Key* keys,
+                                  std::size_t numKeys,
+                                  bool* removed) override {
+    auto itemsPerThread = GroupByMutex(
+        numKeys, 1U, [keys](std::size_t i) -> const Key& { return keys[i]; });
+
+    std::vector<BatchStat> stats(1U);
+    std::vector<std::vector<RecordBuffer*>> recordsToRelease(1U);
+    std::size_t numRemoved = 0U;
+
+    ForEachMutexGroup(itemsPerThread[0], [&](BatchItemIterator begin,
+                                             BatchItemIterator end) {
+      typename HashTable::Lock lock{
+          this->m_hashTable.m_mutexes[begin->m_mutexIndex]};
+
+      for (auto it = begin; it != end; ++it) {
+        std::uint8_t index = 0U;
+        auto* entry =
+            FindEntryForRemove(keys[it->m_index], it->m_bucketInfo, index);
+
+        if (removed != nullptr) {
+          removed[it->m_index] = (entry != nullptr);
+        }
+
+        if (entry != nullptr) {
+          auto* recordToDelete = UpdateRecord(*entry, index, nullptr, 0U);
+          const auto record =
+              this->m_recordSerializer.Deserialize(*recordToDelete);
+
+          stats[0].Remove(
+              Stat{record.m_key.m_size, record.m_value.m_size, 0U},
+              this->m_recordSerializer.CalculateRecordOverhead());
+          recordsToRelease[0].push_back(recordToDelete);
+          ++numRemoved;
         }
       }
+    });
 
-      entry = entry->m_next.Load(std::memory_order_relaxed);
+    UpdatePerfDataForBatch(stats, recordsToRelease);
+
+    return numRemoved;
+  }
+
+  // Loads the records with the given number of threads. The keys are hashed
+  // and grouped by the mutex guarding them, and each group is loaded by one
+  // thread, which takes the mutex once for all the records in the group. The
+  // perf counters are aggregated by each thread and updated once at the end,
+  // and the records replaced by the duplicate keys are released by a single
+  // epoch action. If resize is configured, the bucket array is grown up front
+  // for the records to be loaded.
+  virtual void BulkLoad(const KeyValue* records,
+                        std::size_t numRecords,
+                        const BulkLoadOptions& options) override {
+    if (m_resize) {
+      GrowForBulkLoad(numRecords);
     }
 
-    return false;
+    AddRecords(records, numRecords, options.m_numThreads,
+               options.m_skipDuplicateCheck);
+
+    if (m_resize) {
+      ResizeIfNeeded();
+    }
   }
 
   virtual ISerializerPtr GetSerializer() const override {
     return std::make_unique<WritableHashTable::Serializer>(this->m_hashTable);
   }
 
- protected:
-  void Add(RecordBuffer* recordToAdd) {
-    assert(recordToAdd != nullptr);
+  // Starts resizing the bucket array to twice the number of buckets if it is
+  // not being resized yet. Returns true if the bucket array is being resized
+  // after the call. Note that the buckets are migrated by MigrateBuckets(),
+  // which the writers call for each Add() if resize is configured, and which
+  // can be also called from a background thread.
+  bool StartResize() {
+    std::unique_lock<typename HashTable::Mutex> resizeLock{
+        this->m_hashTable.m_resizeMutex, std::try_to_lock};
+    if (!resizeLock.owns_lock() || this->m_hashTable.IsResizing()) {
+      return this->m_hashTable.IsResizing();
+    }
 
-    const auto newRecord = this->m_recordSerializer.Deserialize(*recordToAdd);
-    const auto& newKey = newRecord.m_key;
-    const auto& newValue = newRecord.m_value;
+    const std::uint64_t newNumBuckets =
+        this->m_hashTable.GetBuckets().size() * 2U;
+    if (newNumBuckets > (std::numeric_limits<std::uint32_t>::max)()) {
+      return false;
+    }
 
-    Stat stat{newKey.m_size, newValue.m_size};
+    auto& hashTable = this->m_hashTable;
 
-    const auto bucketInfo = this->GetBucketInfo(newKey);
+    hashTable.m_maxMigratedBucketChainLength = 1U;
+    hashTable.m_numMigratedBuckets.store(0U, std::memory_order_relaxed);
+    hashTable.m_newBuckets.Store(hashTable.CreateBuckets(newNumBuckets),
+                                 std::memory_order_release);
 
-    auto* curEntry = &(this->m_hashTable.m_buckets[bucketInfo.first]);
+    hashTable.m_perfData.Add(HashTablePerfCounter::TotalIndexSize,
+                             newNumBuckets * sizeof(typename HashTable::Entry));
 
-    typename HashTable::Entry* entryToUpdate = nullptr;
-    std::uint8_t curDataIndex = 0U;
+    return true;
+  }
 
-    typename HashTable::UniqueLock lock{
-        this->m_hashTable.GetMutex(bucketInfo.first)};
+  // Migrates up to the given number of buckets from the current bucket array to
+  // the new one, and completes the resize once all the buckets are migrated.
+  // Each bucket is migrated under its mutex. If another thread is migrating,
+  // this returns right away. Returns true if the bucket array is still being
+  // resized after the call.
+  bool MigrateBuckets(std::uint32_t maxNumBuckets) {
+    std::unique_lock<typename HashTable::Mutex> resizeLock{
+        this->m_hashTable.m_resizeMutex, std::try_to_lock};
+    if (!resizeLock.owns_lock()) {
+      return this->m_hashTable.IsResizing();
+    }
 
-    // Note that the following block is performed inside a critical section,
-    // therefore, it is safe to do "Load"s with memory_order_relaxed.
-    while (curEntry != nullptr) {
-      ++stat.m_chainIndex;
+    auto& hashTable = this->m_hashTable;
 
-      for (std::uint8_t i = 0; i < HashTable::Entry::c_numDataPerEntry; ++i) {
-        const auto data =
-            curEntry->m_dataList[i].Load(std::memory_order_relaxed);
+    auto* newBuckets = hashTable.m_newBuckets.Load(std::memory_order_relaxed);
+    if (newBuckets == nullptr) {
+      return false;
+    }
 
-        if (data == nullptr) {
-          if (entryToUpdate == nullptr) {
-            // Found an entry with no data set, but still need to go through the
-            // end of the list to see if an entry with the given key exists.
-            entryToUpdate = curEntry;
-            curDataIndex = i;
-          }
-        } else if (curEntry->m_tags[i] == bucketInfo.second) {
-          const auto oldRecord = this->m_recordSerializer.Deserialize(*data);
-          if (newKey == oldRecord.m_key) {
-            // Will overwrite this entry data.
-            entryToUpdate = curEntry;
-            curDataIndex = i;
-            stat.m_oldValueSize = oldRecord.m_value.m_size;
-            break;
-          }
-        }
-      }
+    auto& buckets = hashTable.GetBuckets();
 
-      // Found the entry data to replaces.
-      if (stat.m_oldValueSize != 0U) {
-        break;
-      }
+    auto index = hashTable.m_numMigratedBuckets.load(std::memory_order_relaxed);
+    const auto endIndex = (std::min)(index + maxNumBuckets,
+                                     static_cast<std::uint64_t>(buckets.size()));
 
-      // Check if this is the end of the chaining. If so, create a new entry if
-      // we haven't found any entry to update along the way.
-      if (entryToUpdate == nullptr &&
-          curEntry->m_next.Load(std::memory_order_relaxed) == nullptr) {
-        curEntry->m_next.Store(
-            new (Detail::to_raw_pointer(
-                this->m_hashTable
-                    .template GetAllocator<typename HashTable::Entry>()
-                    .allocate(1U))) typename HashTable::Entry(),
-            std::memory_order_release);
+    for (; index < endIndex; ++index) {
+      typename HashTable::Lock lock{
+          hashTable.GetBucketMutex(index, buckets.size())};
 
-        stat.m_isNewEntryAdded = true;
+      MigrateBucket(buckets[index], *newBuckets);
+
+      // Writers start updating the new bucket (and mirroring to the current
+      // one) once this is visible.
+      hashTable.m_numMigratedBuckets.store(index + 1U,
+                                           std::memory_order_release);
+    }
+
+    if (index < buckets.size()) {
+      return true;
+    }
+
+    CompleteResize(buckets, *newBuckets);
+
+    return false;
+  }
+
+  // Compacts the chains of up to the given number of buckets (see
+  // CompactBucket()), continuing from the bucket where the previous call
+  // stopped. Since it holds m_resizeMutex, nothing is compacted while the
+  // bucket array is being resized, and the resize is not started or migrated
+  // while compacting. Once all the buckets are compacted, MaxBucketChainLength
+  // is set to the longest chain seen, which may miss the chains grown by the
+  // concurrent writers in the buckets already visited; the next Add() to such
+  // a chain corrects it. The released entries are retired through the epoch
+  // manager, thus the caller should be in an epoch.
+  virtual std::size_t Compact(std::uint32_t maxNumBuckets) override {
+    auto& hashTable = this->m_hashTable;
+
+    std::unique_lock<typename HashTable::Mutex> resizeLock{
+        hashTable.m_resizeMutex, std::try_to_lock};
+    if (!resizeLock.owns_lock() || hashTable.IsResizing()) {
+      return 0U;
+    }
+
+    auto& buckets = hashTable.GetBuckets();
+    auto& compaction = m_compaction;
+
+    if (compaction.m_buckets != &buckets ||
+        compaction.m_bucketIndex >= buckets.size()) {
+      compaction = Compaction{};
+      compaction.m_buckets = &buckets;
+    }
+
+    std::vector<typename HashTable::Entry*> entriesToRelease;
+
+    for (std::uint32_t i = 0U; i < maxNumBuckets; ++i) {
+      const auto index = compaction.m_bucketIndex;
+
+      std::uint32_t chainLength = 0U;
+      {
+        typename HashTable::Lock lock{
+            hashTable.GetBucketMutex(index, buckets.size())};
+
+        chainLength = CompactBucket(buckets[index], entriesToRelease);
       }
 
-      curEntry = curEntry->m_next.Load(std::memory_order_relaxed);
+      compaction.m_maxChainLength =
+          (std::max)(compaction.m_maxChainLength, chainLength);
+
+      if (++compaction.m_bucketIndex == buckets.size()) {
+        hashTable.m_perfData.Set(HashTablePerfCounter::MaxBucketChainLength,
+                                 compaction.m_maxChainLength);
+        compaction = Compaction{};
+        compaction.m_buckets = &buckets;
+      }
     }
 
-    assert(entryToUpdate != nullptr);
+    const auto numReleased = entriesToRelease.size();
+
+    auto& perfData = hashTable.m_perfData;
+    perfData.Subtract(HashTablePerfCounter::ChainingEntriesCount, numReleased);
+    perfData.Subtract(HashTablePerfCounter::TotalIndexSize,
+                      numReleased * sizeof(typename HashTable::Entry));
+
+    ReleaseEntries(std::move(entriesToRelease));
+
+    return numReleased;
+  }
 
-    auto recordToDelete = UpdateRecord(*entryToUpdate, curDataIndex,
-                                       recordToAdd, bucketInfo.second);
+ protected:
+  void Add(RecordBuffer* recordToAdd) {
+    assert(recordToAdd != nullptr);
+
+    UpsertRecord(this->m_recordSerializer.Deserialize(*recordToAdd).m_key,
+                 [recordToAdd](const RecordBuffer*) { return recordToAdd; });
+  }
+
+  // Adds the record returned by createRecord(existingRecord) for the given
+  // key, replacing the existing record if any (otherwise, existingRecord is
+  // nullptr). createRecord() is called under the lock guarding the key after
+  // the chain is walked once, so that the new record can be made from the
+  // existing one atomically. The key of the new record should be the given
+  // key, which should stay valid until this returns.
+  template <typename CreateRecord>
+  void UpsertRecord(const Key& key, const CreateRecord& createRecord) {
+    Stat stat{key.m_size};
+
+    const auto bucketInfo = this->GetBucketInfo(key);
+
+    typename HashTable::UniqueLock lock{
+        this->m_hashTable.GetMutex(bucketInfo.first)};
+
+    const auto buckets =
+        this->m_hashTable.GetBucketsForWrite(bucketInfo.first);
+
+    RecordBuffer* recordToAdd = nullptr;
+    auto recordToDelete =
+        AddToBucket(*buckets.first, key, bucketInfo.second, stat,
+                    [&](const RecordBuffer* existingRecord) {
+                      recordToAdd = createRecord(existingRecord);
+                      stat.m_valueSize = this->m_recordSerializer
+                                             .Deserialize(*recordToAdd)
+                                             .m_value.m_size;
+                      return recordToAdd;
+                    });
+
+    if (buckets.second != nullptr) {
+      // Mirror the update to the current bucket array being resized so that
+      // the lock-free readers still find the record there.
+      Stat mirroredStat{key.m_size, stat.m_valueSize};
+      AddToBucket(*buckets.second, recordToAdd, key, bucketInfo.second,
+                  mirroredStat);
+
+      if (mirroredStat.m_isNewEntryAdded) {
+        UpdatePerfDataForNewEntry();
+      }
+    }
 
     lock.unlock();
 
     UpdatePerfDataForAdd(stat);
 
     ReleaseRecord(recordToDelete);
+
+    if (m_resize) {
+      ResizeIfNeeded();
+    }
+  }
+
+  // Creates the record of the given key whose value is written by the given
+  // merge operator (see IMergeOperator) after the given size of the metadata,
+  // which is left to the caller.
+  RecordBuffer* CreateMergedRecordBuffer(const Key& key,
+                                         const Value* existingValue,
+                                         const Value& operand,
+                                         const IMergeOperator& mergeOperator,
+                                         std::size_t metadataSize) {
+    const auto valueSize = mergeOperator.GetMergedSize(existingValue, operand);
+    const auto bufferSize = CalculateRecordBufferSize(key, valueSize);
+
+    auto allocator = this->m_hashTable.template GetAllocator<std::uint8_t>();
+    auto buffer = Detail::to_raw_pointer(allocator.allocate(bufferSize));
+
+    try {
+      auto* record = this->m_recordSerializer.SerializeKey(key, valueSize,
+                                                           buffer, bufferSize);
+      InitializeSequence(*record);
+      mergeOperator.Merge(
+          existingValue, operand,
+          const_cast<std::uint8_t*>(
+              this->m_recordSerializer.Deserialize(*record).m_value.m_data) +
+              metadataSize);
+
+      return record;
+    } catch (...) {
+      allocator.deallocate(buffer, bufferSize);
+      throw;
+    }
   }
 
   // The chainIndex is the 1-based index for the given entry in the chained
@@ -374,22 +867,676 @@ class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
  private:
   struct Stat;
 
+  struct BatchStat;
+
   class Serializer;
 
+  // BatchItem struct represents a key in a batch operation.
+  struct BatchItem {
+    typename Base::BucketInfo m_bucketInfo;
+    std::size_t m_mutexIndex;
+
+    // The index of the key in the batch.
+    std::size_t m_index;
+  };
+
+  using BatchItems = std::vector<BatchItem>;
+  using BatchItemIterator = typename BatchItems::const_iterator;
+
+  // Compaction struct keeps where Compact() stopped in the bucket array, which
+  // is guarded by m_resizeMutex.
+  struct Compaction {
+    const typename HashTable::Buckets* m_buckets = nullptr;
+    std::uint64_t m_bucketIndex = 0U;
+
+    // The longest chain seen in the buckets compacted so far.
+    std::uint32_t m_maxChainLength = 1U;
+
+    // The chained entries of the bucket being compacted, which is kept to
+    // reuse the memory.
+    std::vector<typename HashTable::Entry*> m_entries;
+  };
+
+  // Adds the records with the given number of threads. The keys are hashed
+  // and grouped by the mutex guarding them, and each group is added by one
+  // thread, which takes the mutex once for all the records in the group. The
+  // perf counters are aggregated by each thread and updated once at the end,
+  // and the records replaced by the duplicate keys are released by a single
+  // epoch action.
+  void AddRecords(const KeyValue* records,
+                  std::size_t numRecords,
+                  std::uint16_t numThreads,
+                  bool skipDuplicateCheck) {
+    numThreads = static_cast<std::uint16_t>((std::max)(
+        (std::min)(static_cast<std::size_t>(numThreads),
+                   this->m_hashTable.m_mutexes.size()),
+        static_cast<std::size_t>(1U)));
+
+    const auto itemsPerThread = GroupByMutex(
+        numRecords, numThreads,
+        [records](std::size_t i) -> const Key& { return records[i].m_key; });
+
+    std::vector<BatchStat> stats(numThreads);
+    std::vector<std::vector<RecordBuffer*>> recordsToRelease(numThreads);
+
+    Utils::RunInParallel(numThreads, [&](std::uint16_t threadIndex) {
+      std::vector<RecordBuffer*> recordBuffers;
+
+      const auto addGroup = [&](BatchItemIterator begin,
+                                BatchItemIterator end) {
+        // The record buffers are allocated before taking the mutex.
+        recordBuffers.clear();
+        for (auto it = begin; it != end; ++it) {
+          const auto& record = records[it->m_index];
+          recordBuffers.push_back(
+              CreateRecordBuffer(record.m_key, record.m_value));
+        }
+
+        typename HashTable::Lock lock{
+            this->m_hashTable.m_mutexes[begin->m_mutexIndex]};
+
+        for (auto it = begin; it != end; ++it) {
+          auto* recordToDelete = AddBatchRecord(
+              records[it->m_index], it->m_bucketInfo,
+              recordBuffers[it - begin], skipDuplicateCheck,
+              stats[threadIndex]);
+          if (recordToDelete != nullptr) {
+            recordsToRelease[threadIndex].push_back(recordToDelete);
+          }
+        }
+      };
+
+      ForEachMutexGroup(itemsPerThread[threadIndex], addGroup);
+    });
+
+    UpdatePerfDataForBatch(stats, recordsToRelease);
+  }
+
+  // Hashes the given number of keys with the given number of threads, where
+  // getKey(i) returns the i-th key, and returns the items for each thread. The
+  // items are partitioned by the mutex guarding the keys, so that the keys
+  // guarded by the same mutex go to the same thread, and sorted by the mutex,
+  // keeping the order in the batch for the same mutex.
+  template <typename GetKey>
+  std::vector<BatchItems> GroupByMutex(std::size_t numKeys,
+                                       std::uint16_t numThreads,
+                                       const GetKey& getKey) const {
+    // Each thread hashes a range of the keys and partitions them by the
+    // thread that handles them.
+    std::vector<std::vector<BatchItems>> partitions(
+        numThreads, std::vector<BatchItems>(numThreads));
+
+    Utils::RunInParallel(numThreads, [&](std::uint16_t threadIndex) {
+      auto& partition = partitions[threadIndex];
+      const auto end = numKeys * (threadIndex + 1U) / numThreads;
+
+      for (auto i = numKeys * threadIndex / numThreads; i < end; ++i) {
+        const auto bucketInfo = this->GetBucketInfo(getKey(i));
+        const auto mutexIndex =
+            this->m_hashTable.GetMutexIndex(bucketInfo.first);
+        partition[mutexIndex % numThreads].push_back(
+            BatchItem{bucketInfo, mutexIndex, i});
+      }
+    });
+
+    std::vector<BatchItems> itemsPerThread(numThreads);
+
+    Utils::RunInParallel(numThreads, [&](std::uint16_t threadIndex) {
+      auto& items = itemsPerThread[threadIndex];
+      for (auto& partition : partitions) {
+        auto& part = partition[threadIndex];
+        items.insert(items.end(), part.begin(), part.end());
+        BatchItems().swap(part);
+      }
+
+      // The order in the batch is kept for the same key so that the last one
+      // wins.
+      std::stable_sort(items.begin(), items.end(),
+                       [](const BatchItem& left, const BatchItem& right) {
+                         return left.m_mutexIndex < right.m_mutexIndex;
+                       });
+    });
+
+    return itemsPerThread;
+  }
+
+  // Calls func(begin, end) for each range of the given items (sorted by
+  // GroupByMutex()) that are guarded by the same mutex.
+  template <typename Func>
+  static void ForEachMutexGroup(const BatchItems& items, const Func& func) {
+    for (auto begin = items.cbegin(); begin != items.cend();) {
+      const auto end =
+          std::find_if(begin, items.cend(), [begin](const BatchItem& item) {
+            return item.m_mutexIndex != begin->m_mutexIndex;
+          });
+
+      func(begin, end);
+
+      begin = end;
+    }
+  }
+
   RecordBuffer* CreateRecordBuffer(const Key& key, const Value& value) {
-    const auto bufferSize =
-        this->m_recordSerializer.CalculateBufferSize(key, value);
+    const auto bufferSize = CalculateRecordBufferSize(key, value.m_size);
     auto buffer = Detail::to_raw_pointer(
         this->m_hashTable.template GetAllocator<std::uint8_t>().allocate(
             bufferSize));
 
-    return this->m_recordSerializer.Serialize(key, value, buffer, bufferSize);
+    auto* record =
+        this->m_recordSerializer.Serialize(key, value, buffer, bufferSize);
+    InitializeSequence(*record);
+
+    return record;
+  }
+
+  // Returns the size of the buffer for the record of the given key and value
+  // size, which has room for the sequence counter (see
+  // ReadOnlyHashTable::GetSequence()) if the values are updated in place.
+  std::size_t CalculateRecordBufferSize(const Key& key,
+                                        Value::size_type valueSize) const {
+    const auto bufferSize = this->m_recordSerializer.CalculateBufferSize(
+        key, Value{nullptr, valueSize});
+
+    return this->m_hashTable.m_setting.m_inPlaceUpdates
+               ? bufferSize + sizeof(typename Base::Sequence) +
+                     alignof(typename Base::Sequence) - 1U
+               : bufferSize;
+  }
+
+  // Constructs the sequence counter of the given record if the values are
+  // updated in place.
+  void InitializeSequence(const RecordBuffer& record) {
+    if (this->m_hashTable.m_setting.m_inPlaceUpdates) {
+      new (&this->GetSequence(this->m_recordSerializer.Deserialize(record)
+                                  .m_value)) typename Base::Sequence{0U};
+    }
+  }
+
+  // Overwrites the value of the given key in place if the key exists with a
+  // value of the same size, and returns false otherwise. The sequence counter
+  // of the record is odd while the value is overwritten, so that the readers
+  // in GetCopy() retry. While resizing, the record is shared with the bucket
+  // in the current bucket array, thus both see the new value.
+  bool UpdateInPlace(const Key& key, const Value& value) {
+    const auto bucketInfo = this->GetBucketInfo(key);
+
+    typename HashTable::Lock lock{this->m_hashTable.GetMutex(bucketInfo.first)};
+
+    const auto buckets =
+        this->m_hashTable.GetBucketsForWrite(bucketInfo.first);
+
+    std::uint8_t index = 0U;
+    const auto* entry =
+        FindEntry(*buckets.first, key, bucketInfo.second, index);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    const auto existingValue =
+        this->m_recordSerializer
+            .Deserialize(*entry->m_dataList[index].Load(
+                std::memory_order_relaxed))
+            .m_value;
+    if (existingValue.m_size != value.m_size) {
+      return false;
+    }
+
+    auto& sequence = this->GetSequence(existingValue);
+    const auto version = sequence.load(std::memory_order_relaxed);
+
+    sequence.store(version + 1U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(const_cast<std::uint8_t*>(existingValue.m_data), value.m_data,
+           value.m_size);
+
+    sequence.store(version + 2U, std::memory_order_release);
+
+    return true;
+  }
+
+  typename HashTable::Entry* CreateEntry() {
+    return new (Detail::to_raw_pointer(
+        this->m_hashTable.template GetAllocator<typename HashTable::Entry>()
+            .allocate(1U))) typename HashTable::Entry();
+  }
+
+  // Adds the given record to the chained entries of the given bucket. If the
+  // record with the same key exists, it is replaced and the old record is
+  // returned. It is assumed that this function is called under a lock.
+  RecordBuffer* AddToBucket(typename HashTable::Entry& bucket,
+                            RecordBuffer* recordToAdd,
+                            const Key& newKey,
+                            std::uint16_t tag,
+                            Stat& stat) {
+    return AddToBucket(bucket, newKey, tag, stat,
+                       [recordToAdd](const RecordBuffer*) {
+                         return recordToAdd;
+                       });
+  }
+
+  // Adds the record returned by createRecord(existingRecord) to the chained
+  // entries of the given bucket in the same way as above, where existingRecord
+  // is the record with the same key if any. Since a new entry is added only
+  // after createRecord() returns, nothing is changed if it throws.
+  template <typename CreateRecord>
+  RecordBuffer* AddToBucket(typename HashTable::Entry& bucket,
+                            const Key& newKey,
+                            std::uint16_t tag,
+                            Stat& stat,
+                            const CreateRecord& createRecord) {
+    auto* curEntry = &bucket;
+
+    typename HashTable::Entry* entryToUpdate = nullptr;
+    std::uint8_t curDataIndex = 0U;
+    const RecordBuffer* existingRecord = nullptr;
+
+    // Note that the following block is performed inside a critical section,
+    // therefore, it is safe to do "Load"s with memory_order_relaxed.
+    while (true) {
+      ++stat.m_chainIndex;
+
+      if (entryToUpdate == nullptr) {
+        const auto emptyIndex = FindEmptySlot(*curEntry);
+        if (emptyIndex != HashTable::Entry::c_numDataPerEntry) {
+          // Found an entry with no data set, but still need to go through the
+          // end of the list to see if an entry with the given key exists.
+          entryToUpdate = curEntry;
+          curDataIndex = emptyIndex;
+        }
+      }
+
+      for (auto mask = curEntry->MatchTag(tag); mask != 0U; mask &= mask - 1U) {
+        const auto i = Utils::Math::CountTrailingZeros(mask);
+        const auto data =
+            curEntry->m_dataList[i].Load(std::memory_order_relaxed);
+
+        if (data != nullptr) {
+          if (this->m_recordSerializer.IsKeyEqual(newKey, *data)) {
+            // Will overwrite this entry data.
+            entryToUpdate = curEntry;
+            curDataIndex = static_cast<std::uint8_t>(i);
+            existingRecord = data;
+            stat.m_oldValueSize =
+                this->m_recordSerializer.Deserialize(*data).m_value.m_size;
+            break;
+          }
+
+          this->OnTagFalsePositive();
+        }
+      }
+
+      // Found the entry data to replaces, or reached the end of the chaining.
+      if (existingRecord != nullptr ||
+          curEntry->m_next.Load(std::memory_order_relaxed) == nullptr) {
+        break;
+      }
+
+      curEntry = curEntry->m_next.Load(std::memory_order_relaxed);
+    }
+
+    auto* recordToAdd = createRecord(existingRecord);
+
+    // Create a new entry at the end of the chaining if we haven't found any
+    // entry to update along the way.
+    if (entryToUpdate == nullptr) {
+      entryToUpdate = CreateEntry();
+      curEntry->m_next.Store(entryToUpdate, std::memory_order_release);
+      curDataIndex = 0U;
+
+      ++stat.m_chainIndex;
+      stat.m_isNewEntryAdded = true;
+    }
+
+    return UpdateRecord(*entryToUpdate, curDataIndex, recordToAdd, tag);
+  }
+
+  // Places the given record in the first empty slot in the chained entries of
+  // the given bucket without looking for the same key, adding a new entry if
+  // all the entries are full. It is assumed that this function is called under
+  // a lock.
+  void AppendToBucket(typename HashTable::Entry& bucket,
+                      RecordBuffer* recordToAdd,
+                      std::uint16_t tag,
+                      Stat& stat) {
+    auto* entry = &bucket;
+    auto emptyIndex = FindEmptySlot(*entry);
+    stat.m_chainIndex = 1U;
+
+    while (emptyIndex == HashTable::Entry::c_numDataPerEntry) {
+      if (entry->m_next.Load(std::memory_order_relaxed) == nullptr) {
+        entry->m_next.Store(CreateEntry(), std::memory_order_release);
+        stat.m_isNewEntryAdded = true;
+      }
+
+      entry = entry->m_next.Load(std::memory_order_relaxed);
+      emptyIndex = FindEmptySlot(*entry);
+      ++stat.m_chainIndex;
+    }
+
+    UpdateRecord(*entry, emptyIndex, recordToAdd, tag);
+  }
+
+  // Adds the given record in a batch, whose buffer is already created, and
+  // returns the replaced record if any. It is assumed that this function is
+  // called under the mutex for the key.
+  RecordBuffer* AddBatchRecord(const KeyValue& record,
+                               const typename Base::BucketInfo& bucketInfo,
+                               RecordBuffer* recordToAdd,
+                               bool skipDuplicateCheck,
+                               BatchStat& batchStat) {
+    const auto buckets =
+        this->m_hashTable.GetBucketsForWrite(bucketInfo.first);
+
+    Stat stat{record.m_key.m_size, record.m_value.m_size};
+    RecordBuffer* recordToDelete = nullptr;
+
+    if (skipDuplicateCheck && buckets.second == nullptr) {
+      AppendToBucket(*buckets.first, recordToAdd, bucketInfo.second, stat);
+    } else {
+      recordToDelete = AddToBucket(*buckets.first, recordToAdd, record.m_key,
+                                   bucketInfo.second, stat);
+
+      if (buckets.second != nullptr) {
+        // See Add() for mirroring the update while resizing.
+        Stat mirroredStat{record.m_key.m_size, record.m_value.m_size};
+        AddToBucket(*buckets.second, recordToAdd, record.m_key,
+                    bucketInfo.second, mirroredStat);
+
+        if (mirroredStat.m_isNewEntryAdded) {
+          UpdatePerfDataForNewEntry();
+        }
+      }
+    }
+
+    batchStat.Add(stat, this->m_recordSerializer.CalculateRecordOverhead());
+
+    return recordToDelete;
+  }
+
+  // Grows the bucket array up front so that the load factor stays under the
+  // configured one after loading the given number of records, instead of
+  // resizing incrementally during the load. The resize in progress, if any, is
+  // completed first.
+  void GrowForBulkLoad(std::size_t numRecords) {
+    if (m_resize->m_maxLoadFactor <= 0.0) {
+      return;
+    }
+
+    const auto numRecordsAfterLoad =
+        this->m_hashTable.m_perfData.Get(HashTablePerfCounter::RecordsCount) +
+        numRecords;
+
+    while (true) {
+      while (MigrateBuckets((std::numeric_limits<std::uint32_t>::max)())) {
+        std::this_thread::yield();
+      }
+
+      if (numRecordsAfterLoad <= m_resize->m_maxLoadFactor *
+                                     this->m_hashTable.GetBuckets().size() ||
+          !StartResize()) {
+        return;
+      }
+    }
+  }
+
+  // Returns the entry in the given bucket that contains the record with the
+  // given key and sets its index to "index". Returns nullptr if not found. It
+  // is assumed that this function is called under a lock.
+  typename HashTable::Entry* FindEntry(typename HashTable::Entry& bucket,
+                                       const Key& key,
+                                       std::uint16_t tag,
+                                       std::uint8_t& index) const {
+    auto* entry = &bucket;
+
+    // Note that similar to Add(), the following block is performed inside a
+    // critical section, therefore, it is safe to do "Load"s with
+    // memory_order_relaxed.
+    while (entry != nullptr) {
+      for (auto mask = entry->MatchTag(tag); mask != 0U; mask &= mask - 1U) {
+        const auto i =
+            static_cast<std::uint8_t>(Utils::Math::CountTrailingZeros(mask));
+        const auto data = entry->m_dataList[i].Load(std::memory_order_relaxed);
+
+        if (data != nullptr) {
+          if (this->m_recordSerializer.IsKeyEqual(key, *data)) {
+            index = i;
+            return entry;
+          }
+
+          this->OnTagFalsePositive();
+        }
+      }
+
+      entry = entry->m_next.Load(std::memory_order_relaxed);
+    }
+
+    return nullptr;
+  }
+
+  // Returns the entry that contains the record with the given key to remove
+  // and sets its index to "index". While resizing, the record is shared with
+  // the bucket in the current bucket array being resized, so it is unlinked
+  // from there. It is assumed that this function is called under a lock.
+  typename HashTable::Entry* FindEntryForRemove(
+      const Key& key,
+      const typename Base::BucketInfo& bucketInfo,
+      std::uint8_t& index) {
+    const auto buckets =
+        this->m_hashTable.GetBucketsForWrite(bucketInfo.first);
+
+    auto* entry = FindEntry(*buckets.first, key, bucketInfo.second, index);
+
+    if (entry != nullptr && buckets.second != nullptr) {
+      std::uint8_t mirroredIndex = 0U;
+      auto* mirroredEntry =
+          FindEntry(*buckets.second, key, bucketInfo.second, mirroredIndex);
+      if (mirroredEntry != nullptr) {
+        UpdateRecord(*mirroredEntry, mirroredIndex, nullptr, 0U);
+      }
+    }
+
+    return entry;
+  }
+
+  // Returns the index of the first empty slot in the given entry, or
+  // c_numDataPerEntry if there is none.
+  static std::uint8_t FindEmptySlot(const typename HashTable::Entry& entry) {
+    const auto mask = entry.MatchEmpty();
+
+    return (mask != 0U) ? static_cast<std::uint8_t>(
+                              Utils::Math::CountTrailingZeros(mask))
+                        : HashTable::Entry::c_numDataPerEntry;
+  }
+
+  // Starts resizing if the load factor or the max bucket chain length goes
+  // above the configured thresholds, and migrates the buckets if resizing.
+  // The number of buckets migrated is proportional to the given number of the
+  // records added.
+  void ResizeIfNeeded(std::size_t numRecordsAdded = 1U) {
+    const auto& perfData = this->m_hashTable.m_perfData;
+
+    if (!this->m_hashTable.IsResizing()) {
+      const auto numRecords = perfData.Get(HashTablePerfCounter::RecordsCount);
+      const auto numBuckets = perfData.Get(HashTablePerfCounter::BucketsCount);
+      const auto maxBucketChainLength =
+          perfData.Get(HashTablePerfCounter::MaxBucketChainLength);
+
+      const bool isOverLoadFactor =
+          (m_resize->m_maxLoadFactor > 0.0) &&
+          (numRecords > m_resize->m_maxLoadFactor * numBuckets);
+      const bool isOverChainLength =
+          (m_resize->m_maxBucketChainLength != 0U) &&
+          (maxBucketChainLength > m_resize->m_maxBucketChainLength);
+
+      if (!(isOverLoadFactor || isOverChainLength) || !StartResize()) {
+        return;
+      }
+    }
+
+    MigrateBuckets(static_cast<std::uint32_t>((std::min)(
+        m_resize->m_numBucketsToMigratePerAdd * numRecordsAdded,
+        static_cast<std::size_t>(
+            (std::numeric_limits<std::uint32_t>::max)()))));
+  }
+
+  // Moves all the records in the given bucket to the new bucket array. Note
+  // that the records are not removed from the given bucket so that the
+  // lock-free readers, which look up the current bucket array, still find
+  // them. It is assumed that this function is called under a lock.
+  void MigrateBucket(typename HashTable::Entry& bucket,
+                     typename HashTable::Buckets& newBuckets) {
+    auto& hashTable = this->m_hashTable;
+
+    for (auto* entry = &bucket; entry != nullptr;
+         entry = entry->m_next.Load(std::memory_order_relaxed)) {
+      for (std::uint8_t i = 0; i < HashTable::Entry::c_numDataPerEntry; ++i) {
+        const auto data = entry->m_dataList[i].Load(std::memory_order_relaxed);
+        if (data == nullptr) {
+          continue;
+        }
+
+        const auto hash = this->GetBucketInfo(
+                                  this->m_recordSerializer.Deserialize(*data)
+                                      .m_key)
+                              .first;
+
+        // The new bucket is not visible to anyone until the migration of the
+        // bucket is published, so the first empty slot is simply taken.
+        Stat stat;
+        AppendToBucket(
+            newBuckets[hashTable.GetBucketIndex(hash, newBuckets.size())],
+            data, entry->m_tags[i], stat);
+
+        if (stat.m_isNewEntryAdded) {
+          UpdatePerfDataForNewEntry();
+        }
+
+        hashTable.m_maxMigratedBucketChainLength = (std::max)(
+            hashTable.m_maxMigratedBucketChainLength, stat.m_chainIndex);
+      }
+    }
+  }
+
+  // Moves the records in the chained entries of the given bucket toward the
+  // tail of the chain and unlinks the chained entries left empty, which are
+  // added to "entriesToRelease". Returns the length of the chain afterwards.
+  // Note that the records are not moved toward the head: since a lock-free
+  // reader walks the chain from the head, a record is copied to its new slot
+  // before its old slot is cleared, and a reader that sees the old slot cleared
+  // also sees the new slot, which is further down the chain. The head entry,
+  // which is in the bucket array, is left as is; the empty slots there are
+  // taken first by the subsequent Add()s. It is assumed that this function is
+  // called under a lock.
+  std::uint32_t CompactBucket(
+      typename HashTable::Entry& bucket,
+      std::vector<typename HashTable::Entry*>& entriesToRelease) {
+    auto& entries = m_compaction.m_entries;
+    entries.clear();
+
+    for (auto* entry = bucket.m_next.Load(std::memory_order_relaxed);
+         entry != nullptr;
+         entry = entry->m_next.Load(std::memory_order_relaxed)) {
+      entries.push_back(entry);
+    }
+
+    // Moves the records from the front of the chained entries to the empty
+    // slots at the back.
+    std::size_t front = 0U;
+    std::size_t back = entries.size();
+    while (front + 1U < back) {
+      auto& from = *entries[front];
+      auto& to = *entries[back - 1U];
+
+      const auto occupied =
+          ~from.MatchEmpty() & HashTable::Entry::c_allSlotsMask;
+      if (occupied == 0U) {
+        ++front;
+        continue;
+      }
+
+      const auto emptyIndex = FindEmptySlot(to);
+      if (emptyIndex == HashTable::Entry::c_numDataPerEntry) {
+        --back;
+        continue;
+      }
+
+      const auto i =
+          static_cast<std::uint8_t>(Utils::Math::CountTrailingZeros(occupied));
+      UpdateRecord(to, emptyIndex,
+                   from.m_dataList[i].Load(std::memory_order_relaxed),
+                   from.m_tags[i]);
+      UpdateRecord(from, i, nullptr, 0U);
+    }
+
+    // A reader on an unlinked entry still reaches the rest of the chain, since
+    // the next pointer of the unlinked entry is left as is.
+    std::uint32_t chainLength = 1U;
+    auto* prev = &bucket;
+    for (auto* entry : entries) {
+      if (entry->MatchEmpty() == HashTable::Entry::c_allSlotsMask) {
+        prev->m_next.Store(entry->m_next.Load(std::memory_order_relaxed),
+                           std::memory_order_release);
+        entriesToRelease.push_back(entry);
+      } else {
+        prev = entry;
+        ++chainLength;
+      }
+    }
+
+    return chainLength;
+  }
+
+  // Makes the new bucket array current and retires the old one through the
+  // epoch manager. It is assumed that m_resizeMutex is held.
+  void CompleteResize(typename HashTable::Buckets& buckets,
+                      typename HashTable::Buckets& newBuckets) {
+    auto& hashTable = this->m_hashTable;
+
+    // Note that m_numMigratedBuckets is not reset here (see
+    // SharedHashTable::GetBucketsForWrite()).
+    hashTable.m_buckets.Store(&newBuckets, std::memory_order_release);
+    hashTable.m_newBuckets.Store(nullptr, std::memory_order_release);
+
+    auto& perfData = hashTable.m_perfData;
+    perfData.Set(HashTablePerfCounter::BucketsCount, newBuckets.size());
+    perfData.Set(HashTablePerfCounter::HugePageBytes,
+                 hashTable.GetHugePageBytes(newBuckets));
+    perfData.Set(HashTablePerfCounter::MaxBucketChainLength,
+                 hashTable.m_maxMigratedBucketChainLength);
+
+    auto* bucketsToRelease = &buckets;
+
+    m_epochManager.RegisterAction([this, bucketsToRelease]() {
+      auto& hashTable = this->m_hashTable;
+
+      // The records are owned by the new bucket array now.
+      std::uint64_t numChainedEntries = 0U;
+      for (auto& bucket : *bucketsToRelease) {
+        for (auto* entry = bucket.m_next.Load(); entry != nullptr;
+             entry = entry->m_next.Load()) {
+          ++numChainedEntries;
+        }
+
+        bucket.ReleaseChainedEntries(hashTable.m_allocator);
+      }
+
+      auto& perfData = hashTable.m_perfData;
+      perfData.Subtract(HashTablePerfCounter::ChainingEntriesCount,
+                        numChainedEntries);
+      perfData.Subtract(
+          HashTablePerfCounter::TotalIndexSize,
+          (bucketsToRelease->size() + numChainedEntries) *
+              sizeof(typename HashTable::Entry));
+
+      hashTable.DestroyBuckets(bucketsToRelease);
+    });
   }
 
   RecordBuffer* UpdateRecord(typename HashTable::Entry& entry,
                              std::uint8_t index,
                              RecordBuffer* newRecord,
-                             std::uint8_t newTag) {
+                             std::uint16_t newTag) {
     // This function should be called under a lock, so calling with
     // memory_order_relaxed for Load() is safe.
     auto& recordHolder = entry.m_dataList[index];
@@ -397,6 +1544,7 @@ class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
 
     recordHolder.Store(newRecord, std::memory_order_release);
     entry.m_tags[index] = newTag;
+    entry.SetOccupied(index, newRecord != nullptr);
 
     return oldRecord;
   }
@@ -413,6 +1561,41 @@ class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
     });
   }
 
+  // Releases the given records with a single epoch action.
+  void ReleaseRecords(std::vector<RecordBuffer*>&& records) {
+    if (records.empty()) {
+      return;
+    }
+
+    m_epochManager.RegisterAction(
+        [this, records = std::move(records)]() {
+          auto allocator =
+              this->m_hashTable.template GetAllocator<RecordBuffer>();
+          for (auto* record : records) {
+            record->~RecordBuffer();
+            allocator.deallocate(record, 1U);
+          }
+        });
+  }
+
+  // Releases the given chained entries, which are unlinked from the buckets,
+  // with a single epoch action.
+  void ReleaseEntries(std::vector<typename HashTable::Entry*>&& entries) {
+    if (entries.empty()) {
+      return;
+    }
+
+    m_epochManager.RegisterAction(
+        [this, entries = std::move(entries)]() {
+          auto allocator = this->m_hashTable.template GetAllocator<
+              typename HashTable::Entry>();
+          for (auto* entry : entries) {
+            entry->~Entry();
+            allocator.deallocate(entry, 1U);
+          }
+        });
+  }
+
   void UpdatePerfDataForAdd(const Stat& stat) {
     auto& perfData = this->m_hashTable.m_perfData;
 
@@ -452,6 +1635,59 @@ class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
     perfData.Max(HashTablePerfCounter::MaxValueSize, stat.m_valueSize);
   }
 
+  // Merges the stats aggregated by the threads for a batch into the perf
+  // counters and releases the records removed or replaced by the batch with a
+  // single epoch action.
+  void UpdatePerfDataForBatch(
+      const std::vector<BatchStat>& stats,
+      std::vector<std::vector<RecordBuffer*>>& recordsToRelease) {
+    BatchStat stat;
+    for (std::size_t i = 0U; i < stats.size(); ++i) {
+      stat.Merge(stats[i]);
+
+      if (i > 0U) {
+        recordsToRelease[0].insert(recordsToRelease[0].end(),
+                                   recordsToRelease[i].begin(),
+                                   recordsToRelease[i].end());
+      }
+    }
+
+    auto& perfData = this->m_hashTable.m_perfData;
+
+    perfData.Add(HashTablePerfCounter::RecordsCount, stat.m_recordsCount);
+    perfData.Add(HashTablePerfCounter::TotalKeySize, stat.m_totalKeySize);
+    perfData.Add(HashTablePerfCounter::TotalValueSize, stat.m_totalValueSize);
+    perfData.Add(HashTablePerfCounter::TotalIndexSize, stat.m_totalIndexSize);
+    perfData.Add(HashTablePerfCounter::ChainingEntriesCount,
+                 stat.m_chainingEntriesCount);
+
+    if (stat.m_maxKeySize >= stat.m_minKeySize) {
+      perfData.Min(HashTablePerfCounter::MinKeySize, stat.m_minKeySize);
+      perfData.Max(HashTablePerfCounter::MaxKeySize, stat.m_maxKeySize);
+    }
+
+    if (stat.m_maxValueSize >= stat.m_minValueSize) {
+      perfData.Min(HashTablePerfCounter::MinValueSize, stat.m_minValueSize);
+      perfData.Max(HashTablePerfCounter::MaxValueSize, stat.m_maxValueSize);
+    }
+
+    if (stat.m_maxBucketChainLength > 1) {
+      perfData.Max(HashTablePerfCounter::MaxBucketChainLength,
+                   stat.m_maxBucketChainLength);
+    }
+
+    ReleaseRecords(std::move(recordsToRelease[0]));
+  }
+
+  // Updates the perf counters for a chained entry created outside of Add().
+  void UpdatePerfDataForNewEntry() {
+    auto& perfData = this->m_hashTable.m_perfData;
+
+    perfData.Increment(HashTablePerfCounter::ChainingEntriesCount);
+    perfData.Add(HashTablePerfCounter::TotalIndexSize,
+                 sizeof(typename HashTable::Entry));
+  }
+
   void UpdatePerfDataForRemove(const Stat& stat) {
     auto& perfData = this->m_hashTable.m_perfData;
 
@@ -463,13 +1699,31 @@ class WritableHashTable : public virtual ReadOnlyHashTable<Allocator>,
   }
 
   IEpochActionManager& m_epochManager;
+
+  const boost::optional<HashTableConfig::Resize> m_resize;
+
+  Compaction m_compaction;
 };
 
 #pragma warning(pop)
 
+// BindBucketMutex struct binds the bucket mutex type of the hash tables so
+// that they can be passed as the template template parameters instantiated
+// with the allocator only (e.g., to Serializer and Deserializer).
+template <typename BucketMutex>
+struct BindBucketMutex {
+  template <typename Allocator>
+  using ReadOnlyHashTable =
+      ReadWrite::ReadOnlyHashTable<Allocator, VarRecord, BucketMutex>;
+
+  template <typename Allocator>
+  using WritableHashTable =
+      ReadWrite::WritableHashTable<Allocator, VarRecord, BucketMutex>;
+};
+
 // WritableHashTable::Stat struct encapsulates stats for Add()/Remove().
-template <typename Allocator>
-struct WritableHashTable<Allocator>::Stat {
+template <typename Allocator, typename RecordFormat, typename BucketMutex>
+struct WritableHashTable<Allocator, RecordFormat, BucketMutex>::Stat {
   using KeySize = Key::size_type;
   using ValueSize = Value::size_type;
 
@@ -491,10 +1745,77 @@ struct WritableHashTable<Allocator>::Stat {
   bool m_isNewEntryAdded;
 };
 
+// WritableHashTable::BatchStat struct aggregates the perf counter updates of
+// the records added or removed in a batch in the same way as
+// UpdatePerfDataForAdd() and UpdatePerfDataForRemove().
+template <typename Allocator, typename RecordFormat, typename BucketMutex>
+struct WritableHashTable<Allocator, RecordFormat, BucketMutex>::BatchStat {
+  using TValue = HashTablePerfData::TValue;
+
+  void Add(const Stat& stat, std::size_t recordOverhead) {
+    if (stat.m_oldValueSize != 0U) {
+      m_totalValueSize +=
+          static_cast<TValue>(stat.m_valueSize) - stat.m_oldValueSize;
+    } else {
+      m_totalKeySize += stat.m_keySize;
+      m_totalValueSize += stat.m_valueSize;
+      m_totalIndexSize +=
+          recordOverhead +
+          (stat.m_isNewEntryAdded ? sizeof(typename HashTable::Entry) : 0U);
+
+      m_minKeySize = (std::min)(m_minKeySize, TValue{stat.m_keySize});
+      m_maxKeySize = (std::max)(m_maxKeySize, TValue{stat.m_keySize});
+
+      ++m_recordsCount;
+
+      if (stat.m_isNewEntryAdded) {
+        ++m_chainingEntriesCount;
+        m_maxBucketChainLength =
+            (std::max)(m_maxBucketChainLength, TValue{stat.m_chainIndex});
+      }
+    }
+
+    m_minValueSize = (std::min)(m_minValueSize, TValue{stat.m_valueSize});
+    m_maxValueSize = (std::max)(m_maxValueSize, TValue{stat.m_valueSize});
+  }
+
+  void Remove(const Stat& stat, std::size_t recordOverhead) {
+    --m_recordsCount;
+    m_totalKeySize -= stat.m_keySize;
+    m_totalValueSize -= stat.m_valueSize;
+    m_totalIndexSize -= recordOverhead;
+  }
+
+  void Merge(const BatchStat& other) {
+    m_recordsCount += other.m_recordsCount;
+    m_totalKeySize += other.m_totalKeySize;
+    m_totalValueSize += other.m_totalValueSize;
+    m_totalIndexSize += other.m_totalIndexSize;
+    m_chainingEntriesCount += other.m_chainingEntriesCount;
+    m_minKeySize = (std::min)(m_minKeySize, other.m_minKeySize);
+    m_maxKeySize = (std::max)(m_maxKeySize, other.m_maxKeySize);
+    m_minValueSize = (std::min)(m_minValueSize, other.m_minValueSize);
+    m_maxValueSize = (std::max)(m_maxValueSize, other.m_maxValueSize);
+    m_maxBucketChainLength =
+        (std::max)(m_maxBucketChainLength, other.m_maxBucketChainLength);
+  }
+
+  TValue m_recordsCount = 0;
+  TValue m_totalKeySize = 0;
+  TValue m_totalValueSize = 0;
+  TValue m_totalIndexSize = 0;
+  TValue m_chainingEntriesCount = 0;
+  TValue m_minKeySize = (std::numeric_limits<TValue>::max)();
+  TValue m_maxKeySize = 0;
+  TValue m_minValueSize = (std::numeric_limits<TValue>::max)();
+  TValue m_maxValueSize = 0;
+  TValue m_maxBucketChainLength = 0;
+};
+
 // WritableHashTable::Serializer class that implements ISerializer, which
 // provides the functionality to serialize the WritableHashTable.
-template <typename Allocator>
-class WritableHashTable<Allocator>::Serializer
+template <typename Allocator, typename RecordFormat, typename BucketMutex>
+class WritableHashTable<Allocator, RecordFormat, BucketMutex>::Serializer
     : public IWritableHashTable::ISerializer {
  public:
   explicit Serializer(HashTable& hashTable) : m_hashTable{hashTable} {}
@@ -504,8 +1825,11 @@ class WritableHashTable<Allocator>::Serializer
 
   void Serialize(std::ostream& stream,
                  const Utils::Properties& /* properties */) override {
-    ReadWrite::Serializer<HashTable, ReadWrite::ReadOnlyHashTable>{}.Serialize(
-        m_hashTable, stream);
+    using BoundHashTables = BindBucketMutex<BucketMutex>;
+
+    ReadWrite::Serializer<HashTable,
+                          BoundHashTables::template ReadOnlyHashTable>{}
+        .Serialize(m_hashTable, stream);
   }
 
  private:
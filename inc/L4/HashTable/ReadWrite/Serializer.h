@@ -16,24 +16,30 @@ namespace ReadWrite {
 // Note that the HashTable template parameter in this file is
 // HashTable::ReadWrite::ReadOnlyHashTable<Allocator>::HashTable.
 // However, due to the cyclic dependency, it needs to be passed as a template
-// type.
+// type. Similarly, ReadOnlyHashTable and WritableHashTable are passed as
+// variadic template template parameters so that they are instantiated with
+// their default record format (VarRecord), which reads and writes the same
+// layout as any FixedRecord format with the same sizes.
 
-// All the deprecated (previous versions) serializer should be put inside the
-// Deprecated namespace. Removing any of the Deprecated serializers from the
-// source code will require the major package version change.
-namespace Deprecated {}  // namespace Deprecated
+// The name of the deserializer property requesting the hash table to be backed
+// by huge pages (see HashTableConfig::Setting::m_hugePages).
+constexpr const char* c_hugePagesPropertyName = "HugePages";
+
+// The name of the deserializer property requesting the values to be updated
+// in place (see HashTableConfig::Setting::m_inPlaceUpdates).
+constexpr const char* c_inPlaceUpdatesPropertyName = "InPlaceUpdates";
 
 namespace Current {
 
-constexpr std::uint8_t c_version = 1U;
+constexpr std::uint8_t c_version = 2U;
 
 // Current serializer used for serializing hash tables.
 // The serialization format of Serializer is:
-// <Version Id = 1> <Hash table settings> followed by
+// <Version Id = 2> <Hash table settings> followed by
 // If the next byte is set to 1:
 //     <Key size> <Key bytes> <Value size> <Value bytes>
 // Otherwise, end of the records.
-template <typename HashTable, template <typename> class ReadOnlyHashTable>
+template <typename HashTable, template <typename...> class ReadOnlyHashTable>
 class Serializer {
  public:
   Serializer() = default;
@@ -49,7 +55,20 @@ class Serializer {
 
     helper.Serialize(c_version);
 
-    helper.Serialize(&hashTable.m_setting, sizeof(hashTable.m_setting));
+    // The number of buckets may have grown since the hash table was created,
+    // so the current number of buckets is saved.
+    auto setting = hashTable.m_setting;
+    setting.m_numBuckets =
+        static_cast<std::uint32_t>(hashTable.GetBuckets().size());
+
+    // Whether to use huge pages depends on the machine loading the hash table,
+    // thus it is given through the properties instead (see Deserializer). So
+    // is whether to update the values in place, which depends on the
+    // workload.
+    setting.m_hugePages = false;
+    setting.m_inPlaceUpdates = false;
+
+    helper.Serialize(&setting, sizeof(setting));
 
     ReadOnlyHashTable<typename HashTable::Allocator> readOnlyHashTable(
         hashTable);
@@ -80,11 +99,12 @@ class Serializer {
 // Current Deserializer used for deserializing hash tables.
 template <typename Memory,
           typename HashTable,
-          template <typename>
+          template <typename...>
           class WritableHashTable>
 class Deserializer {
  public:
-  explicit Deserializer(const Utils::Properties& /* properties */) {}
+  explicit Deserializer(const Utils::Properties& properties)
+      : m_properties(properties) {}
 
   Deserializer(const Deserializer&) = delete;
   Deserializer& operator=(const Deserializer&) = delete;
@@ -92,10 +112,29 @@ class Deserializer {
   typename Memory::template UniquePtr<HashTable> Deserialize(
       Memory& memory,
       std::istream& stream) const {
+    typename HashTable::Setting setting;
+    DeserializerHelper(stream).Deserialize(setting);
+
+    return Deserialize(memory, stream, setting);
+  }
+
+  // Deserializes the records following the hash table settings, which are
+  // already read from the stream, into a hash table created with the given
+  // setting. The huge pages are used if the c_hugePagesPropertyName property
+  // is set to 1, and so are the in-place updates for
+  // c_inPlaceUpdatesPropertyName.
+  typename Memory::template UniquePtr<HashTable> Deserialize(
+      Memory& memory,
+      std::istream& stream,
+      typename HashTable::Setting setting) const {
     DeserializerHelper helper(stream);
 
-    typename HashTable::Setting setting;
-    helper.Deserialize(setting);
+    setting.m_hugePages = false;
+    m_properties.TryGet(c_hugePagesPropertyName, setting.m_hugePages);
+
+    setting.m_inPlaceUpdates = false;
+    m_properties.TryGet(c_inPlaceUpdatesPropertyName,
+                        setting.m_inPlaceUpdates);
 
     auto hashTable{
         memory.template MakeUnique<HashTable>(setting, memory.GetAllocator())};
@@ -158,13 +197,70 @@ class Deserializer {
           "RegisterAction() should not be called from the serializer.");
     }
   };
+
+  const Utils::Properties& m_properties;
 };
 
 }  // namespace Current
 
+// All the deprecated (previous versions) serializer should be put inside the
+// Deprecated namespace. Removing any of the Deprecated serializers from the
+// source code will require the major package version change.
+namespace Deprecated {
+
+namespace V1 {
+
+constexpr std::uint8_t c_version = 1U;
+
+// The hash table settings in the version 1 format, which always uses
+// MurmurHash3 with the modulo range reduction.
+template <typename HashTable>
+struct Setting {
+  std::uint32_t m_numBuckets;
+  std::uint32_t m_numBucketsPerMutex;
+  typename HashTable::Setting::KeySize m_fixedKeySize;
+  typename HashTable::Setting::ValueSize m_fixedValueSize;
+};
+
+// Deserializer for the version 1 format, which is the same as the current
+// format except for the hash table settings.
+template <typename Memory,
+          typename HashTable,
+          template <typename...>
+          class WritableHashTable>
+class Deserializer {
+ public:
+  explicit Deserializer(const Utils::Properties& properties)
+      : m_properties(properties) {}
+
+  Deserializer(const Deserializer&) = delete;
+  Deserializer& operator=(const Deserializer&) = delete;
+
+  typename Memory::template UniquePtr<HashTable> Deserialize(
+      Memory& memory,
+      std::istream& stream) const {
+    Setting<HashTable> setting;
+    DeserializerHelper(stream).Deserialize(setting);
+
+    return Current::Deserializer<Memory, HashTable, WritableHashTable>{
+        m_properties}
+        .Deserialize(memory, stream,
+                     typename HashTable::Setting{
+                         setting.m_numBuckets, setting.m_numBucketsPerMutex,
+                         setting.m_fixedKeySize, setting.m_fixedValueSize});
+  }
+
+ private:
+  const Utils::Properties& m_properties;
+};
+
+}  // namespace V1
+
+}  // namespace Deprecated
+
 // Serializer is the main driver for serializing a hash table.
 // It always uses the Current::Serializer for serializing a hash table.
-template <typename HashTable, template <typename> class ReadOnlyHashTable>
+template <typename HashTable, template <typename...> class ReadOnlyHashTable>
 class Serializer {
  public:
   Serializer() = default;
@@ -181,7 +277,7 @@ class Serializer {
 // a hash table.
 template <typename Memory,
           typename HashTable,
-          template <typename>
+          template <typename...>
           class WritableHashTable>
 class Deserializer {
  public:
@@ -202,6 +298,10 @@ class Deserializer {
         return Current::Deserializer<Memory, HashTable, WritableHashTable>{
             m_properties}
             .Deserialize(memory, stream);
+      case Deprecated::V1::c_version:
+        return Deprecated::V1::Deserializer<Memory, HashTable,
+                                            WritableHashTable>{m_properties}
+            .Deserialize(memory, stream);
       default:
         boost::format err("Unsupported version '%1%' is given.");
         err % version;
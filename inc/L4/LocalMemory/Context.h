@@ -9,17 +9,22 @@ namespace LocalMemory {
 
 class Context : private EpochRefPolicy<EpochManager::TheEpochRefManager> {
  public:
+  // The read-only access through the context reads the replica on the given
+  // NUMA node for the hash tables with NUMA replicas.
   Context(HashTableManager& hashTableManager,
-          EpochManager::TheEpochRefManager& epochRefManager)
+          EpochManager::TheEpochRefManager& epochRefManager,
+          std::uint32_t numaNode = 0U)
       : EpochRefPolicy<EpochManager::TheEpochRefManager>(epochRefManager),
-        m_hashTableManager{hashTableManager} {}
+        m_hashTableManager{hashTableManager},
+        m_numaNode{numaNode} {}
 
   Context(Context&& context)
       : EpochRefPolicy<EpochManager::TheEpochRefManager>(std::move(context)),
-        m_hashTableManager{context.m_hashTableManager} {}
+        m_hashTableManager{context.m_hashTableManager},
+        m_numaNode{context.m_numaNode} {}
 
   const IReadOnlyHashTable& operator[](const char* name) const {
-    return m_hashTableManager.GetHashTable(name);
+    return m_hashTableManager.GetHashTable(name, m_numaNode);
   }
 
   IWritableHashTable& operator[](const char* name) {
@@ -27,7 +32,7 @@ class Context : private EpochRefPolicy<EpochManager::TheEpochRefManager> {
   }
 
   const IReadOnlyHashTable& operator[](std::size_t index) const {
-    return m_hashTableManager.GetHashTable(index);
+    return m_hashTableManager.GetHashTable(index, m_numaNode);
   }
 
   IWritableHashTable& operator[](std::size_t index) {
@@ -39,6 +44,8 @@ class Context : private EpochRefPolicy<EpochManager::TheEpochRefManager> {
 
  private:
   HashTableManager& m_hashTableManager;
+
+  const std::uint32_t m_numaNode;
 };
 
 }  // namespace LocalMemory
@@ -1,22 +1,40 @@
 #pragma once
 
 #include <boost/any.hpp>
+#include <iterator>
 #include <memory>
+#include <sstream>
+#include <string>
 #include <vector>
 #include "Epoch/IEpochActionManager.h"
 #include "HashTable/Cache/HashTable.h"
+#include "HashTable/Common/SettingAdapter.h"
 #include "HashTable/Config.h"
+#include "HashTable/Cuckoo/HashTable.h"
+#include "HashTable/Inline/HashTable.h"
+#include "HashTable/OpenAddressing/HashTable.h"
 #include "HashTable/ReadWrite/HashTable.h"
 #include "HashTable/ReadWrite/Serializer.h"
 #include "LocalMemory/Memory.h"
+#include "LocalMemory/ReplicatedHashTable.h"
 #include "Utils/Containers.h"
 #include "Utils/Exception.h"
+#include "Utils/NumaTopology.h"
 
 namespace L4 {
 namespace LocalMemory {
 
 class HashTableManager {
  public:
+  HashTableManager() = default;
+
+  // The given NUMA topology is used for the hash tables with
+  // HashTableConfig::m_numaReplicas. If not given, the topology of the machine
+  // is used.
+  explicit HashTableManager(
+      std::shared_ptr<const Utils::INumaTopology> numaTopology)
+      : m_numaTopology{std::move(numaTopology)} {}
+
   template <typename Allocator>
   std::size_t Add(const HashTableConfig& config,
                   IEpochActionManager& epochActionManager,
@@ -34,66 +52,420 @@ class HashTableManager {
           "Constructing cache hash table via serializer is not supported.");
     }
 
+    if (cacheConfig && config.m_resize) {
+      throw RuntimeException("Resizing cache hash table is not supported.");
+    }
+
+    if (cacheConfig && cacheConfig->m_backgroundEviction) {
+      const auto& backgroundEviction = *cacheConfig->m_backgroundEviction;
+      if (!(backgroundEviction.m_lowWatermark >= 0.0 &&
+            backgroundEviction.m_lowWatermark <=
+                backgroundEviction.m_highWatermark &&
+            backgroundEviction.m_highWatermark <= 1.0)) {
+        throw RuntimeException(
+            "Background eviction watermarks should satisfy 0 <= low <= high "
+            "<= 1.");
+      }
+    }
+
+    if (cacheConfig && (cacheConfig->m_numEvictionShards == 0U ||
+                        cacheConfig->m_numEvictionShards >
+                            config.m_setting.m_numBuckets)) {
+      throw RuntimeException(
+          "The number of eviction shards should be between 1 and the number "
+          "of buckets.");
+    }
+
+    if (config.m_numaReplicas.get_value_or(false)) {
+      if (cacheConfig) {
+        throw RuntimeException(
+            "NUMA replicas are not supported for cache hash table.");
+      }
+
+      return AddReplicated(config, epochActionManager, allocator);
+    }
+
+    const auto engine = config.m_setting.m_engine.get_value_or(
+        HashTableConfig::Engine::Chained);
+    const auto bucketLock = config.m_setting.m_bucketLock.get_value_or(
+        HashTableConfig::BucketLock::ReaderWriter);
+
+    if (bucketLock != HashTableConfig::BucketLock::ReaderWriter &&
+        (engine != HashTableConfig::Engine::Chained ||
+         config.m_setting.m_inlineRecords.get_value_or(false))) {
+      throw RuntimeException(
+          "Bucket lock is supported only for chained engine without inline "
+          "records.");
+    }
+
+    if (config.m_setting.m_inPlaceUpdates.get_value_or(false) &&
+        (cacheConfig || engine != HashTableConfig::Engine::Chained ||
+         config.m_setting.m_inlineRecords.get_value_or(false))) {
+      throw RuntimeException(
+          "In-place updates are supported only for chained engine without "
+          "cache or inline records.");
+    }
+
+    if (config.m_setting.m_inlineRecords.get_value_or(false)) {
+      if (cacheConfig || serializerConfig || config.m_resize ||
+          engine != HashTableConfig::Engine::Chained) {
+        throw RuntimeException(
+            "Inline records are not supported for cache, serializer, resize "
+            "or other engines.");
+      }
+
+      return AddInline(config, epochActionManager, allocator);
+    }
+
+    if (engine != HashTableConfig::Engine::Chained) {
+      if (cacheConfig || config.m_resize) {
+        throw RuntimeException(
+            "Open addressing and cuckoo engines are not supported for cache "
+            "or resize.");
+      }
+
+      return (engine == HashTableConfig::Engine::OpenAddressing)
+                 ? AddFixedSize<HashTable::OpenAddressing::WritableHashTable>(
+                       config, epochActionManager, allocator)
+                 : AddFixedSize<HashTable::Cuckoo::WritableHashTable>(
+                       config, epochActionManager, allocator);
+    }
+
+    switch (bucketLock) {
+      case HashTableConfig::BucketLock::Spin:
+        return AddChained<Utils::SpinLock>(config, epochActionManager,
+                                           allocator);
+      case HashTableConfig::BucketLock::Ticket:
+        return AddChained<Utils::TicketLock>(config, epochActionManager,
+                                             allocator);
+      case HashTableConfig::BucketLock::Adaptive:
+        return AddChained<Utils::AdaptiveLock>(config, epochActionManager,
+                                               allocator);
+      default:
+        return AddChained<Utils::ReaderWriterLockSlim>(
+            config, epochActionManager, allocator);
+    }
+  }
+
+  IWritableHashTable& GetHashTable(const char* name) {
+    assert(m_hashTableNameToIndex.find(name) != m_hashTableNameToIndex.cend());
+    return GetHashTable(m_hashTableNameToIndex.find(name)->second);
+  }
+
+  IWritableHashTable& GetHashTable(std::size_t index) {
+    assert(index < m_hashTables.size());
+    return *m_hashTables[index];
+  }
+
+  // Returns the hash table to read on the given NUMA node, which is the
+  // replica on the node if the hash table has NUMA replicas.
+  const IReadOnlyHashTable& GetHashTable(const char* name,
+                                         std::uint32_t numaNode) const {
+    assert(m_hashTableNameToIndex.find(name) != m_hashTableNameToIndex.cend());
+    return GetHashTable(m_hashTableNameToIndex.find(name)->second, numaNode);
+  }
+
+  const IReadOnlyHashTable& GetHashTable(std::size_t index,
+                                         std::uint32_t numaNode) const {
+    assert(index < m_hashTables.size());
+    const auto* replicatedHashTable = m_replicatedHashTables[index];
+    return (replicatedHashTable != nullptr)
+               ? replicatedHashTable->GetReplica(numaNode)
+               : *m_hashTables[index];
+  }
+
+  // Returns the NUMA node that the calling thread is running on.
+  std::uint32_t GetCurrentNumaNode() const {
+    return m_numaTopology ? m_numaTopology->GetCurrentNode() : 0U;
+  }
+
+  // Loads the given records into the hash table with the given name. See
+  // IWritableHashTable::BulkLoad() for details.
+  void BulkLoad(const char* name,
+                const IWritableHashTable::KeyValue* records,
+                std::size_t numRecords,
+                const IWritableHashTable::BulkLoadOptions& options) {
+    GetHashTable(name).BulkLoad(records, numRecords, options);
+  }
+
+  // Loads the records read from a stream into the hash table with the given
+  // name, in batches of the given size. "readRecords(records, maxNumRecords)"
+  // fills up to the given number of records and returns the number of the
+  // records filled, where 0 indicates the end of the stream. The keys and the
+  // values filled need to stay valid only until the next call.
+  template <typename ReadRecords>
+  void BulkLoad(const char* name,
+                ReadRecords&& readRecords,
+                const IWritableHashTable::BulkLoadOptions& options,
+                std::size_t batchSize) {
+    auto& hashTable = GetHashTable(name);
+
+    std::vector<IWritableHashTable::KeyValue> records(batchSize);
+    std::size_t numRecords = 0U;
+    while ((numRecords = readRecords(records.data(), records.size())) != 0U) {
+      hashTable.BulkLoad(records.data(), numRecords, options);
+    }
+  }
+
+ private:
+  template <typename... RecordFormats>
+  struct RecordFormatList {};
+
+  // Adds a hash table of the chained engine whose buckets are guarded by the
+  // given type of mutexes.
+  template <typename BucketMutex, typename Allocator>
+  std::size_t AddChained(const HashTableConfig& config,
+                         IEpochActionManager& epochActionManager,
+                         Allocator allocator) {
+    using namespace HashTable;
+
+    using BoundHashTables = ReadWrite::BindBucketMutex<BucketMutex>;
+    using InternalHashTable = typename BoundHashTables::template
+        WritableHashTable<Allocator>::HashTable;
+    using Memory = typename LocalMemory::Memory<Allocator>;
+
+    Memory memory{allocator};
+
+    const auto& serializerConfig = config.m_serializer;
+
+    std::shared_ptr<InternalHashTable> internalHashTable =
+        (serializerConfig && serializerConfig->m_stream != nullptr)
+            ? ReadWrite::Deserializer<
+                  Memory, InternalHashTable,
+                  BoundHashTables::template WritableHashTable>(
+                  GetSerializerProperties(config))
+                  .Deserialize(memory, *(serializerConfig->m_stream))
+            : memory.template MakeUnique<InternalHashTable>(
+                  SettingAdapter{}.Convert<InternalHashTable>(
+                      config.m_setting),
+                  memory.GetAllocator());
+
+    auto hashTable = CreateHashTable<Allocator>(
+        FixedRecordFormats{}, config, *internalHashTable, epochActionManager);
+
+    return Register(config.m_name, std::move(internalHashTable),
+                    std::move(hashTable));
+  }
+
+  // The fixed key/value sizes for which the hash tables are instantiated with
+  // the compile-time record format. The hash tables with other sizes use
+  // VarRecord.
+  using FixedRecordFormats =
+      RecordFormatList<HashTable::FixedRecord<8U, 8U>,
+                       HashTable::FixedRecord<8U, 16U>,
+                       HashTable::FixedRecord<16U, 8U>,
+                       HashTable::FixedRecord<16U, 16U>>;
+
+  // Creates the hash table with the first record format in the given list that
+  // matches the fixed key and value sizes of the given hash table.
+  template <typename Allocator,
+            typename InternalHashTable,
+            typename RecordFormat,
+            typename... RecordFormats>
+  static std::unique_ptr<IWritableHashTable> CreateHashTable(
+      RecordFormatList<RecordFormat, RecordFormats...>,
+      const HashTableConfig& config,
+      InternalHashTable& internalHashTable,
+      IEpochActionManager& epochActionManager) {
+    const auto& setting = internalHashTable.m_setting;
+
+    return RecordFormat::IsMatch(setting.m_fixedKeySize,
+                                 setting.m_fixedValueSize)
+               ? CreateHashTable<Allocator, RecordFormat>(
+                     config, internalHashTable, epochActionManager)
+               : CreateHashTable<Allocator>(
+                     RecordFormatList<RecordFormats...>{}, config,
+                     internalHashTable, epochActionManager);
+  }
+
+  template <typename Allocator, typename InternalHashTable>
+  static std::unique_ptr<IWritableHashTable> CreateHashTable(
+      RecordFormatList<>,
+      const HashTableConfig& config,
+      InternalHashTable& internalHashTable,
+      IEpochActionManager& epochActionManager) {
+    return CreateHashTable<Allocator, HashTable::VarRecord>(
+        config, internalHashTable, epochActionManager);
+  }
+
+  template <typename Allocator,
+            typename RecordFormat,
+            typename InternalHashTable>
+  static std::unique_ptr<IWritableHashTable> CreateHashTable(
+      const HashTableConfig& config,
+      InternalHashTable& internalHashTable,
+      IEpochActionManager& epochActionManager) {
+    using namespace HashTable;
+
+    using BucketMutex = typename InternalHashTable::Mutex;
+
+    if (const auto& cacheConfig = config.m_cache) {
+      return std::make_unique<Cache::WritableHashTable<
+          Allocator, Utils::EpochClock, RecordFormat, BucketMutex>>(
+          internalHashTable, epochActionManager,
+          cacheConfig->m_maxCacheSizeInBytes, cacheConfig->m_recordTimeToLive,
+          cacheConfig->m_forceTimeBasedEviction,
+          cacheConfig->m_evictionPolicy, cacheConfig->m_backgroundEviction,
+          cacheConfig->m_numEvictionShards);
+    }
+
+    return std::make_unique<
+        ReadWrite::WritableHashTable<Allocator, RecordFormat, BucketMutex>>(
+        internalHashTable, epochActionManager, config.m_resize);
+  }
+
+  template <typename Allocator>
+  std::size_t AddInline(const HashTableConfig& config,
+                        IEpochActionManager& epochActionManager,
+                        Allocator allocator) {
+    using namespace HashTable;
+
+    using InternalHashTable =
+        typename Inline::WritableHashTable<Allocator>::HashTable;
+    using Memory = typename LocalMemory::Memory<Allocator>;
+
+    Memory memory{allocator};
+
+    std::shared_ptr<InternalHashTable> internalHashTable =
+        memory.template MakeUnique<InternalHashTable>(
+            SettingAdapter{}.Convert<InternalHashTable>(config.m_setting),
+            memory.GetAllocator());
+
+    return Register(config.m_name, std::move(internalHashTable),
+                    std::make_unique<Inline::WritableHashTable<Allocator>>(
+                        *internalHashTable, epochActionManager));
+  }
+
+  // Adds a hash table of an engine whose number of buckets is fixed (open
+  // addressing or cuckoo). Both engines share the serialization format with
+  // the chained engine.
+  template <template <typename...> class WritableHashTable, typename Allocator>
+  std::size_t AddFixedSize(const HashTableConfig& config,
+                           IEpochActionManager& epochActionManager,
+                           Allocator allocator) {
     using namespace HashTable;
 
     using InternalHashTable =
-        typename ReadWrite::WritableHashTable<Allocator>::HashTable;
+        typename WritableHashTable<Allocator>::HashTable;
     using Memory = typename LocalMemory::Memory<Allocator>;
 
     Memory memory{allocator};
 
+    const auto& serializerConfig = config.m_serializer;
+
     std::shared_ptr<InternalHashTable> internalHashTable =
         (serializerConfig && serializerConfig->m_stream != nullptr)
             ? ReadWrite::Deserializer<Memory, InternalHashTable,
-                                      ReadWrite::WritableHashTable>(
-                  serializerConfig->m_properties.get_value_or(
-                      HashTableConfig::Serializer::Properties()))
+                                      WritableHashTable>(
+                  GetSerializerProperties(config))
                   .Deserialize(memory, *(serializerConfig->m_stream))
             : memory.template MakeUnique<InternalHashTable>(
-                  typename InternalHashTable::Setting{
-                      config.m_setting.m_numBuckets,
-                      (std::max)(
-                          config.m_setting.m_numBucketsPerMutex.get_value_or(
-                              1U),
-                          1U),
-                      config.m_setting.m_fixedKeySize.get_value_or(0U),
-                      config.m_setting.m_fixedValueSize.get_value_or(0U)},
+                  SettingAdapter{}.Convert<InternalHashTable>(
+                      config.m_setting),
                   memory.GetAllocator());
 
-    auto hashTable =
-        cacheConfig ? std::make_unique<Cache::WritableHashTable<Allocator>>(
-                          *internalHashTable, epochActionManager,
-                          cacheConfig->m_maxCacheSizeInBytes,
-                          cacheConfig->m_recordTimeToLive,
-                          cacheConfig->m_forceTimeBasedEviction)
-                    : std::make_unique<ReadWrite::WritableHashTable<Allocator>>(
-                          *internalHashTable, epochActionManager);
+    return Register(config.m_name, std::move(internalHashTable),
+                    std::make_unique<WritableHashTable<Allocator>>(
+                        *internalHashTable, epochActionManager));
+  }
 
-    m_internalHashTables.emplace_back(std::move(internalHashTable));
-    m_hashTables.emplace_back(std::move(hashTable));
+  // Returns the properties for the deserializer, which request the huge pages
+  // and the in-place updates if the setting does since they are not persisted
+  // by the serializer.
+  static HashTableConfig::Serializer::Properties GetSerializerProperties(
+      const HashTableConfig& config) {
+    auto properties = config.m_serializer->m_properties.get_value_or(
+        HashTableConfig::Serializer::Properties());
 
-    const auto newIndex = m_hashTables.size() - 1;
+    if (config.m_setting.m_hugePages.get_value_or(false)) {
+      properties.emplace(HashTable::ReadWrite::c_hugePagesPropertyName, "1");
+    }
 
-    m_hashTableNameToIndex.emplace(config.m_name, newIndex);
+    if (config.m_setting.m_inPlaceUpdates.get_value_or(false)) {
+      properties.emplace(HashTable::ReadWrite::c_inPlaceUpdatesPropertyName,
+                         "1");
+    }
 
-    return newIndex;
+    return properties;
   }
 
-  IWritableHashTable& GetHashTable(const char* name) {
-    assert(m_hashTableNameToIndex.find(name) != m_hashTableNameToIndex.cend());
-    return GetHashTable(m_hashTableNameToIndex.find(name)->second);
+  // Adds a hash table with one replica per NUMA node. Each replica is created
+  // on a thread bound to its node, so that its memory is placed on the node.
+  // The replicas are owned by another HashTableManager, which is kept as the
+  // internal hash table.
+  template <typename Allocator>
+  std::size_t AddReplicated(const HashTableConfig& config,
+                            IEpochActionManager& epochActionManager,
+                            Allocator allocator) {
+    if (!m_numaTopology) {
+      m_numaTopology = std::make_shared<Utils::NumaTopology>();
+    }
+
+    auto replicaConfig = config;
+    replicaConfig.m_numaReplicas = false;
+
+    // The stream can be read only once, thus it is read into memory and each
+    // replica is loaded from its own copy.
+    const bool hasStream =
+        config.m_serializer && config.m_serializer->m_stream != nullptr;
+    std::string serializedData;
+    if (hasStream) {
+      serializedData.assign(
+          std::istreambuf_iterator<char>{*config.m_serializer->m_stream},
+          std::istreambuf_iterator<char>{});
+    }
+
+    auto replicaManager = std::make_shared<HashTableManager>();
+    std::vector<IWritableHashTable*> replicas;
+
+    for (std::uint32_t node = 0U; node < m_numaTopology->GetNumNodes();
+         ++node) {
+      replicaConfig.m_name = std::to_string(node);
+      if (hasStream) {
+        replicaConfig.m_serializer->m_stream =
+            std::make_shared<std::istringstream>(serializedData);
+      }
+
+      m_numaTopology->RunOnNode(node, [&]() {
+        replicas.push_back(&replicaManager->GetHashTable(
+            replicaManager->Add(replicaConfig, epochActionManager, allocator)));
+      });
+    }
+
+    auto hashTable = std::make_unique<ReplicatedHashTable>(std::move(replicas),
+                                                           m_numaTopology);
+    const auto* replicatedHashTable = hashTable.get();
+
+    const auto index = Register(config.m_name, std::move(replicaManager),
+                                std::move(hashTable));
+    m_replicatedHashTables[index] = replicatedHashTable;
+
+    return index;
   }
 
-  IWritableHashTable& GetHashTable(std::size_t index) {
-    assert(index < m_hashTables.size());
-    return *m_hashTables[index];
+  std::size_t Register(const std::string& name,
+                       boost::any internalHashTable,
+                       std::unique_ptr<IWritableHashTable> hashTable) {
+    m_internalHashTables.emplace_back(std::move(internalHashTable));
+    m_hashTables.emplace_back(std::move(hashTable));
+    m_replicatedHashTables.emplace_back(nullptr);
+
+    const auto newIndex = m_hashTables.size() - 1;
+
+    m_hashTableNameToIndex.emplace(name, newIndex);
+
+    return newIndex;
   }
 
- private:
   Utils::StdStringKeyMap<std::size_t> m_hashTableNameToIndex;
 
   std::vector<boost::any> m_internalHashTables;
   std::vector<std::unique_ptr<IWritableHashTable>> m_hashTables;
+
+  // The hash tables in m_hashTables that have NUMA replicas, or nullptr.
+  std::vector<const ReplicatedHashTable*> m_replicatedHashTables;
+
+  std::shared_ptr<const Utils::INumaTopology> m_numaTopology;
 };
 
 }  // namespace LocalMemory
@@ -1,30 +1,87 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
 #include "Context.h"
 #include "EpochManager.h"
 #include "HashTable/Config.h"
+#include "Epoch/EpochRefPolicy.h"
 #include "Log/PerfCounter.h"
+#include "Utils/NumaTopology.h"
+#include "Utils/RunningThread.h"
 
 namespace L4 {
 namespace LocalMemory {
 
 class HashTableService {
  public:
+  // The NUMA topology is used for the hash tables with NUMA replicas (see
+  // HashTableConfig::m_numaReplicas). It can be simulated for testing.
   explicit HashTableService(
-      const EpochManagerConfig& epochManagerConfig = EpochManagerConfig())
-      : m_epochManager{epochManagerConfig, m_serverPerfData} {}
+      const EpochManagerConfig& epochManagerConfig = EpochManagerConfig(),
+      std::shared_ptr<const Utils::INumaTopology> numaTopology =
+          std::make_shared<Utils::NumaTopology>())
+      : m_hashTableManager{std::move(numaTopology)},
+        m_epochManager{epochManagerConfig, m_serverPerfData} {}
 
+  // If the compaction or the background eviction is configured, a thread is
+  // started to compact or evict the hash table periodically (see
+  // HashTableConfig::Compaction and
+  // HashTableConfig::Cache::BackgroundEviction).
   template <typename Allocator = std::allocator<void>>
   std::size_t AddHashTable(const HashTableConfig& config,
                            Allocator allocator = Allocator()) {
-    return m_hashTableManager.Add(config, m_epochManager, allocator);
+    const auto index =
+        m_hashTableManager.Add(config, m_epochManager, allocator);
+
+    if (config.m_compaction) {
+      StartCompaction(m_hashTableManager.GetHashTable(index),
+                      *config.m_compaction);
+    }
+
+    if (config.m_cache && config.m_cache->m_backgroundEviction) {
+      StartBackgroundEviction(m_hashTableManager.GetHashTable(index),
+                              *config.m_cache->m_backgroundEviction);
+    }
+
+    return index;
   }
 
   Context GetContext() {
-    return Context(m_hashTableManager, m_epochManager.GetEpochRefManager());
+    return Context(m_hashTableManager, m_epochManager.GetEpochRefManager(),
+                   m_hashTableManager.GetCurrentNumaNode());
   }
 
  private:
+  using BackgroundThread = Utils::RunningThread<std::function<void()>>;
+
+  // Each run compacts the hash table in an epoch, so that the entries being
+  // released are not freed while the thread is accessing them.
+  void StartCompaction(IWritableHashTable& hashTable,
+                       const HashTableConfig::Compaction& compaction) {
+    const auto numBucketsPerRun = compaction.m_numBucketsPerRun;
+
+    m_backgroundThreads.emplace_back(std::make_unique<BackgroundThread>(
+        compaction.m_interval, [this, &hashTable, numBucketsPerRun]() {
+          EpochRefPolicy<EpochManager::TheEpochRefManager> epochRef{
+              m_epochManager.GetEpochRefManager()};
+          hashTable.Compact(numBucketsPerRun);
+        }));
+  }
+
+  // Each run evicts the hash table in an epoch as the compaction does.
+  void StartBackgroundEviction(
+      IWritableHashTable& hashTable,
+      const HashTableConfig::Cache::BackgroundEviction& backgroundEviction) {
+    m_backgroundThreads.emplace_back(std::make_unique<BackgroundThread>(
+        backgroundEviction.m_interval, [this, &hashTable]() {
+          EpochRefPolicy<EpochManager::TheEpochRefManager> epochRef{
+              m_epochManager.GetEpochRefManager()};
+          hashTable.EvictToWatermark();
+        }));
+  }
+
   ServerPerfData m_serverPerfData;
 
   HashTableManager m_hashTableManager;
@@ -33,6 +90,10 @@ class HashTableService {
   // it is possible that EpochManager could be processing Epoch Actions
   // on hash tables.
   EpochManager m_epochManager;
+
+  // Make sure the compaction and eviction threads are stopped before the hash
+  // tables and EpochManager are destroyed.
+  std::vector<std::unique_ptr<BackgroundThread>> m_backgroundThreads;
 };
 
 }  // namespace LocalMemory
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "HashTable/IHashTable.h"
+#include "Utils/Lock.h"
+#include "Utils/NumaTopology.h"
+
+namespace L4 {
+namespace LocalMemory {
+
+// ReplicatedHashTable class keeps one replica of a hash table per NUMA node
+// (see HashTableConfig::m_numaReplicas). The reads are served by the replica on
+// the node that the calling thread is running on, and the writes are applied
+// to all the replicas. The writes are serialized so that the replicas apply
+// them in the same order; since a write is applied to the replicas one by one,
+// the readers on different nodes may briefly see different values for the key
+// being written. The first replica is the primary, which is used for the
+// iterator, the perf data and the serializer.
+class ReplicatedHashTable : public IWritableHashTable {
+ public:
+  ReplicatedHashTable(std::vector<IWritableHashTable*> replicas,
+                      std::shared_ptr<const Utils::INumaTopology> numaTopology)
+      : m_replicas{std::move(replicas)},
+        m_numaTopology{std::move(numaTopology)} {
+    assert(!m_replicas.empty());
+  }
+
+  // Returns the replica on the given node.
+  const IReadOnlyHashTable& GetReplica(std::uint32_t node) const {
+    return *m_replicas[node % m_replicas.size()];
+  }
+
+  std::size_t GetNumReplicas() const { return m_replicas.size(); }
+
+  bool Get(const Key& key, Value& value) const override {
+    return GetLocalReplica().Get(key, value);
+  }
+
+  bool GetCopy(const Key& key,
+               std::vector<std::uint8_t>& value) const override {
+    return GetLocalReplica().GetCopy(key, value);
+  }
+
+  std::size_t MultiGet(const Key* keys,
+                       std::size_t numKeys,
+                       Value* values,
+                       bool* found) const override {
+    return GetLocalReplica().MultiGet(keys, numKeys, values, found);
+  }
+
+  IIteratorPtr GetIterator() const override {
+    return m_replicas.front()->GetIterator();
+  }
+
+  void ForEachRecord(ForEachCallback callback,
+                     void* context,
+                     std::uint16_t numThreads) const override {
+    m_replicas.front()->ForEachRecord(callback, context, numThreads);
+  }
+
+  const HashTablePerfData& GetPerfData() const override {
+    return m_replicas.front()->GetPerfData();
+  }
+
+  HashTableStats GetStats(const HashTableStatsOptions& options) const override {
+    return m_replicas.front()->GetStats(options);
+  }
+
+  void Add(const Key& key, const Value& value) override {
+    Lock lock{m_mutex};
+
+    for (auto* replica : m_replicas) {
+      replica->Add(key, value);
+    }
+  }
+
+  void BulkLoad(const KeyValue* records,
+                std::size_t numRecords,
+                const BulkLoadOptions& options) override {
+    Lock lock{m_mutex};
+
+    for (auto* replica : m_replicas) {
+      replica->BulkLoad(records, numRecords, options);
+    }
+  }
+
+  void AddBatch(const KeyValue* records, std::size_t numRecords) override {
+    Lock lock{m_mutex};
+
+    for (auto* replica : m_replicas) {
+      replica->AddBatch(records, numRecords);
+    }
+  }
+
+  bool Remove(const Key& key) override {
+    Lock lock{m_mutex};
+
+    bool isRemoved = false;
+    for (auto* replica : m_replicas) {
+      isRemoved |= replica->Remove(key);
+    }
+
+    return isRemoved;
+  }
+
+  // The replicas have the same records, so the result of the primary is
+  // returned.
+  std::size_t RemoveBatch(const Key* keys,
+                          std::size_t numKeys,
+                          bool* removed) override {
+    Lock lock{m_mutex};
+
+    auto numRemoved = m_replicas.front()->RemoveBatch(keys, numKeys, removed);
+    for (std::size_t i = 1U; i < m_replicas.size(); ++i) {
+      m_replicas[i]->RemoveBatch(keys, numKeys, nullptr);
+    }
+
+    return numRemoved;
+  }
+
+  // Each replica merges the operand into its own existing value, thus the
+  // merge operator should be deterministic.
+  void Upsert(const Key& key,
+              const Value& operand,
+              const IMergeOperator& mergeOperator) override {
+    Lock lock{m_mutex};
+
+    for (auto* replica : m_replicas) {
+      replica->Upsert(key, operand, mergeOperator);
+    }
+  }
+
+  // Each replica is compacted on its own, and the result of the primary is
+  // returned.
+  std::size_t Compact(std::uint32_t maxNumBuckets) override {
+    Lock lock{m_mutex};
+
+    auto numReleased = m_replicas.front()->Compact(maxNumBuckets);
+    for (std::size_t i = 1U; i < m_replicas.size(); ++i) {
+      m_replicas[i]->Compact(maxNumBuckets);
+    }
+
+    return numReleased;
+  }
+
+  ISerializerPtr GetSerializer() const override {
+    return m_replicas.front()->GetSerializer();
+  }
+
+ private:
+  using Mutex = Utils::ReaderWriterLockSlim;
+  using Lock = std::lock_guard<Mutex>;
+
+  const IReadOnlyHashTable& GetLocalReplica() const {
+    return GetReplica(m_numaTopology->GetCurrentNode());
+  }
+
+  std::vector<IWritableHashTable*> m_replicas;
+
+  std::shared_ptr<const Utils::INumaTopology> m_numaTopology;
+
+  Mutex m_mutex;
+};
+
+}  // namespace LocalMemory
+}  // namespace L4
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <boost/align/aligned_alloc.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "Log/PerfCounter.h"
+
+namespace L4 {
+namespace LocalMemory {
+
+// SlabPool class manages the memory for SlabAllocator. The allocations up to
+// c_maxBlockSize bytes are rounded up to one of the size classes, which are
+// every 16 bytes up to 256 bytes (which covers the most of the records and
+// the hash table entries) and every 64 bytes up to c_maxBlockSize, and are
+// carved out of the slabs of c_slabSize bytes dedicated to a size class. The
+// larger allocations (e.g., the bucket arrays) are allocated individually.
+//
+// Each thread is assigned one of the c_numMagazines magazines, which caches up
+// to c_magazineSize free blocks per size class, so that most of the
+// allocations and deallocations do not touch the shared state of a size
+// class. A magazine is refilled from or flushed to the slabs by half of its
+// size at once, so the records freed one by one by the epoch actions are
+// returned to the slabs in bulk. The magazines are shared when there are more
+// threads than magazines.
+//
+// A slab whose blocks are all free is kept until ReleaseEmptySlabs() is
+// called, which returns it to the OS.
+class SlabPool {
+ public:
+  static constexpr std::size_t c_slabSize = 64U * 1024U;
+  static constexpr std::size_t c_maxBlockSize = 1024U;
+  static constexpr std::uint8_t c_numSizeClasses = 28U;
+  static constexpr std::uint32_t c_numMagazines = 16U;
+  static constexpr std::uint32_t c_magazineSize = 32U;
+
+  SlabPool() = default;
+
+  ~SlabPool() {
+    for (auto& sizeClass : m_sizeClasses) {
+      for (auto* slab : sizeClass.m_slabs) {
+        boost::alignment::aligned_free(slab);
+      }
+    }
+  }
+
+  // Returns the size class for the given allocation size, which should be in
+  // (0, c_maxBlockSize].
+  static std::uint8_t GetSizeClass(std::size_t size) {
+    return static_cast<std::uint8_t>(
+        (size <= 256U) ? (size - 1U) / 16U : 16U + (size - 257U) / 64U);
+  }
+
+  static std::size_t GetBlockSize(std::uint8_t sizeClass) {
+    return (sizeClass < 16U) ? (sizeClass + 1U) * 16U
+                             : 256U + (sizeClass - 15U) * 64U;
+  }
+
+  void* Allocate(std::size_t size) {
+    if (size == 0U) {
+      size = 1U;
+    }
+
+    if (size > c_maxBlockSize) {
+      return AllocateLarge(size);
+    }
+
+    const auto sizeClass = GetSizeClass(size);
+    auto& magazine = GetMagazine();
+    std::lock_guard<std::mutex> lock{magazine.m_mutex};
+
+    auto& blocks = magazine.m_blocks[sizeClass];
+    auto& count = magazine.m_counts[sizeClass];
+
+    if (count == 0U) {
+      count = Refill(sizeClass, blocks.data(), c_magazineSize / 2U);
+    }
+
+    return blocks[--count];
+  }
+
+  void Deallocate(void* address) {
+    if (address == nullptr) {
+      return;
+    }
+
+    auto* slab = GetSlab(address);
+    if (slab->m_blockSize == 0U) {
+      DeallocateLarge(slab);
+      return;
+    }
+
+    auto& magazine = GetMagazine();
+    std::lock_guard<std::mutex> lock{magazine.m_mutex};
+
+    auto& blocks = magazine.m_blocks[slab->m_sizeClass];
+    auto& count = magazine.m_counts[slab->m_sizeClass];
+
+    if (count == c_magazineSize) {
+      count -= c_magazineSize / 2U;
+      Flush(slab->m_sizeClass, blocks.data() + count, c_magazineSize / 2U);
+    }
+
+    blocks[count++] = address;
+  }
+
+  // Flushes all the magazines and returns the empty slabs to the OS. Returns
+  // the number of the released slabs.
+  std::size_t ReleaseEmptySlabs() {
+    for (auto& magazine : m_magazines) {
+      std::lock_guard<std::mutex> lock{magazine.m_mutex};
+
+      for (std::uint8_t i = 0U; i < c_numSizeClasses; ++i) {
+        if (magazine.m_counts[i] != 0U) {
+          Flush(i, magazine.m_blocks[i].data(), magazine.m_counts[i]);
+          magazine.m_counts[i] = 0U;
+        }
+      }
+    }
+
+    std::size_t numReleased = 0U;
+
+    for (auto& sizeClass : m_sizeClasses) {
+      std::lock_guard<std::mutex> lock{sizeClass.m_mutex};
+
+      std::vector<Slab*> remaining;
+      for (auto* slab : sizeClass.m_slabs) {
+        if (slab->m_numUsed != 0U) {
+          remaining.push_back(slab);
+          continue;
+        }
+
+        Unlink(sizeClass, slab);
+        boost::alignment::aligned_free(slab);
+        ++numReleased;
+      }
+
+      sizeClass.m_slabs.swap(remaining);
+    }
+
+    const auto released = static_cast<AllocatorPerfData::TValue>(numReleased);
+    m_perfData.Subtract(AllocatorPerfCounter::SlabsCount, released);
+    m_perfData.Subtract(AllocatorPerfCounter::EmptySlabsCount, released);
+    m_perfData.Subtract(
+        AllocatorPerfCounter::SlabBytes,
+        released * static_cast<AllocatorPerfData::TValue>(c_slabSize));
+    m_perfData.Add(AllocatorPerfCounter::ReleasedSlabsCount, released);
+
+    return numReleased;
+  }
+
+  const AllocatorPerfData& GetPerfData() const { return m_perfData; }
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+ private:
+  // Slab struct is the header at the beginning of a slab. Since a slab is
+  // aligned to c_slabSize, the header is found by masking the address of a
+  // block. A large allocation has the same header with m_blockSize of 0.
+  struct Slab {
+    std::size_t m_blockSize;
+
+    // The number of bytes requested for a large allocation.
+    std::size_t m_largeSize;
+
+    std::uint32_t m_numBlocks;
+    std::uint32_t m_numUsed;
+    std::uint32_t m_numCarved;
+    std::uint8_t m_sizeClass;
+    void* m_freeList;
+
+    // The links in the list of the slabs with free blocks.
+    Slab* m_prev;
+    Slab* m_next;
+  };
+
+  static constexpr std::size_t c_slabHeaderSize = 64U;
+
+  static_assert(sizeof(Slab) <= c_slabHeaderSize,
+                "Slab header should fit in c_slabHeaderSize.");
+
+  // SizeClass struct holds the slabs of a size class. The slabs with free
+  // blocks are linked from m_partial.
+  struct SizeClass {
+    std::mutex m_mutex;
+    std::vector<Slab*> m_slabs;
+    Slab* m_partial = nullptr;
+  };
+
+  struct Magazine {
+    std::mutex m_mutex;
+    std::array<std::array<void*, c_magazineSize>, c_numSizeClasses> m_blocks;
+    std::array<std::uint32_t, c_numSizeClasses> m_counts{};
+  };
+
+  static Slab* GetSlab(void* address) {
+    return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(address) &
+                                   ~(c_slabSize - 1U));
+  }
+
+  // Returns the magazine assigned to the current thread in the round robin
+  // fashion.
+  Magazine& GetMagazine() {
+    static std::atomic<std::uint32_t> s_nextIndex{0U};
+    static thread_local const std::uint32_t s_index = s_nextIndex++;
+
+    return m_magazines[s_index % c_numMagazines];
+  }
+
+  // Takes up to "count" blocks out of the slabs of the given size class.
+  std::uint32_t Refill(std::uint8_t sizeClassIndex,
+                       void** blocks,
+                       std::uint32_t count) {
+    auto& sizeClass = m_sizeClasses[sizeClassIndex];
+    std::lock_guard<std::mutex> lock{sizeClass.m_mutex};
+
+    std::uint32_t numTaken = 0U;
+    while (numTaken < count) {
+      if (sizeClass.m_partial == nullptr) {
+        AddSlab(sizeClass, sizeClassIndex);
+      }
+
+      auto* slab = sizeClass.m_partial;
+      if (slab->m_numUsed == 0U) {
+        m_perfData.Decrement(AllocatorPerfCounter::EmptySlabsCount);
+      }
+
+      while (numTaken < count && slab->m_numUsed < slab->m_numBlocks) {
+        void* block = nullptr;
+        if (slab->m_freeList != nullptr) {
+          block = slab->m_freeList;
+          slab->m_freeList = *static_cast<void**>(block);
+        } else {
+          block = reinterpret_cast<std::uint8_t*>(slab) + c_slabHeaderSize +
+                  (slab->m_numCarved++ * slab->m_blockSize);
+        }
+
+        ++slab->m_numUsed;
+        blocks[numTaken++] = block;
+      }
+
+      if (slab->m_numUsed == slab->m_numBlocks) {
+        Unlink(sizeClass, slab);
+      }
+    }
+
+    m_perfData.Increment(AllocatorPerfCounter::MagazineRefillsCount);
+    m_perfData.Add(AllocatorPerfCounter::SlabBytesInUse,
+                   numTaken * GetBlockSize(sizeClassIndex));
+
+    return numTaken;
+  }
+
+  // Returns the given blocks to their slabs.
+  void Flush(std::uint8_t sizeClassIndex, void** blocks, std::uint32_t count) {
+    auto& sizeClass = m_sizeClasses[sizeClassIndex];
+    std::lock_guard<std::mutex> lock{sizeClass.m_mutex};
+
+    for (std::uint32_t i = 0U; i < count; ++i) {
+      auto* slab = GetSlab(blocks[i]);
+
+      if (slab->m_numUsed == slab->m_numBlocks) {
+        Link(sizeClass, slab);
+      }
+
+      *static_cast<void**>(blocks[i]) = slab->m_freeList;
+      slab->m_freeList = blocks[i];
+
+      if (--slab->m_numUsed == 0U) {
+        m_perfData.Increment(AllocatorPerfCounter::EmptySlabsCount);
+      }
+    }
+
+    m_perfData.Increment(AllocatorPerfCounter::MagazineFlushesCount);
+    m_perfData.Subtract(AllocatorPerfCounter::SlabBytesInUse,
+                        count * GetBlockSize(sizeClassIndex));
+  }
+
+  // Allocates a new slab for the given size class. It is assumed that this
+  // function is called under the lock of the size class.
+  void AddSlab(SizeClass& sizeClass, std::uint8_t sizeClassIndex) {
+    auto* slab = static_cast<Slab*>(
+        boost::alignment::aligned_alloc(c_slabSize, c_slabSize));
+    if (slab == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    const auto blockSize = GetBlockSize(sizeClassIndex);
+
+    *slab = Slab{blockSize,
+                 0U,
+                 static_cast<std::uint32_t>((c_slabSize - c_slabHeaderSize) /
+                                            blockSize),
+                 0U,
+                 0U,
+                 sizeClassIndex,
+                 nullptr,
+                 nullptr,
+                 nullptr};
+
+    sizeClass.m_slabs.push_back(slab);
+    Link(sizeClass, slab);
+
+    m_perfData.Increment(AllocatorPerfCounter::SlabsCount);
+    m_perfData.Increment(AllocatorPerfCounter::EmptySlabsCount);
+    m_perfData.Add(AllocatorPerfCounter::SlabBytes, c_slabSize);
+  }
+
+  static void Link(SizeClass& sizeClass, Slab* slab) {
+    slab->m_prev = nullptr;
+    slab->m_next = sizeClass.m_partial;
+    if (sizeClass.m_partial != nullptr) {
+      sizeClass.m_partial->m_prev = slab;
+    }
+    sizeClass.m_partial = slab;
+  }
+
+  static void Unlink(SizeClass& sizeClass, Slab* slab) {
+    if (slab->m_prev != nullptr) {
+      slab->m_prev->m_next = slab->m_next;
+    } else {
+      sizeClass.m_partial = slab->m_next;
+    }
+
+    if (slab->m_next != nullptr) {
+      slab->m_next->m_prev = slab->m_prev;
+    }
+
+    slab->m_prev = nullptr;
+    slab->m_next = nullptr;
+  }
+
+  // The large allocation is also aligned to c_slabSize so that its header is
+  // found in the same way as the one of a slab.
+  void* AllocateLarge(std::size_t size) {
+    auto* slab = static_cast<Slab*>(boost::alignment::aligned_alloc(
+        c_slabSize, c_slabHeaderSize + size));
+    if (slab == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    *slab = Slab{0U, size, 0U, 0U, 0U, 0U, nullptr, nullptr, nullptr};
+
+    m_perfData.Increment(AllocatorPerfCounter::LargeAllocationsCount);
+    m_perfData.Add(AllocatorPerfCounter::LargeAllocationBytes, size);
+
+    return reinterpret_cast<std::uint8_t*>(slab) + c_slabHeaderSize;
+  }
+
+  void DeallocateLarge(Slab* slab) {
+    m_perfData.Decrement(AllocatorPerfCounter::LargeAllocationsCount);
+    m_perfData.Subtract(AllocatorPerfCounter::LargeAllocationBytes,
+                        slab->m_largeSize);
+
+    boost::alignment::aligned_free(slab);
+  }
+
+  std::array<SizeClass, c_numSizeClasses> m_sizeClasses;
+
+  std::array<Magazine, c_numMagazines> m_magazines;
+
+  AllocatorPerfData m_perfData;
+};
+
+// SlabAllocator class is an allocator backed by SlabPool, which can be used as
+// the Allocator template argument of HashTableService::AddHashTable(). The
+// copies and the rebound copies of an allocator share the same pool, which is
+// kept alive until all of them are destroyed.
+template <typename T = void>
+class SlabAllocator : public std::allocator<T> {
+ public:
+  using Base = std::allocator<T>;
+  using pointer = typename Base::pointer;
+
+  template <class U>
+  struct rebind {
+    typedef SlabAllocator<U> other;
+  };
+
+  SlabAllocator() : m_pool{std::make_shared<SlabPool>()} {}
+
+  explicit SlabAllocator(std::shared_ptr<SlabPool> pool)
+      : m_pool{std::move(pool)} {}
+
+  SlabAllocator(const SlabAllocator<T>&) = default;
+
+  template <class U>
+  SlabAllocator(const SlabAllocator<U>& other) : m_pool{other.GetPool()} {}
+
+  template <class U>
+  SlabAllocator<T>& operator=(const SlabAllocator<U>& other) {
+    m_pool = other.GetPool();
+    return (*this);
+  }
+
+  pointer allocate(std::size_t count,
+                   std::allocator<void>::const_pointer /* hint */ = 0) {
+    return static_cast<pointer>(m_pool->Allocate(count * sizeof(T)));
+  }
+
+  void deallocate(pointer ptr, std::size_t /* count */) {
+    m_pool->Deallocate(ptr);
+  }
+
+  const std::shared_ptr<SlabPool>& GetPool() const { return m_pool; }
+
+ private:
+  std::shared_ptr<SlabPool> m_pool;
+};
+
+template <typename T, typename U>
+bool operator==(const SlabAllocator<T>& lhs, const SlabAllocator<U>& rhs) {
+  return lhs.GetPool() == rhs.GetPool();
+}
+
+template <typename T, typename U>
+bool operator!=(const SlabAllocator<T>& lhs, const SlabAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace LocalMemory
+}  // namespace L4
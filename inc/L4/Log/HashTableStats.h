@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace L4 {
+
+// HashTableStatsOptions struct configures the statistics pass over a hash
+// table (see IReadOnlyHashTable::GetStats()).
+struct HashTableStatsOptions {
+  explicit HashTableStatsOptions(double samplingRatio = 1.0,
+                                 std::uint16_t numThreads = 1U)
+      : m_samplingRatio{samplingRatio}, m_numThreads{numThreads} {}
+
+  // The ratio of the buckets to visit, which are sampled at a fixed stride
+  // (e.g., every 10th bucket for 0.1). 1.0 visits all the buckets.
+  double m_samplingRatio;
+
+  // The number of threads (including the calling thread) that visit disjoint
+  // ranges of the buckets.
+  std::uint16_t m_numThreads;
+};
+
+// HashTableStats struct holds the statistics collected by a pass over the
+// buckets of a hash table, which tell how well the records are distributed
+// (e.g., to size the number of buckets). Unlike HashTablePerfData, it is
+// computed on demand without taking the locks, thus it is a snapshot that may
+// be slightly off while the writers are running. When the buckets are sampled,
+// all the values are of the sampled buckets only.
+struct HashTableStats {
+  // The number of buckets visited and how many of them have no records.
+  std::uint64_t m_numBuckets = 0U;
+  std::uint64_t m_numEmptyBuckets = 0U;
+
+  std::uint64_t m_numRecords = 0U;
+
+  // The i-th element is the number of buckets whose chain has i entries
+  // (including the head entry in the bucket array).
+  std::vector<std::uint64_t> m_chainLengthHistogram;
+
+  // The i-th element is the number of entries with i occupied slots.
+  std::vector<std::uint64_t> m_slotOccupancyHistogram;
+
+  // The i-th element is the number of records whose key and value size adds up
+  // to [2^i, 2^(i+1)) bytes, where the first one also counts the empty ones.
+  std::vector<std::uint64_t> m_recordSizeHistogram;
+
+  // The number of key comparisons that fail on a tag match when each record is
+  // looked up once, i.e., the sum over the records of the number of records
+  // preceding it in its chain with the same tag.
+  std::uint64_t m_numTagFalsePositives = 0U;
+
+  double GetEmptyBucketRatio() const {
+    return (m_numBuckets != 0U)
+               ? static_cast<double>(m_numEmptyBuckets) / m_numBuckets
+               : 0.0;
+  }
+
+  // Returns the average number of failed key comparisons per lookup of an
+  // existing key.
+  double GetTagFalsePositiveRate() const {
+    return (m_numRecords != 0U)
+               ? static_cast<double>(m_numTagFalsePositives) / m_numRecords
+               : 0.0;
+  }
+
+  void AddBucket(std::size_t chainLength, bool isEmpty) {
+    ++m_numBuckets;
+    m_numEmptyBuckets += isEmpty ? 1U : 0U;
+    Increment(m_chainLengthHistogram, chainLength);
+  }
+
+  void AddEntry(std::size_t numOccupiedSlots) {
+    Increment(m_slotOccupancyHistogram, numOccupiedSlots);
+  }
+
+  void AddRecord(std::uint64_t recordSize) {
+    ++m_numRecords;
+
+    std::size_t index = 0U;
+    while (recordSize > 1U) {
+      recordSize >>= 1U;
+      ++index;
+    }
+
+    Increment(m_recordSizeHistogram, index);
+  }
+
+  // Adds the given stats to this, which is used to combine the stats
+  // collected by multiple threads.
+  void Merge(const HashTableStats& other) {
+    m_numBuckets += other.m_numBuckets;
+    m_numEmptyBuckets += other.m_numEmptyBuckets;
+    m_numRecords += other.m_numRecords;
+    m_numTagFalsePositives += other.m_numTagFalsePositives;
+
+    Merge(m_chainLengthHistogram, other.m_chainLengthHistogram);
+    Merge(m_slotOccupancyHistogram, other.m_slotOccupancyHistogram);
+    Merge(m_recordSizeHistogram, other.m_recordSizeHistogram);
+  }
+
+ private:
+  static void Increment(std::vector<std::uint64_t>& histogram,
+                        std::size_t index) {
+    if (index >= histogram.size()) {
+      histogram.resize(index + 1U, 0U);
+    }
+
+    ++histogram[index];
+  }
+
+  static void Merge(std::vector<std::uint64_t>& histogram,
+                    const std::vector<std::uint64_t>& other) {
+    histogram.resize((std::max)(histogram.size(), other.size()), 0U);
+
+    for (std::size_t i = 0U; i < other.size(); ++i) {
+      histogram[i] += other[i];
+    }
+  }
+};
+
+}  // namespace L4
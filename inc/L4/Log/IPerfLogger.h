@@ -1,6 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <map>
+#include <string>
+#include "HashTableStats.h"
 #include "PerfCounter.h"
 
 namespace L4 {
@@ -14,18 +17,23 @@ struct IPerfLogger {
   virtual void Log(const IData& data) = 0;
 };
 
-// IPerfLogger::IData interface that provides access to ServerPerfData and the
-// aggregated HashTablePerfData. Note that the user of IPerfLogger only needs to
-// implement IPerfLogger since IPerfLogger::IData is implemented internally.
+// IPerfLogger::IData interface that provides access to ServerPerfData, the
+// aggregated HashTablePerfData and the HashTableStats collected on demand (see
+// IReadOnlyHashTable::GetStats()). Note that the user of IPerfLogger only needs
+// to implement IPerfLogger since IPerfLogger::IData is implemented internally.
 struct IPerfLogger::IData {
   using HashTablesPerfData =
       std::map<std::string, std::reference_wrapper<const HashTablePerfData>>;
+  using HashTablesStats =
+      std::map<std::string, std::reference_wrapper<const HashTableStats>>;
 
   virtual ~IData() = default;
 
   virtual const ServerPerfData& GetServerPerfData() const = 0;
 
   virtual const HashTablesPerfData& GetHashTablesPerfData() const = 0;
+
+  virtual const HashTablesStats& GetHashTablesStats() const = 0;
 };
 
 }  // namespace L4
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 
@@ -50,11 +51,28 @@ enum class HashTablePerfCounter : std::uint16_t {
   RecordsCountLoadedFromSerializer,
   RecordsCountSavedFromSerializer,
 
+  // The number of key comparisons that failed although the tag matched.
+  TagFalsePositiveCount,
+
+  // The number of bytes of the bucket array that are backed by huge pages
+  // (see HashTableConfig::Setting::m_hugePages).
+  HugePageBytes,
+
   // CacheHashTable specific counters.
   CacheHitCount,
   CacheMissCount,
   EvictedRecordsCount,
 
+  // The records evicted by IWritableHashTable::EvictToWatermark(), which are
+  // also counted in EvictedRecordsCount.
+  BackgroundEvictedRecordsCount,
+
+  // The number of the writes that evicted inline since the cache was full,
+  // and the total time the writers spent on it (including waiting for the
+  // other evicting writers).
+  InlineEvictionsCount,
+  InlineEvictionMicroseconds,
+
   Count
 };
 
@@ -73,9 +91,38 @@ const std::array<const char*,
                                    "MaxBucketChainLength",
                                    "RecordsCountLoadedFromSerializer",
                                    "RecordsCountSavedFromSerializer",
+                                   "TagFalsePositiveCount",
+                                   "HugePageBytes",
                                    "CacheHitCount",
                                    "CacheMissCount",
-                                   "EvictedRecordsCount"};
+                                   "EvictedRecordsCount",
+                                   "BackgroundEvictedRecordsCount",
+                                   "InlineEvictionsCount",
+                                   "InlineEvictionMicroseconds"};
+
+// Counters of LocalMemory::SlabPool. The fragmentation of the slabs is
+// (SlabBytes - SlabBytesInUse) / SlabBytes, where SlabBytesInUse includes the
+// blocks cached in the per-thread magazines.
+enum class AllocatorPerfCounter : std::uint16_t {
+  SlabsCount = 0U,
+  EmptySlabsCount,
+  SlabBytes,
+  SlabBytesInUse,
+  ReleasedSlabsCount,
+  LargeAllocationsCount,
+  LargeAllocationBytes,
+  MagazineRefillsCount,
+  MagazineFlushesCount,
+
+  Count
+};
+
+const std::array<const char*,
+                 static_cast<std::uint16_t>(AllocatorPerfCounter::Count)>
+    c_allocatorPerfCounterNames = {
+        "SlabsCount",           "EmptySlabsCount",      "SlabBytes",
+        "SlabBytesInUse",       "ReleasedSlabsCount",   "LargeAllocationsCount",
+        "LargeAllocationBytes", "MagazineRefillsCount", "MagazineFlushesCount"};
 
 template <typename TCounterEnum>
 class PerfCounters {
@@ -171,9 +218,109 @@ class PerfCounters {
 #endif
 };
 
+// ShardedPerfCounters class keeps each counter in c_numShards shards, so that
+// the threads updating the same counter do not contend on the same cache line.
+// Each thread is assigned one of the shards in the round robin fashion, and the
+// value of a counter is the sum of its shards; thus Get() is more expensive
+// than the update. Only the counters that are added to or subtracted from
+// should be sharded, since Max() and Min() cannot be split into the shards.
+template <typename TCounterEnum>
+class ShardedPerfCounters {
+ public:
+  typedef std::int64_t TValue;
+  typedef std::atomic<TValue> TCounter;
+
+  static constexpr std::uint32_t c_numShards = 16U;
+
+  ShardedPerfCounters() {
+    for (auto& shard : m_shards) {
+      std::for_each(std::begin(shard.m_counters), std::end(shard.m_counters),
+                    [](TCounter& counter) { counter = 0; });
+    }
+  }
+
+  TValue Get(TCounterEnum counterEnum) const {
+    TValue value = 0;
+    for (const auto& shard : m_shards) {
+      value += shard.m_counters[static_cast<std::uint16_t>(counterEnum)].load(
+          std::memory_order_relaxed);
+    }
+    return value;
+  }
+
+  // Note that Set() is not atomic with respect to the concurrent updates.
+  void Set(TCounterEnum counterEnum, TValue value) {
+    for (auto& shard : m_shards) {
+      shard.m_counters[static_cast<std::uint16_t>(counterEnum)].store(
+          (&shard == &m_shards[0]) ? value : 0, std::memory_order_relaxed);
+    }
+  }
+
+  void Increment(TCounterEnum counterEnum) { Add(counterEnum, 1); }
+
+  void Decrement(TCounterEnum counterEnum) { Subtract(counterEnum, 1); }
+
+  void Add(TCounterEnum counterEnum, TValue value) {
+    if (value != 0) {
+      GetShard().m_counters[static_cast<std::uint16_t>(counterEnum)].fetch_add(
+          value, std::memory_order_relaxed);
+    }
+  }
+
+  void Subtract(TCounterEnum counterEnum, TValue value) {
+    if (value != 0) {
+      GetShard().m_counters[static_cast<std::uint16_t>(counterEnum)].fetch_sub(
+          value, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  static constexpr std::size_t c_numCounters =
+      static_cast<std::size_t>(TCounterEnum::Count);
+
+  static constexpr std::size_t c_cacheLineSize = 64U;
+
+  // Each shard is padded to the multiple of the cache line size. Note that
+  // alignas() is not used since the perf counters can be in the memory from an
+  // allocator that does not support the over-aligned types.
+  struct Shard {
+    TCounter m_counters[c_numCounters];
+    char m_padding[c_cacheLineSize -
+                   (c_numCounters * sizeof(TCounter)) % c_cacheLineSize];
+  };
+
+  Shard& GetShard() {
+    static std::atomic<std::uint32_t> s_nextIndex{0U};
+    static thread_local const std::uint32_t s_index = s_nextIndex++;
+
+    return m_shards[s_index % c_numShards];
+  }
+
+  Shard m_shards[c_numShards];
+};
+
 typedef PerfCounters<ServerPerfCounter> ServerPerfData;
 
+typedef PerfCounters<AllocatorPerfCounter> AllocatorPerfData;
+
+// The counters updated on the read path (CacheHitCount, CacheMissCount and
+// TagFalsePositiveCount) are always zero if L4_DISABLE_READ_PATH_PERF_COUNTERS
+// is defined, which removes their updates from Get().
+#if defined(L4_DISABLE_READ_PATH_PERF_COUNTERS)
+constexpr bool c_readPathPerfCountersEnabled = false;
+#else
+constexpr bool c_readPathPerfCountersEnabled = true;
+#endif
+
+// HashTablePerfData keeps the counters that are only added to or subtracted
+// from (e.g., RecordsCount or CacheHitCount) in ShardedPerfCounters, since they
+// are updated on every Get() or Add(). The other counters, which are set or
+// updated by Max()/Min(), are kept in PerfCounters. Note that the methods below
+// hide the ones of PerfCounters, thus the counters should not be accessed
+// through the base class.
 struct HashTablePerfData : public PerfCounters<HashTablePerfCounter> {
+  using Base = PerfCounters<HashTablePerfCounter>;
+
   HashTablePerfData() {
     // Initialize any min counters to the max value.
     constexpr auto maxValue =
@@ -186,6 +333,71 @@ struct HashTablePerfData : public PerfCounters<HashTablePerfCounter> {
     // contains the entry which stores the data.
     Set(HashTablePerfCounter::MaxBucketChainLength, 1);
   }
+
+  TValue Get(HashTablePerfCounter counterEnum) const {
+    return IsSharded(counterEnum) ? m_shardedCounters.Get(counterEnum)
+                                  : Base::Get(counterEnum);
+  }
+
+  void Set(HashTablePerfCounter counterEnum, TValue value) {
+    if (IsSharded(counterEnum)) {
+      m_shardedCounters.Set(counterEnum, value);
+    } else {
+      Base::Set(counterEnum, value);
+    }
+  }
+
+  void Increment(HashTablePerfCounter counterEnum) { Add(counterEnum, 1); }
+
+  void Decrement(HashTablePerfCounter counterEnum) {
+    Subtract(counterEnum, 1);
+  }
+
+  void Add(HashTablePerfCounter counterEnum, TValue value) {
+    if (!IsEnabled(counterEnum)) {
+      return;
+    }
+
+    if (IsSharded(counterEnum)) {
+      m_shardedCounters.Add(counterEnum, value);
+    } else {
+      Base::Add(counterEnum, value);
+    }
+  }
+
+  void Subtract(HashTablePerfCounter counterEnum, TValue value) {
+    if (IsSharded(counterEnum)) {
+      m_shardedCounters.Subtract(counterEnum, value);
+    } else {
+      Base::Subtract(counterEnum, value);
+    }
+  }
+
+  static constexpr bool IsSharded(HashTablePerfCounter counterEnum) {
+    return counterEnum == HashTablePerfCounter::RecordsCount ||
+           counterEnum == HashTablePerfCounter::TotalKeySize ||
+           counterEnum == HashTablePerfCounter::TotalValueSize ||
+           counterEnum == HashTablePerfCounter::TotalIndexSize ||
+           counterEnum == HashTablePerfCounter::ChainingEntriesCount ||
+           counterEnum ==
+               HashTablePerfCounter::RecordsCountLoadedFromSerializer ||
+           counterEnum ==
+               HashTablePerfCounter::RecordsCountSavedFromSerializer ||
+           counterEnum == HashTablePerfCounter::TagFalsePositiveCount ||
+           counterEnum == HashTablePerfCounter::CacheHitCount ||
+           counterEnum == HashTablePerfCounter::CacheMissCount ||
+           counterEnum == HashTablePerfCounter::EvictedRecordsCount;
+  }
+
+  static constexpr bool IsEnabled(HashTablePerfCounter counterEnum) {
+    return c_readPathPerfCountersEnabled ||
+           (counterEnum != HashTablePerfCounter::CacheHitCount &&
+            counterEnum != HashTablePerfCounter::CacheMissCount &&
+            counterEnum != HashTablePerfCounter::TagFalsePositiveCount);
+  }
+
+ private:
+  ShardedPerfCounters<HashTablePerfCounter> m_shardedCounters;
 };
 
 }  // namespace L4
@@ -8,7 +8,8 @@ struct PerfLoggerManagerConfig;
 
 // PerfData class, which holds the ServerPerfData and HashTablePerfData for each
 // hash table. Note that PerfData owns the ServerPerfData but has only the const
-// references to HashTablePerfData, which is owned by the HashTable.
+// references to HashTablePerfData, which is owned by the HashTable, and to
+// HashTableStats, which is owned by the caller.
 
 class PerfData : public IPerfLogger::IData {
  public:
@@ -23,12 +24,18 @@ class PerfData : public IPerfLogger::IData {
   void AddHashTablePerfData(const char* hashTableName,
                             const HashTablePerfData& perfData);
 
+  const HashTablesStats& GetHashTablesStats() const override;
+
+  void AddHashTableStats(const char* hashTableName,
+                         const HashTableStats& stats);
+
   PerfData(const PerfData&) = delete;
   PerfData& operator=(const PerfData&) = delete;
 
  private:
   ServerPerfData m_serverPerfData;
   HashTablesPerfData m_hashTablesPerfData;
+  HashTablesStats m_hashTablesStats;
 };
 
 // PerfData inline implementations.
@@ -46,4 +53,8 @@ inline const PerfData::HashTablesPerfData& PerfData::GetHashTablesPerfData()
   return m_hashTablesPerfData;
 }
 
+inline const PerfData::HashTablesStats& PerfData::GetHashTablesStats() const {
+  return m_hashTablesStats;
+}
+
 }  // namespace L4
\ No newline at end of file
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "Utils/Math.h"
+#include "detail/ToRawPointer.h"
+
+#if defined(_MSC_VER)
+#include "Utils/Windows.h"
+#endif
+
+#if defined(__GNUC__)
+#include <sys/mman.h>
+#endif
+
+namespace L4 {
+namespace Utils {
+
+// HugePages struct provides functions to allocate memory backed by huge pages,
+// which reduces the TLB misses when randomly accessing a large bucket array.
+// The allocation tries the following in order and falls back gracefully:
+//    1) explicit huge pages (MAP_HUGETLB on Linux, MEM_LARGE_PAGES on
+//    Windows), using 1GB pages for an allocation of at least 1GB and 2MB pages
+//    otherwise. This requires the huge pages to be reserved by the system.
+//    2) transparent huge pages (madvise(MADV_HUGEPAGE) on Linux) over a region
+//    aligned to 2MB, which are used if the system has them enabled.
+//    3) regular pages.
+// Since the memory is mapped in units of the huge page size, it should be used
+// only for large allocations.
+struct HugePages {
+  static constexpr std::size_t c_hugePageSize = 2U * 1024U * 1024U;
+  static constexpr std::size_t c_giganticPageSize = 1024U * 1024U * 1024U;
+
+  // Allocates the memory of the given size. Throws std::bad_alloc if even the
+  // regular pages cannot be allocated.
+  static void* Allocate(std::size_t size) {
+    auto* header = Map(size + sizeof(Header));
+    if (header == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    header->m_size = size;
+    return header + 1;
+  }
+
+  // Deallocates the memory returned by Allocate().
+  static void Free(void* address) {
+    auto* header = static_cast<Header*>(address) - 1;
+    Unmap(header->m_base, header->m_mappedSize);
+  }
+
+  // Returns the number of bytes of the memory returned by Allocate() that are
+  // actually backed by huge pages. For the transparent huge pages, the kernel
+  // decides whether (and when) the pages are promoted, so the value is read
+  // from /proc/self/smaps.
+  static std::size_t GetHugePageBytes(const void* address) {
+    const auto* header = static_cast<const Header*>(address) - 1;
+    const auto size =
+        static_cast<std::size_t>(Math::RoundUp(header->m_size, 4096U));
+
+    switch (header->m_backing) {
+      case Backing::Explicit:
+        return size;
+      case Backing::Transparent:
+        return (std::min)(GetTransparentHugePageBytes(header), size);
+      default:
+        return 0U;
+    }
+  }
+
+ private:
+  enum class Backing : std::uint8_t { Regular, Transparent, Explicit };
+
+  // Header is placed right before the memory returned by Allocate(). It is 64
+  // bytes so that the returned memory stays aligned to the cache line.
+  struct alignas(64) Header {
+    void* m_base;
+    std::size_t m_mappedSize;
+    std::size_t m_size;
+    Backing m_backing;
+  };
+
+  static_assert(sizeof(Header) == 64, "Header should be 64 bytes.");
+
+#if defined(_MSC_VER)
+  static Header* Map(std::size_t size) {
+    const auto largePageSize = ::GetLargePageMinimum();
+    if (largePageSize != 0U) {
+      const auto mappedSize =
+          static_cast<std::size_t>(Math::RoundUp(size, largePageSize));
+      auto* base = ::VirtualAlloc(nullptr, mappedSize,
+                                  MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                  PAGE_READWRITE);
+      if (base != nullptr) {
+        return new (base) Header{base, mappedSize, 0U, Backing::Explicit};
+      }
+    }
+
+    auto* base = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                                PAGE_READWRITE);
+    return (base != nullptr)
+               ? new (base) Header{base, size, 0U, Backing::Regular}
+               : nullptr;
+  }
+
+  static void Unmap(void* base, std::size_t) {
+    ::VirtualFree(base, 0U, MEM_RELEASE);
+  }
+
+  static std::size_t GetTransparentHugePageBytes(const Header*) { return 0U; }
+#else
+  static Header* Map(std::size_t size) {
+#if defined(MAP_HUGETLB)
+    for (const auto pageSize : {c_giganticPageSize, c_hugePageSize}) {
+      if (pageSize == c_giganticPageSize && size < c_giganticPageSize) {
+        continue;
+      }
+
+      int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+      flags |= (pageSize == c_giganticPageSize) ? (30 << MAP_HUGE_SHIFT)
+                                                : (21 << MAP_HUGE_SHIFT);
+#endif
+      const auto mappedSize =
+          static_cast<std::size_t>(Math::RoundUp(size, pageSize));
+      auto* base = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, flags,
+                          -1, 0);
+      if (base != MAP_FAILED) {
+        return new (base) Header{base, mappedSize, 0U, Backing::Explicit};
+      }
+    }
+#endif
+
+    // Map one more huge page so that the region can be aligned to the huge
+    // page size, which the transparent huge pages require.
+    const auto alignedSize =
+        static_cast<std::size_t>(Math::RoundUp(size, c_hugePageSize));
+    const auto mappedSize = alignedSize + c_hugePageSize;
+    auto* base = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      return nullptr;
+    }
+
+    auto* aligned = reinterpret_cast<void*>(Math::RoundUp(
+        reinterpret_cast<std::uintptr_t>(base), c_hugePageSize));
+
+    auto backing = Backing::Regular;
+#if defined(MADV_HUGEPAGE)
+    if (::madvise(aligned, alignedSize, MADV_HUGEPAGE) == 0) {
+      backing = Backing::Transparent;
+    }
+#endif
+
+    return new (aligned) Header{base, mappedSize, 0U, backing};
+  }
+
+  static void Unmap(void* base, std::size_t mappedSize) {
+    ::munmap(base, mappedSize);
+  }
+
+  // Sums up AnonHugePages of the mapping containing the given header.
+  static std::size_t GetTransparentHugePageBytes(const Header* header) {
+    const auto address = reinterpret_cast<std::uintptr_t>(header);
+
+    std::ifstream smaps{"/proc/self/smaps"};
+    std::string line;
+    bool isInMapping = false;
+    std::size_t hugePageBytes = 0U;
+
+    while (std::getline(smaps, line)) {
+      unsigned long long start = 0U;
+      unsigned long long end = 0U;
+      if (std::sscanf(line.c_str(), "%llx-%llx", &start, &end) == 2) {
+        // A new mapping starts. The mapping can be split by the kernel, thus
+        // all the mappings overlapping with the memory are summed up.
+        isInMapping = start < address + header->m_size + sizeof(Header) &&
+                      end > address;
+        continue;
+      }
+
+      unsigned long long kiloBytes = 0U;
+      if (isInMapping &&
+          std::sscanf(line.c_str(), "AnonHugePages: %llu kB", &kiloBytes) ==
+              1) {
+        hugePageBytes += static_cast<std::size_t>(kiloBytes * 1024U);
+      }
+    }
+
+    return hugePageBytes;
+  }
+#endif
+};
+
+// HugePageAllocator class wraps the given allocator so that the memory is
+// allocated by HugePages when enabled. This is used for the bucket arrays,
+// which are allocated once and accessed randomly. Note that the memory from
+// HugePages is private to the process, thus it should not be enabled with the
+// shared memory allocators.
+template <typename Allocator>
+class HugePageAllocator : public Allocator {
+ public:
+  using value_type = typename Allocator::value_type;
+  using pointer = typename Allocator::pointer;
+  using size_type = typename Allocator::size_type;
+
+  // Hides the version of the wrapped allocator so that the containers do not
+  // bypass allocate() with the version 2 allocation commands.
+  using version = std::integral_constant<unsigned, 1U>;
+
+  template <typename U>
+  struct rebind {
+    typedef HugePageAllocator<typename Allocator::template rebind<U>::other>
+        other;
+  };
+
+  HugePageAllocator() = default;
+
+  HugePageAllocator(const Allocator& allocator, bool useHugePages)
+      : Allocator(allocator), m_useHugePages{useHugePages} {}
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>& other)
+      : Allocator(static_cast<const U&>(other)),
+        m_useHugePages{other.UsesHugePages()} {}
+
+  pointer allocate(size_type count) {
+    if (!m_useHugePages) {
+      return Allocator::allocate(count);
+    }
+
+    return pointer(static_cast<value_type*>(
+        HugePages::Allocate(count * sizeof(value_type))));
+  }
+
+  void deallocate(pointer ptr, size_type count) {
+    if (!m_useHugePages) {
+      Allocator::deallocate(ptr, count);
+      return;
+    }
+
+    HugePages::Free(Detail::to_raw_pointer(ptr));
+  }
+
+  // Returns the number of bytes of the given memory allocated by this
+  // allocator that are backed by huge pages.
+  std::size_t GetHugePageBytes(const value_type* ptr) const {
+    return (m_useHugePages && ptr != nullptr) ? HugePages::GetHugePageBytes(ptr)
+                                              : 0U;
+  }
+
+  bool UsesHugePages() const { return m_useHugePages; }
+
+  bool operator==(const HugePageAllocator& other) const {
+    return static_cast<const Allocator&>(*this) ==
+               static_cast<const Allocator&>(other) &&
+           m_useHugePages == other.m_useHugePages;
+  }
+
+  bool operator!=(const HugePageAllocator& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  bool m_useHugePages = false;
+};
+
+}  // namespace Utils
+}  // namespace L4
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "Utils/Prefetch.h"
+
 #if defined(_MSC_VER)
 
+#include <intrin.h>
 #include "Utils/Windows.h"
 
+#pragma comment(lib, "Synchronization.lib")
+
 #else
 #if defined(__GNUC__)
 
@@ -12,6 +20,12 @@
 #endif
 #endif
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace L4 {
 namespace Utils {
 
@@ -51,6 +65,10 @@ class ReaderWriterLockSlim {
   // Acquires an SRW lock in exclusive mode.
   void lock() { ::AcquireSRWLockExclusive(&m_lock); }
 
+  // Attempts to acquire an SRW lock in exclusive mode. Returns true if
+  // acquired.
+  bool try_lock() { return !!::TryAcquireSRWLockExclusive(&m_lock); }
+
   // Releases an SRW lock that was opened in shared mode.
   void unlock_shared() { ::ReleaseSRWLockShared(&m_lock); }
 
@@ -92,6 +110,8 @@ class ReaderWriterLockSlim {
 
   void lock() { pthread_rwlock_wrlock(&m_lock); }
 
+  bool try_lock() { return pthread_rwlock_trywrlock(&m_lock) == 0; }
+
   void unlock_shared() { pthread_rwlock_unlock(&m_lock); }
 
   void unlock() { unlock_shared(); }
@@ -103,5 +123,181 @@ class ReaderWriterLockSlim {
 #endif
 #endif
 
+// Hints the CPU that the calling thread is spinning on a lock.
+inline void CpuRelax() {
+#if defined(_MSC_VER)
+  ::YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Spins with CpuRelax() for the first c_numSpins calls and yields the thread
+// afterwards, so that a waiter does not burn its time slice while the holder
+// is preempted (e.g., when there are more threads than the CPUs).
+class Backoff {
+ public:
+  void operator()() {
+    if (m_numSpins < c_numSpins) {
+      ++m_numSpins;
+      CpuRelax();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  static constexpr std::uint32_t c_numSpins = 128U;
+
+  std::uint32_t m_numSpins = 0U;
+};
+
+// The following locks are the alternatives to ReaderWriterLockSlim for the
+// bucket mutexes (see HashTableConfig::BucketLock), which are only taken
+// exclusively by the writers for short critical sections. Each of them is
+// padded to a cache line so that the adjacent locks in an array do not share
+// a cache line.
+
+// SpinLock is a test-and-test-and-set spin lock, which is the cheapest to
+// acquire when the lock is rarely contended.
+class SpinLock {
+ public:
+  SpinLock() = default;
+  SpinLock(const SpinLock& other) = delete;
+  SpinLock& operator=(const SpinLock& other) = delete;
+
+  void lock() {
+    Backoff backoff;
+    while (m_locked.exchange(true, std::memory_order_acquire)) {
+      while (m_locked.load(std::memory_order_relaxed)) {
+        backoff();
+      }
+    }
+  }
+
+  bool try_lock() {
+    return !m_locked.load(std::memory_order_relaxed) &&
+           !m_locked.exchange(true, std::memory_order_acquire);
+  }
+
+  void unlock() { m_locked.store(false, std::memory_order_release); }
+
+ private:
+  std::atomic<bool> m_locked{false};
+  char m_padding[c_cacheLineSize - sizeof(std::atomic<bool>)];
+};
+
+// TicketLock grants the lock in the FIFO order, which keeps the waiting time
+// fair under contention at the cost of the waiters spinning on the same cache
+// line.
+class TicketLock {
+ public:
+  TicketLock() = default;
+  TicketLock(const TicketLock& other) = delete;
+  TicketLock& operator=(const TicketLock& other) = delete;
+
+  void lock() {
+    const auto ticket = m_next.fetch_add(1U, std::memory_order_relaxed);
+    Backoff backoff;
+    while (m_serving.load(std::memory_order_acquire) != ticket) {
+      backoff();
+    }
+  }
+
+  bool try_lock() {
+    auto serving = m_serving.load(std::memory_order_acquire);
+    return m_next.compare_exchange_strong(serving, serving + 1U,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock() {
+    m_serving.store(m_serving.load(std::memory_order_relaxed) + 1U,
+                    std::memory_order_release);
+  }
+
+ private:
+  std::atomic<std::uint32_t> m_next{0U};
+  std::atomic<std::uint32_t> m_serving{0U};
+  char m_padding[c_cacheLineSize - 2U * sizeof(std::atomic<std::uint32_t>)];
+};
+
+// AdaptiveLock spins for a while and then sleeps on a futex (WaitOnAddress on
+// Windows) until the lock is released, so that the waiters do not burn the
+// CPU when the lock is held for long (e.g., the holder is preempted).
+class AdaptiveLock {
+ public:
+  AdaptiveLock() = default;
+  AdaptiveLock(const AdaptiveLock& other) = delete;
+  AdaptiveLock& operator=(const AdaptiveLock& other) = delete;
+
+  void lock() {
+    for (std::uint32_t i = 0U; i < c_numSpins; ++i) {
+      if (m_state.load(std::memory_order_relaxed) == c_unlocked && try_lock()) {
+        return;
+      }
+      CpuRelax();
+    }
+
+    // Mark the lock as contended so that the holder wakes up a waiter.
+    while (m_state.exchange(c_contended, std::memory_order_acquire) !=
+           c_unlocked) {
+      Wait();
+    }
+  }
+
+  bool try_lock() {
+    auto expected = c_unlocked;
+    return m_state.compare_exchange_strong(expected, c_locked,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed);
+  }
+
+  void unlock() {
+    if (m_state.exchange(c_unlocked, std::memory_order_release) ==
+        c_contended) {
+      Wake();
+    }
+  }
+
+ private:
+  static constexpr std::uint32_t c_unlocked = 0U;
+  static constexpr std::uint32_t c_locked = 1U;
+  static constexpr std::uint32_t c_contended = 2U;
+
+  static constexpr std::uint32_t c_numSpins = 128U;
+
+  // Waits while the lock is contended.
+  void Wait() {
+#if defined(_MSC_VER)
+    auto contended = c_contended;
+    ::WaitOnAddress(&m_state, &contended, sizeof(contended), INFINITE);
+#elif defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_state),
+              FUTEX_WAIT_PRIVATE, c_contended, nullptr, nullptr, 0);
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  // Wakes up one of the waiters.
+  void Wake() {
+#if defined(_MSC_VER)
+    ::WakeByAddressSingle(&m_state);
+#elif defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_state),
+              FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+  }
+
+  static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+                "The futex requires the state to be a plain 32-bit integer.");
+
+  std::atomic<std::uint32_t> m_state{c_unlocked};
+  char m_padding[c_cacheLineSize - sizeof(std::atomic<std::uint32_t>)];
+};
+
 }  // namespace Utils
 }  // namespace L4
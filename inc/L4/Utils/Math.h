@@ -4,6 +4,10 @@
 #include <cstddef>
 #include <cstdint>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace L4 {
 namespace Utils {
 namespace Math {
@@ -35,6 +39,17 @@ inline std::uint32_t NextHighestPowerOfTwo(std::uint32_t val) {
   return ++val;
 }
 
+// Returns the number of trailing zero bits of the given non-zero value.
+inline std::uint32_t CountTrailingZeros(std::uint32_t val) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  ::_BitScanForward(&index, val);
+  return index;
+#else
+  return __builtin_ctz(val);
+#endif
+}
+
 // Provides utility functions doing pointer related arithmetics.
 namespace PointerArithmetic {
 
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include "Utils/Windows.h"
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace L4 {
+namespace Utils {
+
+// INumaTopology interface describes the NUMA nodes of the machine. It is an
+// interface so that the topology can be simulated (e.g., in the unit tests on
+// a single node machine).
+struct INumaTopology {
+  virtual ~INumaTopology() = default;
+
+  // Returns the number of the NUMA nodes, which is at least 1.
+  virtual std::uint32_t GetNumNodes() const = 0;
+
+  // Returns the node that the calling thread is running on, which is less than
+  // GetNumNodes().
+  virtual std::uint32_t GetCurrentNode() const = 0;
+
+  // Runs the given function on a thread bound to the given node and waits for
+  // it to finish, so that the memory first touched by the function is placed on
+  // the node. The exception thrown by the function is rethrown.
+  virtual void RunOnNode(std::uint32_t node,
+                         const std::function<void()>& func) const = 0;
+};
+
+// NumaTopology class is the INumaTopology of the machine. The topology is read
+// once when constructed. If it cannot be read, the machine is regarded as a
+// single node.
+class NumaTopology : public INumaTopology {
+ public:
+  NumaTopology() { Load(); }
+
+  std::uint32_t GetNumNodes() const override {
+    return static_cast<std::uint32_t>(m_nodeCpus.size());
+  }
+
+  std::uint32_t GetCurrentNode() const override {
+    if (m_nodeCpus.size() == 1U) {
+      return 0U;
+    }
+
+#if defined(_MSC_VER)
+    ::PROCESSOR_NUMBER processor;
+    ::GetCurrentProcessorNumberEx(&processor);
+
+    ::USHORT node = 0U;
+    return ::GetNumaProcessorNodeEx(&processor, &node) ? node : 0U;
+#elif defined(__linux__)
+    const auto cpu = ::sched_getcpu();
+    return (cpu >= 0 && static_cast<std::size_t>(cpu) < m_cpuNodes.size())
+               ? m_cpuNodes[cpu]
+               : 0U;
+#else
+    return 0U;
+#endif
+  }
+
+  void RunOnNode(std::uint32_t node,
+                 const std::function<void()>& func) const override {
+    if (m_nodeCpus.size() == 1U) {
+      func();
+      return;
+    }
+
+    std::exception_ptr exception;
+
+    std::thread thread{[this, node, &func, &exception]() {
+      try {
+        Bind(node);
+        func();
+      } catch (...) {
+        exception = std::current_exception();
+      }
+    }};
+    thread.join();
+
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+ private:
+#if defined(_MSC_VER)
+  void Load() {
+    ::ULONG highestNode = 0U;
+    if (!::GetNumaHighestNodeNumber(&highestNode)) {
+      highestNode = 0U;
+    }
+
+    m_nodeCpus.resize(highestNode + 1U);
+  }
+
+  void Bind(std::uint32_t node) const {
+    ::GROUP_AFFINITY affinity{};
+    if (::GetNumaNodeProcessorMaskEx(static_cast<::USHORT>(node), &affinity)) {
+      ::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, nullptr);
+    }
+  }
+#elif defined(__linux__)
+  // Reads the CPUs of each node from /sys/devices/system/node/node<N>/cpulist,
+  // which is a comma separated list of ranges (e.g., "0-7,16-23").
+  void Load() {
+    for (std::uint32_t node = 0U;; ++node) {
+      std::ifstream cpuList{"/sys/devices/system/node/node" +
+                            std::to_string(node) + "/cpulist"};
+      if (!cpuList) {
+        break;
+      }
+
+      std::vector<std::uint32_t> cpus;
+      std::string range;
+      while (std::getline(cpuList, range, ',')) {
+        unsigned first = 0U;
+        unsigned last = 0U;
+        const auto numParsed =
+            std::sscanf(range.c_str(), "%u-%u", &first, &last);
+        if (numParsed < 1) {
+          continue;
+        }
+
+        for (auto cpu = first; cpu <= (numParsed == 2 ? last : first); ++cpu) {
+          cpus.push_back(cpu);
+
+          if (cpu >= m_cpuNodes.size()) {
+            m_cpuNodes.resize(cpu + 1U, 0U);
+          }
+          m_cpuNodes[cpu] = node;
+        }
+      }
+
+      m_nodeCpus.push_back(std::move(cpus));
+    }
+
+    if (m_nodeCpus.empty()) {
+      m_nodeCpus.resize(1U);
+    }
+  }
+
+  void Bind(std::uint32_t node) const {
+    ::cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (const auto cpu : m_nodeCpus[node % m_nodeCpus.size()]) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpuSet);
+      }
+    }
+
+    // The thread runs unbound if the affinity cannot be set, in which case
+    // the memory is placed where the thread happens to run.
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet);
+  }
+
+  // The node of each CPU, indexed by the CPU number.
+  std::vector<std::uint32_t> m_cpuNodes;
+#else
+  void Load() { m_nodeCpus.resize(1U); }
+
+  void Bind(std::uint32_t) const {}
+#endif
+
+  // The CPUs of each node, indexed by the node number. Only the size is used
+  // on Windows.
+  std::vector<std::vector<std::uint32_t>> m_nodeCpus;
+};
+
+}  // namespace Utils
+}  // namespace L4
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace L4 {
+namespace Utils {
+
+// Runs func(threadIndex) for each threadIndex in [0, numThreads) in parallel,
+// where threadIndex 0 runs on the calling thread, and waits for all of them to
+// finish. If any of them throws, the first exception is rethrown after all the
+// threads finish.
+template <typename Func>
+void RunInParallel(std::uint16_t numThreads, const Func& func) {
+  std::exception_ptr exception;
+  std::mutex exceptionMutex;
+
+  auto run = [&func, &exception, &exceptionMutex](std::uint16_t threadIndex) {
+    try {
+      func(threadIndex);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock{exceptionMutex};
+      if (!exception) {
+        exception = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::uint16_t i = 1U; i < numThreads; ++i) {
+    threads.emplace_back(run, i);
+  }
+
+  run(0U);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+}  // namespace Utils
+}  // namespace L4
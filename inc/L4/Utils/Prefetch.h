@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+namespace L4 {
+namespace Utils {
+
+constexpr std::size_t c_cacheLineSize = 64U;
+
+// Issues a hint to the CPU to bring the cache line containing the given
+// address into the cache. Note that prefetching an invalid address (including
+// nullptr) is safe and is simply ignored.
+inline void Prefetch(const void* address) {
+#if defined(_MSC_VER)
+  _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+  __builtin_prefetch(address, 0, 3);
+#endif
+}
+
+// Prefetches all the cache lines covering [address, address + size).
+inline void Prefetch(const void* address, std::size_t size) {
+  const auto* start = static_cast<const std::uint8_t*>(address);
+  const auto* end = start + size;
+
+  for (auto* current = start; current < end; current += c_cacheLineSize) {
+    Prefetch(current);
+  }
+
+  // The last byte can sit on one more cache line if the address is not aligned.
+  Prefetch(end - 1);
+}
+
+}  // namespace Utils
+}  // namespace L4
@@ -22,7 +22,7 @@ class RunningThread {
   RunningThread(std::chrono::milliseconds interval,
                 CoreFunc coreFunc,
                 PrepFunc prepFunc = PrepFunc())
-      : m_isRunning(),
+      : m_isRunning(true),
         m_thread(&RunningThread::Start, this, interval, coreFunc, prepFunc) {}
 
   ~RunningThread() {
@@ -40,8 +40,6 @@ class RunningThread {
   void Start(std::chrono::milliseconds interval,
              CoreFunc coreFunc,
              PrepFunc prepFunc) {
-    m_isRunning.store(true);
-
     prepFunc();
 
     while (m_isRunning.load()) {
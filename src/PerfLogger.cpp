@@ -18,4 +18,16 @@ void PerfData::AddHashTablePerfData(const char* hashTableName,
   }
 }
 
+void PerfData::AddHashTableStats(const char* hashTableName,
+                                 const HashTableStats& stats) {
+  auto result = m_hashTablesStats.insert(
+      std::make_pair(hashTableName, HashTablesStats::mapped_type(stats)));
+
+  if (!result.second) {
+    boost::format err("Duplicate hash table name found: '%1%'.");
+    err % hashTableName;
+    throw RuntimeException(err.str());
+  }
+}
+
 }  // namespace L4
\ No newline at end of file